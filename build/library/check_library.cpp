@@ -0,0 +1,98 @@
+#include "SPLand.h"
+#include <iostream>
+
+using namespace std;
+
+static bool fail(const string &message) {
+    cerr << "check_library: " << message << endl;
+    return false;
+}
+
+static void addPlans(SPLand &spland) {
+    spland.addSettlement("KfarSPL", SettlementType::VILLAGE);
+    spland.addSettlement("KiryatSPL", SettlementType::METROPOLIS);
+    spland.addFacility("hospital", FacilityCategory::LIFE_QUALITY, 5, 5, 3, 2);
+    spland.addFacility("factory", FacilityCategory::ECONOMY, 4, 1, 5, 0);
+    spland.addFacility("solarfarm", FacilityCategory::ENVIRONMENT, 3, 0, 2, 6);
+    spland.addFacility("park", FacilityCategory::ENVIRONMENT, 2, 2, 0, 4);
+    spland.addPlan("KfarSPL", PolicyKind::ECONOMY);
+    spland.addPlan("KiryatSPL", PolicyKind::NAIVE);
+    spland.addPlan("KiryatSPL", PolicyKind::BALANCED);
+}
+
+static bool samePlans(SPLand &memory, SPLand &spilled) {
+    if (memory.getNumOfPlans() != spilled.getNumOfPlans())
+    {
+        return fail("the number of plans differs");
+    }
+    for (int planId = 0; planId < memory.getNumOfPlans(); planId++)
+    {
+        PlanScores expected, actual;
+        vector<FacilityInfo> expectedFacilities, actualFacilities;
+        if (!memory.getPlanScores(planId, expected) || !spilled.getPlanScores(planId, actual) ||
+            !memory.getPlanFacilities(planId, expectedFacilities) || !spilled.getPlanFacilities(planId, actualFacilities))
+        {
+            return fail("plan " + to_string(planId) + " cannot be read");
+        }
+        if (expected.lifeQualityScore != actual.lifeQualityScore || expected.economyScore != actual.economyScore ||
+            expected.environmentScore != actual.environmentScore || expected.status != actual.status)
+        {
+            return fail("the scores of plan " + to_string(planId) + " differ");
+        }
+        if (expectedFacilities.size() != actualFacilities.size())
+        {
+            return fail("the facilities of plan " + to_string(planId) + " differ");
+        }
+        for (size_t i = 0; i < expectedFacilities.size(); i++)
+        {
+            if (expectedFacilities[i].type->getName() != actualFacilities[i].type->getName() ||
+                expectedFacilities[i].status != actualFacilities[i].status || expectedFacilities[i].timeLeft != actualFacilities[i].timeLeft)
+            {
+                return fail("the facilities of plan " + to_string(planId) + " differ");
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    const string path = argc > 1 ? argv[1] : "plans.rec";
+    SPLand memory, spilled;
+    addPlans(memory);
+    addPlans(spilled);
+    memory.step(2);
+    spilled.step(2);
+    if (!spilled.spill(path))
+    {
+        fail("cannot spill to " + path);
+        return 1;
+    }
+    memory.step(3);
+    spilled.step(3);
+    if (spilled.getSimulation().getTick() != 5)
+    {
+        fail("spilled plans were not stepped");
+        return 1;
+    }
+    if (!memory.changePolicy(0, PolicyKind::BALANCED) || !spilled.changePolicy(0, PolicyKind::BALANCED) ||
+        !memory.changePolicy(2, PolicyKind::SUSTAINABILITY) || !spilled.changePolicy(2, PolicyKind::SUSTAINABILITY) ||
+        spilled.changePolicy(3, PolicyKind::NAIVE))
+    {
+        fail("changePolicy of spilled plans");
+        return 1;
+    }
+    memory.addPlan("KfarSPL", PolicyKind::NAIVE);
+    spilled.addPlan("KfarSPL", PolicyKind::NAIVE);
+    memory.step(12);
+    spilled.step(12);
+    if (!samePlans(memory, spilled))
+    {
+        return 1;
+    }
+    if (spilled.snapshot() || spilled.restore() || !spilled.getSimulation().isSpilled())
+    {
+        fail("a spilled simulation was snapshot or restored");
+        return 1;
+    }
+    return 0;
+}
@@ -17,10 +17,12 @@ class BaseAction{
         ActionStatus getStatus() const;
         virtual void act(Simulation& simulation)=0;
         virtual const string toString() const=0;
+        virtual ActionRecord toRecord(ActionLog &actionLog) const=0;
         virtual BaseAction* clone() const = 0;
         virtual ~BaseAction() = default;
 
     protected:
+        ActionRecord makeRecord(ActionCode code) const;
         void complete();
         void error(string errorMsg);
         const string &getErrorMsg() const;
@@ -36,7 +38,9 @@ class SimulateStep : public BaseAction {
         SimulateStep(const int numOfSteps);
         void act(Simulation &simulation) override;
         const string toString() const override;
+        ActionRecord toRecord(ActionLog &actionLog) const override;
         SimulateStep *clone() const override;
+        static void actMerged(Simulation &simulation, const vector<SimulateStep*> &steps);
     private:
         const int numOfSteps;
 };
@@ -46,6 +50,7 @@ class AddPlan : public BaseAction {
         AddPlan(const string &settlementName, const string &selectionPolicy);
         void act(Simulation &simulation) override;
         const string toString() const override;
+        ActionRecord toRecord(ActionLog &actionLog) const override;
         AddPlan *clone() const override;
     private:
         const string settlementName;
@@ -59,6 +64,7 @@ class AddSettlement : public BaseAction {
         void act(Simulation &simulation) override;
         AddSettlement *clone() const override;
         const string toString() const override;
+        ActionRecord toRecord(ActionLog &actionLog) const override;
     private:
         const string settlementName;
         const SettlementType settlementType;
@@ -72,6 +78,7 @@ class AddFacility : public BaseAction {
         void act(Simulation &simulation) override;
         AddFacility *clone() const override;
         const string toString() const override;
+        ActionRecord toRecord(ActionLog &actionLog) const override;
     private:
         const string facilityName;
         const FacilityCategory facilityCategory;
@@ -88,6 +95,8 @@ class PrintPlanStatus: public BaseAction {
         void act(Simulation &simulation) override;
         PrintPlanStatus *clone() const override;
         const string toString() const override;
+        ActionRecord toRecord(ActionLog &actionLog) const override;
+        int getPlanId() const;
     private:
         const int planId;
 };
@@ -99,27 +108,64 @@ class ChangePlanPolicy : public BaseAction {
         void act(Simulation &simulation) override;
         ChangePlanPolicy *clone() const override;        
         const string toString() const override;
+        ActionRecord toRecord(ActionLog &actionLog) const override;
     private:
         const int planId;
         const string newPolicy;
 };
 
 
+//Adds a plan to every settlement ("*") or to every settlement of one type ("type=<0|1|2>")
+class AddPlans : public BaseAction {
+    public:
+        AddPlans(const string &settlements, const string &selectionPolicy);
+        static bool isSelector(const string &settlementName);
+        void act(Simulation &simulation) override;
+        AddPlans *clone() const override;
+        const string toString() const override;
+        ActionRecord toRecord(ActionLog &actionLog) const override;
+    private:
+        const string settlements;
+        const string selectionPolicy;
+};
+
+
+//Changes the policy of the plans with ids from 'from' to 'to', both included
+class ChangePlanPolicies : public BaseAction {
+    public:
+        ChangePlanPolicies(const int from, const int to, const string &newPolicy);
+        void act(Simulation &simulation) override;
+        ChangePlanPolicies *clone() const override;
+        const string toString() const override;
+        ActionRecord toRecord(ActionLog &actionLog) const override;
+    private:
+        const int from;
+        const int to;
+        const string newPolicy;
+};
+
+
 class PrintActionsLog : public BaseAction {
     public:
         PrintActionsLog();
+        PrintActionsLog(const int from, const int count);
         void act(Simulation &simulation) override;
         PrintActionsLog *clone() const override;
         const string toString() const override;
+        ActionRecord toRecord(ActionLog &actionLog) const override;
     private:
+        const int from;
+        const int count; //-1 prints every entry from 'from' on
 };
 
 class Close : public BaseAction {
     public:
+        static const size_t PARALLEL_THRESHOLD = 1 << 14; //Plans from which the report is rendered in parallel
         Close();
         void act(Simulation &simulation) override;
         Close *clone() const override;
         const string toString() const override;
+        ActionRecord toRecord(ActionLog &actionLog) const override;
     private:
 };
 
@@ -129,6 +175,7 @@ class BackupSimulation : public BaseAction {
         void act(Simulation &simulation) override;
         BackupSimulation *clone() const override;
         const string toString() const override;
+        ActionRecord toRecord(ActionLog &actionLog) const override;
     private:
 };
 
@@ -139,5 +186,160 @@ class RestoreSimulation : public BaseAction {
         void act(Simulation &simulation) override;
         RestoreSimulation *clone() const override;
         const string toString() const override;
+        ActionRecord toRecord(ActionLog &actionLog) const override;
+    private:
+};
+
+class RecordTimeSeries : public BaseAction {
+    public:
+        RecordTimeSeries(const string &path);
+        void act(Simulation &simulation) override;
+        RecordTimeSeries *clone() const override;
+        const string toString() const override;
+        ActionRecord toRecord(ActionLog &actionLog) const override;
+    private:
+        const string path; //"off" stops the recording
+};
+
+class PrintSummary : public BaseAction {
+    public:
+        PrintSummary(const string &settlementName);
+        void act(Simulation &simulation) override;
+        PrintSummary *clone() const override;
+        const string toString() const override;
+        ActionRecord toRecord(ActionLog &actionLog) const override;
+    private:
+        const string settlementName; //Empty for the summary of the whole simulation
+};
+
+class PrintLeaderboard : public BaseAction {
+    public:
+        PrintLeaderboard(const int count, const string &metric);
+        void act(Simulation &simulation) override;
+        PrintLeaderboard *clone() const override;
+        const string toString() const override;
+        ActionRecord toRecord(ActionLog &actionLog) const override;
+    private:
+        const int count;
+        const string metric;
+};
+
+class QueryPlans : public BaseAction {
+    public:
+        QueryPlans(const string &query);
+        void act(Simulation &simulation) override;
+        QueryPlans *clone() const override;
+        const string toString() const override;
+        ActionRecord toRecord(ActionLog &actionLog) const override;
+    private:
+        const string query;
+};
+
+class SpillPlans : public BaseAction {
+    public:
+        SpillPlans(const string &path);
+        void act(Simulation &simulation) override;
+        SpillPlans *clone() const override;
+        const string toString() const override;
+        ActionRecord toRecord(ActionLog &actionLog) const override;
     private:
-};
\ No newline at end of file
+        const string path;
+};
+
+//Prints the digest of a plan, or of the whole simulation if planId is negative
+class PrintDigest : public BaseAction {
+    public:
+        PrintDigest(int planId);
+        void act(Simulation &simulation) override;
+        PrintDigest *clone() const override;
+        const string toString() const override;
+        ActionRecord toRecord(ActionLog &actionLog) const override;
+    private:
+        const int planId;
+};
+
+//Writes a checkpoint to directory every numOfTicks ticks, or stops if directory is "off"
+class Autosave : public BaseAction {
+    public:
+        Autosave(int everyNumOfTicks, const string &directory);
+        void act(Simulation &simulation) override;
+        Autosave *clone() const override;
+        const string toString() const override;
+        ActionRecord toRecord(ActionLog &actionLog) const override;
+    private:
+        const int everyNumOfTicks;
+        const string directory;
+};
+
+//Steps the simulation every msPerTick milliseconds, catching up on or dropping late ticks by policy, or stops if policy is "off"
+class RunRealtime : public BaseAction {
+    public:
+        RunRealtime(int msPerTick, const string &policy);
+        void act(Simulation &simulation) override;
+        RunRealtime *clone() const override;
+        const string toString() const override;
+        ActionRecord toRecord(ActionLog &actionLog) const override;
+    private:
+        const int msPerTick;
+        const string policy; //"catchup" (the default) or "drop"
+};
+
+//Feeds the changes of every step to a FIFO, a Unix socket or a rotating file, blocking or dropping
+//when the feed falls behind by policy, or stops if output is "off"
+class FeedChanges : public BaseAction {
+    public:
+        FeedChanges(const string &output, const string &path, const string &policy);
+        void act(Simulation &simulation) override;
+        FeedChanges *clone() const override;
+        const string toString() const override;
+        ActionRecord toRecord(ActionLog &actionLog) const override;
+    private:
+        const string output; //"fifo", "socket" or "file"
+        const string path;
+        const string policy; //"block" (the default) or "drop"
+};
+
+//Sets the seed, or the distribution of construction times of a facility category: "fixed" (its
+//price), "uniform" from low to high or "triangular" from low to high peaking at mode, in percent
+//of the price. "off" builds every facility in exactly its price again.
+class SetDelays : public BaseAction {
+    public:
+        SetDelays(const string &target, const string &distribution, int low, int mode, int high);
+        void act(Simulation &simulation) override;
+        SetDelays *clone() const override;
+        const string toString() const override;
+        ActionRecord toRecord(ActionLog &actionLog) const override;
+    private:
+        const string target; //A category, "seed" or "off"
+        const string distribution;
+        const int low; //The seed for "seed"
+        const int mode;
+        const int high;
+};
+
+//Steps copies of the plans numOfSteps ahead numOfRuns times with different seeds, in parallel, and
+//prints the distribution of every plan's scores
+class RunMonteCarlo : public BaseAction {
+    public:
+        RunMonteCarlo(int numOfRuns, int numOfSteps);
+        void act(Simulation &simulation) override;
+        RunMonteCarlo *clone() const override;
+        const string toString() const override;
+        ActionRecord toRecord(ActionLog &actionLog) const override;
+    private:
+        const int numOfRuns;
+        const int numOfSteps;
+};
+
+//Starts a trace of the process, written to path when traced off, or stops it if path is "off"
+class RecordTrace : public BaseAction {
+    public:
+        RecordTrace(const string &path, const string &detail);
+        void act(Simulation &simulation) override;
+        RecordTrace *clone() const override;
+        const string toString() const override;
+        ActionRecord toRecord(ActionLog &actionLog) const override;
+    private:
+        const string path;
+        const string detail; //"plans" to trace every plan as well, empty otherwise
+};
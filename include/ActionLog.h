@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using std::string;
+using std::vector;
+
+enum class ActionStatus;
+
+enum class ActionCode : uint8_t {
+    STEP,
+    PLAN,
+    SETTLEMENT,
+    FACILITY,
+    PLAN_STATUS,
+    CHANGE_POLICY,
+    LOG,
+    CLOSE,
+    BACKUP,
+    RESTORE,
+    RECORD,
+    SUMMARY,
+    TOP,
+    QUERY,
+    SPILL,
+    CHANGE_POLICY_RANGE,
+    TRACE,
+    AUTOSAVE,
+    CHECKPOINT,
+    DIGEST,
+    REALTIME,
+    FEED,
+    DELAYS,
+    MONTE_CARLO,
+};
+
+//One entry of the action log. Names are ids of strings interned by the log, id 0 is the empty string.
+struct ActionRecord {
+    uint8_t code;       //ActionCode
+    uint8_t status;     //ActionStatus
+    int32_t values[5];  //Numbers of the action, e.g. the number of steps or the facility's price and scores.
+                        //FEED keeps its policy here, 1 for drop, 0 for block and -1 for neither.
+    uint32_t strings[2];
+};
+
+/*
+The log of every action performed on a simulation, as fixed size records in an append only arena.
+Records are kept in segments of SEGMENT_RECORDS records and strings are interned in a pool, and
+both are shared by reference: copying a log, as a backup does, copies a pointer per segment.
+The pool is the log's own rather than the process wide SymbolTable, since what is typed in a
+command, such as a query or a path, is free text that should not outlive the simulation.
+A log only ever sees the first size() records of a segment it shares, so it appends in place as
+long as nobody appended past its end, and otherwise copies the last segment first.
+*/
+class ActionLog {
+    public:
+        static const size_t SEGMENT_RECORDS = 1024;
+        ActionLog();
+        uint32_t intern(const string &text);
+        const string &getString(uint32_t id) const;
+        void append(const ActionRecord &record);
+        size_t size() const;
+        const ActionRecord &get(size_t index) const;
+        ActionStatus getStatus(size_t index) const;
+        void print(std::ostream &out, size_t index) const;
+
+    private:
+        struct Segment {
+            Segment(): size(0) {}
+            ActionRecord records[SEGMENT_RECORDS];
+            size_t size; //Records appended to the segment by any of the logs sharing it
+        };
+        struct StringPool {
+            vector<string> strings;
+            std::unordered_map<string, uint32_t> ids;
+        };
+
+        vector<std::shared_ptr<Segment>> segments;
+        std::shared_ptr<StringPool> pool;
+        size_t numOfRecords;
+};
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <string>
+using std::string;
+
+/*
+Counts the heap allocations of every thread, so commands that are meant to run without allocating
+are held to it. A command is checked against what the thread that executes it allocated, leaving
+out what the output stream allocates while an UncountedAllocations is alive.
+Counting is only compiled in when building with SPLAND_COUNT_ALLOCATIONS (make COUNT_ALLOCATIONS=1),
+which replaces the global operator new. Simulation::execute() then checks every command against
+its budget and reports the commands that went over it to cerr, and wasExceeded() tells the client
+to exit with an error. In a normal build nothing is counted and the checks cost nothing.
+*/
+class AllocationCounter {
+    public:
+        static const size_t UNLIMITED = (size_t)-1;
+        static bool isEnabled();
+        static size_t getCount();
+        static size_t getBudget(const string &command);
+        static void check(const string &command, size_t allocations);
+        static bool wasExceeded();
+};
+
+//Allocations the current thread makes while one of these is alive are not counted
+class UncountedAllocations {
+    public:
+        UncountedAllocations();
+        ~UncountedAllocations();
+};
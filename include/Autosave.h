@@ -0,0 +1,52 @@
+#pragma once
+#include <deque>
+#include <string>
+#include <sys/types.h>
+using std::string;
+
+class Simulation;
+
+/*
+Writes a checkpoint of the simulation every few ticks without stopping it.
+At a tick boundary the process forks, and the child writes its copy on write image of the
+simulation to a temporary file, renames it into place and exits, while the parent goes on with
+the next tick. Only one checkpoint is written at a time: a checkpoint that falls due while the
+previous one is still being written is skipped. The last KEEP_CHECKPOINTS checkpoints are kept,
+and checkpoints that could not be written are added to the action log as errors.
+
+Checkpoint format, one line each, in this order:
+    tick <tick>
+    settlement <name> <type>                            as in a configuration file
+    facility <name> <category> <price> <life quality> <economy> <environment>
+    plan <id> <settlement> <status> <life quality> <economy> <environment> <PolicyKind>
+         <last selected index> <policy life quality> <policy economy> <policy environment> [<custom policy name>]
+    operational <plan id> <facility name>
+    construction <plan id> <facility name> <time left>
+    log <action log entry>
+*/
+class Autosaver {
+    public:
+        static const size_t KEEP_CHECKPOINTS = 3;
+
+        Autosaver(int everyNumOfTicks, const string &directory);
+        Autosaver(const Autosaver &other) = delete;
+        Autosaver &operator=(const Autosaver &other) = delete;
+        ~Autosaver();
+        void onTick(Simulation &simulation);
+        void finish(Simulation &simulation);
+        int getInterval() const;
+        const string &getDirectory() const;
+
+        static bool write(Simulation &simulation, const string &path);
+
+    private:
+        bool reap(Simulation &simulation, bool wait);
+        void fail(Simulation &simulation, int tick, const string &path);
+
+        const int everyNumOfTicks;
+        const string directory;
+        pid_t writer; //The child writing a checkpoint, -1 if none
+        int writingTick;
+        string writingPath;
+        std::deque<string> checkpoints; //Completed checkpoints, oldest first
+};
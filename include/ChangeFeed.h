@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include "Pipeline.h"
+using std::string;
+
+class Plan;
+
+enum class ChangeEventType : uint8_t {
+    OPERATIONAL, //A facility of the plan became operational
+    BUSY,        //The plan reached its construction limit
+    AVAILABLE,   //The plan was busy and a facility became operational
+};
+
+//One event of the feed, written as is, in native byte order
+struct ChangeEvent {
+    uint32_t sequence; //Counts every event of the feed, dropped ones included
+    uint32_t tick;
+    uint32_t planId;
+    int32_t facility;  //Index of the facility's type in the FacilityCatalog
+    uint8_t type;      //ChangeEventType
+    uint8_t padding[3];
+    int32_t lifeQualityScore; //The plan's scores after the event
+    int32_t economyScore;
+    int32_t environmentScore;
+};
+
+/*
+A change data capture feed of what Plan::step() does: facilities becoming operational and plans
+flipping between AVAILABLE and BUSY, as fixed size ChangeEvents.
+The step engine emits events into a bounded SpscQueue and rings the consumer thread once per
+step. The consumer writes them in batches to a FIFO, a Unix stream socket or a file. When the
+queue is full the step engine either waits for the consumer (block) or drops the event and counts
+it (drop).
+Every connection and every file starts with a header: "SPCF" magic, uint32 version, uint32 event
+size. A FIFO is opened by the consumer once there is a reader. A file is rotated when it would
+grow past ROTATE_BYTES: <path> is renamed to <path>.1, <path>.1 to <path>.2 and so on, keeping
+KEEP_FILES files. Events that could not be written, e.g. once the reader went away, are lost.
+*/
+class ChangeFeed {
+    public:
+        static const size_t CAPACITY = 1 << 16;
+        static const size_t BATCH_EVENTS = 256;
+        static const uint64_t ROTATE_BYTES = (uint64_t)64 << 20;
+        static const int KEEP_FILES = 3;
+        static const uint32_t VERSION = 1;
+
+        ChangeFeed(const string &output, const string &path, bool dropWhenFull);
+        ChangeFeed(const ChangeFeed &other) = delete;
+        ChangeFeed &operator=(const ChangeFeed &other) = delete;
+        ~ChangeFeed();
+        bool isOpen() const;
+        void emit(ChangeEventType type, int tick, const Plan &plan, int facility);
+        void publish();
+        void close();
+        uint64_t getNumOfEvents() const;
+        uint64_t getNumOfWritten() const;
+        uint64_t getNumOfDropped() const;
+
+    private:
+        enum Output {
+            FIFO,
+            SOCKET,
+            ROTATING_FILE,
+        };
+
+        bool connect();
+        bool openFile();
+        bool rotate();
+        bool writeHeader();
+        bool writeAll(const char *data, size_t size);
+        bool write(const ChangeEvent *batch, size_t count);
+        void consume();
+
+        Output output;
+        const string path;
+        const bool dropWhenFull;
+        bool valid;
+        int fd;
+        uint64_t fileBytes;
+        uint32_t sequence;          //Written by the step engine only
+        uint64_t numOfDropped;      //Written by the step engine only
+        std::atomic<uint64_t> numOfWritten; //Written by the consumer only
+        SpscQueue<ChangeEvent> events;
+        Doorbell hasEvents;
+        Doorbell hasRoom;
+        std::atomic<bool> closing;
+        std::thread consumer;
+};
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "Simulation.h"
+using std::string;
+
+/*
+A configuration file compiled into a binary image that can be mapped into memory and loaded
+without parsing.
+
+Layout (every section starts on an 8 byte boundary):
+    ConfigImageHeader
+    name table:  uint32 offset of every name into the name data, plus one past the last name
+    name data:   the names, back to back, without terminators
+    settlements: uint32 name id, uint32 settlement type
+    facilities:  one uint32 column each for name id, category, price, life quality, economy and environment score
+    plans:       uint32 settlement index, uint32 PolicyKind, or CUSTOM + the name id of a policy
+                 known by its name (lookahead)
+The header records the size, modification time and hash of the text configuration it was built
+from, so an image whose source has changed is detected as stale.
+*/
+struct ConfigImageHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t sourcePathId;
+    uint64_t sourceSize;
+    int64_t sourceModified;
+    uint64_t sourceHash;
+    uint32_t numOfNames;
+    uint32_t numOfSettlements;
+    uint32_t numOfFacilities;
+    uint32_t numOfPlans;
+    uint64_t nameTableOffset;
+    uint64_t nameDataOffset;
+    uint64_t settlementsOffset;
+    uint64_t facilitiesOffset;
+    uint64_t plansOffset;
+    uint64_t imageSize;
+};
+
+class ConfigImage {
+    public:
+        ConfigImage();
+        ConfigImage(const ConfigImage &other) = delete;
+        ConfigImage &operator=(const ConfigImage &other) = delete;
+        ~ConfigImage();
+        static bool compile(const string &configFilePath, const string &imagePath);
+        static bool isImage(const string &path);
+        bool open(const string &imagePath);
+        bool isStale() const;
+        string getSourcePath() const;
+        void load(Simulation &simulation) const;
+
+    private:
+        bool hasSection(uint64_t offset, uint64_t length) const;
+        bool isValid() const;
+        string getName(uint32_t nameId) const;
+        const uint32_t *section(uint64_t offset) const;
+        void close();
+
+        const unsigned char *image;
+        size_t size;
+        const ConfigImageHeader *header;
+};
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "Simulation.h"
+using std::string;
+using std::vector;
+
+/*
+Reads a configuration file into a Simulation.
+The file is split at line boundaries into one chunk per thread, and every chunk is tokenized
+and parsed on its own thread into a list of ConfigRecords. The records are then applied to the
+simulation in file order on the calling thread, so duplicate settlements and facilities are
+rejected, plans may only refer to settlements defined above them, and plan ids and error
+messages come out exactly as if the file was read line by line.
+*/
+struct ConfigRecord {
+    enum Kind { SETTLEMENT, FACILITY, PLAN, ERROR_OUT, ERROR_ERR };
+    Kind kind;
+    string name;       //Settlement or facility name, or the message of an error
+    string policy;     //Selection policy of a plan
+    int values[6];     //Settlement type, or facility category, price and the three scores
+};
+
+class ConfigLoader {
+    public:
+        static const size_t MIN_CHUNK_SIZE = 1 << 20;
+        static bool load(const string &configFilePath, Simulation &simulation);
+
+    private:
+        static void parseChunk(const char *begin, const char *end, vector<ConfigRecord> &records);
+        static void parseLine(const char *begin, const char *end, vector<ConfigRecord> &records);
+        static void apply(const vector<vector<ConfigRecord>> &chunks, Simulation &simulation);
+};
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include "Facility.h"
+
+//A distribution of construction times, in percent of a facility's price. Triangular from low to
+//high with its peak at mode, or uniform from low to high if mode is negative.
+struct DelayDistribution {
+    int low;
+    int mode;
+    int high;
+};
+
+/*
+Random construction times. A facility of a category that has a distribution is built in a number
+of ticks drawn from it, at least one, instead of in exactly its price.
+Draws come from CounterRandom keyed on (seed, plan id, build ordinal), the build ordinal being the
+number of facilities the plan selected before. A plan therefore builds in the same times however
+the plans are stepped, on however many threads, and copies of the plans that only differ in the
+seed are independent samples of the same plans.
+*/
+class ConstructionDelays {
+    public:
+        static const int NUM_OF_CATEGORIES = 3;
+        static const int MAX_PERCENT = 10000;
+
+        static bool isValid(const DelayDistribution &distribution);
+        ConstructionDelays();
+        uint64_t getSeed() const;
+        void setSeed(uint64_t seed);
+        void set(FacilityCategory category, const DelayDistribution &distribution);
+        void reset(FacilityCategory category);
+        int getDuration(const FacilityType &type, int planId, uint32_t ordinal) const;
+
+    private:
+        uint64_t seed;
+        bool hasDistribution[NUM_OF_CATEGORIES];
+        DelayDistribution distributions[NUM_OF_CATEGORIES];
+};
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <string>
+using std::string;
+
+/*
+64 bit digests of simulation state, FNV-1a over 64 bit words with the high half folded back in
+after every word. Digests only depend on the values mixed in, never on addresses, so two runs or
+a run and a restored backup that reach the same state have the same digest.
+*/
+class Digest {
+    public:
+        static const uint64_t SEED = 1469598103934665603ULL;
+
+        static uint64_t mix(uint64_t digest, uint64_t value) {
+            digest = (digest ^ value) * 1099511628211ULL;
+            return digest ^ (digest >> 32);
+        }
+        static uint64_t mix(uint64_t digest, const string &text) {
+            for (unsigned char c : text)
+            {
+                digest = (digest ^ c) * 1099511628211ULL;
+            }
+            return mix(digest, (uint64_t)text.size());
+        }
+};
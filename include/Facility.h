@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <string>
 #include <vector>
 using std::string;
@@ -25,6 +26,7 @@ class FacilityType {
         FacilityType(FacilityType &&other) noexcept; // Move constructor
         FacilityType& operator=(FacilityType&& other) noexcept; // Move assignment operator
         const string &getName() const;
+        uint32_t getNameSymbol() const;
         int getCost() const;
         int getLifeQualityScore() const;
         int getEnvironmentScore() const;
@@ -32,7 +34,7 @@ class FacilityType {
         FacilityCategory getCategory() const;
 
     protected:
-        const string name;
+        const uint32_t name; //Symbol
         const FacilityCategory category;
         const int price;
         const int lifeQuality_score;
@@ -47,12 +49,15 @@ class Facility: public FacilityType {
     public:
         Facility(const string &name, const string &settlementName, const FacilityCategory category, const int price, const int lifeQuality_score, const int economy_score, const int environment_score);
         Facility(const FacilityType &type, const string &settlementName);
+        Facility(const FacilityType &type, uint32_t settlementName);
+        Facility(const FacilityType &type, uint32_t settlementName, int timeLeft);
         Facility(const Facility &other); // Copy constructor
         Facility &operator=(const Facility &other); // Assignment operator
         Facility(Facility &&other) noexcept; // Move constructor
         Facility &operator=(Facility &&other) noexcept; // Move assignment operator
         virtual ~Facility() override = default;
         const string &getSettlementName() const;
+        uint32_t getSettlementSymbol() const;
         const int getTimeLeft() const;
         FacilityStatus step();
         void setStatus(FacilityStatus status);
@@ -62,7 +67,7 @@ class Facility: public FacilityType {
         const string toString() const;
 
     private:
-        const string settlementName;
+        const uint32_t settlementName; //Symbol
         FacilityStatus status;
         int timeLeft;
 };
\ No newline at end of file
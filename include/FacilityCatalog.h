@@ -0,0 +1,92 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "ConstructionDelays.h"
+#include "Facility.h"
+using std::string;
+
+/*
+The facility types a simulation can build, as immutable versions shared by reference.
+A version is a prefix of an append only storage: add() returns a new version one facility longer,
+appending in place when the storage has room and no other version appended past this one, and
+otherwise copying into a storage twice as large, so adding is O(1) amortized and copying a version,
+as a backup does, copies a pointer. Entries never move within a storage and a version never sees
+entries past its own size, so whoever holds a version reads the same catalog however many
+facilities are added after it, from any thread.
+Names are looked up by symbol, through an open addressing hash table of positions that lives next
+to the entries and is filled in the same way.
+Simulations that load the same facilities can share one version through isSameAs(), as the
+tenants of a TenantManager loaded from one configuration do.
+Every storage gets an id of its own, never reused within the process, so two versions with the
+same storage id and size hold the same entries and a cache built from a version can tell in O(1)
+whether it is still current.
+A version also holds the ConstructionDelays its facilities are built with, null when every
+facility is built in exactly its price.
+*/
+class FacilityCatalog {
+    private:
+        struct Storage;
+
+    public:
+        static const int NOT_FOUND = -1;
+        static const size_t MIN_CAPACITY = 16;
+
+        FacilityCatalog();
+        FacilityCatalog(const FacilityCatalog &other) = default;
+        FacilityCatalog &operator=(const FacilityCatalog &other) = default;
+        size_t size() const {
+            return count;
+        }
+        bool empty() const {
+            return count == 0;
+        }
+        const FacilityType &operator[](size_t index) const {
+            return entries[index];
+        }
+        const FacilityType *data() const {
+            return entries;
+        }
+        const FacilityType *begin() const {
+            return entries;
+        }
+        const FacilityType *end() const {
+            return entries + count;
+        }
+        const ConstructionDelays *getDelays() const {
+            return delays.get();
+        }
+        //0 for the empty catalog
+        uint64_t getStorageId() const {
+            return storage != nullptr ? storage->id : 0;
+        }
+        int find(const string &name) const;
+        int find(uint32_t name) const;
+        FacilityCatalog add(const FacilityType &facility) const;
+        FacilityCatalog withDelays(std::shared_ptr<const ConstructionDelays> delays) const;
+        bool isSameAs(const FacilityCatalog &other) const;
+
+    private:
+        struct Storage {
+            explicit Storage(size_t capacity);
+            Storage(const Storage &other) = delete;
+            Storage &operator=(const Storage &other) = delete;
+            ~Storage();
+            bool claim(size_t position);
+            void construct(size_t position, const FacilityType &facility);
+
+            FacilityType *entries; //Room for 'capacity' entries, the first 'claimed' are constructed
+            const size_t capacity;
+            std::atomic<size_t> claimed; //Entries taken by any of the versions sharing the storage
+            std::unique_ptr<std::atomic<uint32_t>[]> index; //Position + 1 of each entry by name hash, 0 for empty slots
+            const size_t indexMask;
+            const uint64_t id;
+        };
+
+        std::shared_ptr<Storage> storage;
+        const FacilityType *entries; //Of 'storage', kept here to index it without going through the pointer
+        size_t count;
+        std::shared_ptr<const ConstructionDelays> delays;
+};
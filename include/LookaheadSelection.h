@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "SelectionPolicy.h"
+using std::string;
+using std::vector;
+
+enum class LookaheadObjective {
+    BALANCE,   //Smallest gap between the highest and the lowest score
+    MIN_SCORE, //Highest lowest score
+    WEIGHTED,  //Highest weighted sum of the scores
+};
+
+struct LookaheadSettings {
+    LookaheadObjective objective;
+    int depth;               //Number of selections looked ahead
+    int beamWidth;           //States kept between two selections of the search
+    int weights[3];          //Life quality, economy and environment weights of WEIGHTED
+    int timeBudgetMicros;    //Per selection, 0 for no limit
+};
+
+/*
+Selects the facility that starts the best sequence of the next 'depth' selections, judged by the
+objective on the plan's scores after the whole sequence.
+
+The search is a beam search over facilities with distinct scores. Before it starts, a greedy
+sequence sets the score to beat, and states whose upper bound (the best every remaining selection
+could add per score) cannot beat it are pruned. States reached in different orders are merged.
+With a time budget, the search stops early once it is spent, keeping the best complete sequence
+found. How far a search gets in its time depends on the machine and its load, so a budgeted policy
+may select differently from one run to the next, and only searches that finished are cached. There
+is no budget by default, which keeps runs reproducible.
+Finished searches are cached per thread, keyed on the facility options, the settings and the
+scores shifted so the lowest is 0, which is all that the objectives depend on.
+
+Written as "lookahead[:balance|min|sum[:depth[:beam width[:budget]]]]" in commands and configuration
+files, the budget in microseconds per selection.
+*/
+class LookaheadSelection: public SelectionPolicy {
+    public:
+        static const int DEFAULT_DEPTH = 3;
+        static const int DEFAULT_BEAM_WIDTH = 8;
+        static const int DEFAULT_TIME_BUDGET = 0;
+        static const int MAX_TIME_BUDGET = 1000000;
+        static const int MAX_DEPTH = 16;
+        static const int MAX_BEAM_WIDTH = 256;
+        static const size_t CACHE_CAPACITY = 1 << 16;
+        LookaheadSelection(const LookaheadSettings &settings, int lifeQualityScore, int economyScore, int environmentScore);
+        static LookaheadSelection *parse(const string &name, int lifeQualityScore = 0, int economyScore = 0, int environmentScore = 0);
+        static LookaheadSettings getDefaultSettings();
+        const LookaheadSettings &getSettings() const;
+        const FacilityType& selectFacility(const FacilityCatalog& facilitiesOptions) override;
+        const string &toString() const override;
+        uint32_t getNameSymbol() const override;
+        uint64_t mixDigest(uint64_t digest) const override;
+        LookaheadSelection *clone() const override;
+        ~LookaheadSelection() override = default;
+
+    private:
+        static string getName(const LookaheadSettings &settings);
+
+        LookaheadSettings settings;
+        string name;
+        uint32_t nameSymbol;
+        int64_t scores[3]; //Scores of the facilities selected so far, like BalancedSelection
+};
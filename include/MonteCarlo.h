@@ -0,0 +1,41 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "FacilityCatalog.h"
+#include "PlanStore.h"
+using std::vector;
+
+/*
+Runs copies of the plans a number of steps ahead, many times over, and reports the distribution of
+every plan's scores at the end.
+Run r copies the plans and the catalog with the ConstructionDelays seed plus r, so run 0 is what
+stepping the simulation itself would do. Runs are spread over the hardware threads, each thread
+taking the next run until none are left. Since construction times only depend on the seed, the
+plan and the build ordinal, the scores of a run do not depend on which thread ran it or when.
+Scores are kept per plan and run, the distributions are only computed for the report.
+*/
+class MonteCarlo {
+    public:
+        static const int MAX_RUNS = 1 << 16;
+        static const int NUM_OF_PERCENTILES = 5;
+        static const int PERCENTILES[NUM_OF_PERCENTILES];
+
+        MonteCarlo(const PlanStore &plans, const FacilityCatalog &facilities);
+        void run(int numOfRuns, int numOfSteps);
+        void print(std::ostream &out) const;
+
+    private:
+        static const int NUM_OF_SCORES = 3;
+
+        void work();
+        void runOne(int run);
+
+        const PlanStore &plans;
+        const FacilityCatalog &facilities;
+        int numOfRuns;
+        int numOfSteps;
+        std::atomic<int> nextRun;
+        vector<int32_t> scores[NUM_OF_SCORES]; //Of plan slot * numOfRuns + run
+};
@@ -0,0 +1,200 @@
+#pragma once
+#include "ActionLog.h"
+#include <sys/uio.h>
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+using std::string;
+using std::vector;
+
+class BaseAction;
+class Simulation;
+class SimulateStep;
+
+//A bounded lock free queue between one producer thread and one consumer thread. The capacity must
+//be a power of two.
+template <class T>
+class SpscQueue {
+    public:
+        explicit SpscQueue(size_t capacity): slots(capacity), mask(capacity - 1), head(0), tail(0) {}
+
+        bool tryPush(T &item) {
+            const size_t last = tail.load(std::memory_order_relaxed);
+            if (last - head.load(std::memory_order_acquire) == slots.size())
+            {
+                return false;
+            }
+            slots[last & mask] = std::move(item);
+            tail.store(last + 1, std::memory_order_release);
+            return true;
+        }
+        bool tryPop(T &item) {
+            const size_t first = head.load(std::memory_order_relaxed);
+            if (first == tail.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+            item = std::move(slots[first & mask]);
+            head.store(first + 1, std::memory_order_release);
+            return true;
+        }
+        bool isEmpty() const {
+            return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+        }
+        bool isFull() const {
+            return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire) == slots.size();
+        }
+
+    private:
+        vector<T> slots;
+        const size_t mask;
+        std::atomic<size_t> head; //Written by the consumer only
+        char padding[64];         //Keeps head and tail on separate cache lines
+        std::atomic<size_t> tail; //Written by the producer only
+};
+
+//Wakes the one thread waiting on a queue. Ringing costs a fence unless the other thread is asleep,
+//and the eventfd lets the wait be part of an epoll, see RealtimeClock.
+class Doorbell {
+    public:
+        Doorbell();
+        Doorbell(const Doorbell &other) = delete;
+        Doorbell &operator=(const Doorbell &other) = delete;
+        ~Doorbell();
+        int getFd() const;
+        void ring();
+        void prepareWait();
+        void wait();
+        void endWait();
+
+        template <class Ready>
+        void waitUntil(Ready ready) {
+            while (!ready())
+            {
+                prepareWait();
+                if (ready())
+                {
+                    endWait();
+                    return;
+                }
+                wait();
+            }
+        }
+
+    private:
+        const int fd;
+        std::atomic<bool> sleeping;
+};
+
+//A command line parsed into its action, null for unknown commands, and the label it is performed under
+struct ParsedCommand {
+    ParsedCommand();
+    ParsedCommand(BaseAction *action, const string &label);
+
+    BaseAction *action;
+    string label;
+};
+
+//The buffer of the simulation's output in the pipeline. What it allocates to grow is not counted
+//against the command that is writing.
+class OutputBuffer : public std::stringbuf {
+    protected:
+        int_type overflow(int_type c) override;
+        std::streamsize xsputn(const char *text, std::streamsize length) override;
+};
+
+//The parsing stage. Lines are read from a file descriptor rather than a stream, so that waiting for
+//input can be cut short by ringing 'stopping' and the parsing thread joined.
+struct CommandInput {
+    static const size_t CAPACITY = 1024;
+    static const size_t READ_SIZE = 1 << 16;
+    explicit CommandInput(int fd);
+    ~CommandInput();
+    bool readLine(string &line);
+
+    const int fd;
+    string buffered;   //Read but not yet returned by readLine()
+    bool atEnd;        //Nothing more to read from fd
+    SpscQueue<ParsedCommand> commands;
+    Doorbell hasCommands;
+    Doorbell hasRoom;
+    Doorbell stopping;
+    std::atomic<bool> finished; //Set by the parsing thread at the end of input
+    std::atomic<bool> stopped;  //Set when the pipeline is done with its commands
+};
+
+/*
+Runs the command loop of Simulation::start() in three stages, so that reading commands and writing
+their output never stall the simulation:
+    parsing:   a thread reads command lines from a file descriptor and parses them into actions
+    executing: the thread that called start() performs the actions in order, with the
+               simulation's output going to a buffer, and hands each command's output on
+    output:    a thread writes the output and flushes it whenever it has caught up. Standard
+               output is written with one writev of everything that was handed on since.
+The stages are connected by bounded SpscQueues, so a stage that is ahead waits for the next one
+instead of buffering without limit.
+performCoalesced() also plans the execution over the commands that are already parsed: a run of
+queued steps is stepped as one, and a planStatus of a plan whose status was printed since the
+last command that may change the plans prints the same output again without acting. The output
+and the log stay exactly what performing each command on its own would produce.
+*/
+class CommandPipeline {
+    public:
+        static const size_t OUTPUT_CAPACITY = 1024;
+        static const size_t MAX_WRITE_PARTS = 1024; //IOV_MAX on Linux
+
+        CommandPipeline(Simulation &simulation, int inputFd);
+        CommandPipeline(const CommandPipeline &other) = delete;
+        CommandPipeline &operator=(const CommandPipeline &other) = delete;
+        ~CommandPipeline();
+        bool next(ParsedCommand &command);
+        bool tryNext(ParsedCommand &command);
+        bool hasNext() const;
+        bool isFinished() const;
+        void perform(ParsedCommand &command);
+        void performCoalesced(ParsedCommand &command);
+        void flush();
+        void handOn(vector<string> &parts);
+        int getFd() const;
+        void prepareWait();
+        void endWait();
+
+    private:
+        //The output and log record of a planStatus, kept until a command may change the plans
+        struct RenderedStatus {
+            string text;
+            ActionRecord record;
+        };
+
+        bool canMergeSteps() const;
+        void performSteps(ParsedCommand &command);
+        void performStatus(ParsedCommand &command);
+        bool isRead(const string &label) const;
+        void parse();
+        void handOn(string &text);
+        void write();
+        void writeOut(const vector<string> &texts);
+
+        Simulation &simulation;
+        std::ostream &output; //The simulation's output before the pipeline took it over
+        OutputBuffer buffer;
+        std::ostream rendered;
+        CommandInput input;
+        ParsedCommand pending; //Taken from the input while looking ahead, performed next
+        bool hasPending;
+        std::unordered_map<int, RenderedStatus> statuses;
+        SpscQueue<string> outputs;
+        Doorbell hasOutputs;
+        Doorbell hasOutputRoom;
+        const int outputFd;  //Standard output, written with writev, when that is where the output goes, otherwise -1
+        vector<iovec> parts; //Of the texts being written, used by the output stage only
+        std::atomic<bool> executed; //No more output will be handed on
+        std::thread parser;
+        std::thread writer;
+};
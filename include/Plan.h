@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <vector>
 #include "Facility.h"
 #include "Settlement.h"
@@ -10,38 +11,65 @@ enum class PlanStatus {
     BUSY,
 };
 
+class Plan;
+
+//Notified by Plan::step() as the plan changes, so derived state can be kept up to date incrementally.
+//Both events are raised after the plan's scores and status have been updated.
+class PlanObserver {
+    public:
+        virtual void onFacilitySelected(const Plan &plan, const Facility &facility);
+        virtual void onFacilityOperational(const Plan &plan, const Facility &facility) = 0;
+        virtual ~PlanObserver() = default;
+};
+
 class Plan {
     public:
-        Plan(const int planId, const Settlement &settlement, SelectionPolicy *selectionPolicy, const vector<FacilityType> &facilityOptions);
+        Plan(const int planId, const Settlement &settlement, SelectionPolicy *selectionPolicy, const FacilityCatalog &facilityOptions);
+        Plan(const int planId, const Settlement &settlement, const PolicyState &policy, const FacilityCatalog &facilityOptions);
         Plan(const Plan& other);
-        Plan(const Plan& other, Settlement* set);
+        Plan(const Plan& other, const Settlement &settlement, const FacilityCatalog &facilityOptions);
         Plan& operator=(const Plan& other);
-        Plan(Plan&& other);
+        Plan(Plan&& other) noexcept;
         Plan& operator=(Plan&& other) noexcept;
         const int getlifeQualityScore() const;
         const int getEconomyScore() const;
         const int getEnvironmentScore() const;
         void setSelectionPolicy(SelectionPolicy *selectionPolicy);
-        void step();
+        void setSelectionPolicy(const PolicyState &policy);
+        void step(PlanObserver *observer = nullptr);
         void printStatus();
         const string getStatus() const;
+        PlanStatus getPlanStatus() const;
         const vector<Facility*> &getFacilities() const;
         const vector<Facility*> &getUnderConstructionFacilities() const;
+        const Settlement &getSettlement() const;
         const string& getSettlementName() const;
         const SettlementType getSettlementType() const;
-        const string getSelectionPolicyName() const;
+        const string &getSelectionPolicyName() const;
+        uint32_t getSelectionPolicySymbol() const;
+        PolicyKind getPolicyKind() const;
+        const PolicyState &getPolicyState() const;
+        const SelectionPolicy *getSelectionPolicy() const;
         void addFacility(Facility* facility);
         const string toString() const;
         const int getPlanId() const;
+        uint64_t getDigest() const;
         virtual ~Plan();
 
     private:
+        template <PolicyKind KIND> const FacilityType &selectFacility();
+        template <size_t LIMIT, PolicyKind KIND> void step(PlanObserver *observer);
+        template <size_t LIMIT> void step(PlanObserver *observer);
+        void advanceConstruction(PlanObserver *observer);
+
         int plan_id;
         const Settlement &settlement;
-        SelectionPolicy *selectionPolicy; //What happens if we change this to a reference?
+        PolicyState policy;
+        SelectionPolicy *selectionPolicy; //Only for CUSTOM policies, built in policies live in 'policy'
         PlanStatus status;
         vector<Facility*> facilities;
         vector<Facility*> underConstruction;
-        const vector<FacilityType> &facilityOptions;
+        const FacilityCatalog &facilityOptions;
         int life_quality_score, economy_score, environment_score;
+        uint64_t operationalDigest; //Rolling digest of 'facilities', one facility mixed in as it becomes operational
 };
\ No newline at end of file
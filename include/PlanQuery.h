@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "PlanStore.h"
+using std::string;
+using std::vector;
+
+enum class PlanField {
+    ID,
+    SETTLEMENT,
+    TYPE,
+    POLICY,
+    STATUS,
+    LIFE_QUALITY,
+    ECONOMY,
+    ENVIRONMENT,
+    OPERATIONAL,
+    CONSTRUCTION,
+};
+
+/*
+Column oriented copy of the state of every plan, one int32 column per PlanField, indexed by plan id.
+Settlement and policy names are stored as indexes into tables of their symbols, see SymbolTable.
+It is updated by the step engine through the PlanObserver events, so queries never touch the plans.
+*/
+class PlanColumns : public PlanObserver {
+    public:
+        static const int NUM_OF_FIELDS = 10;
+        PlanColumns();
+        void clear();
+        void rebuild(const PlanStore &plans);
+        void reserve(size_t numOfPlans, size_t numOfSettlements);
+        void addSettlement(uint32_t settlementName);
+        void addPlan(const Plan &plan);
+        void changePolicy(const Plan &plan);
+        void onFacilitySelected(const Plan &plan, const Facility &facility) override;
+        void onFacilityOperational(const Plan &plan, const Facility &facility) override;
+        size_t size() const;
+        const int32_t *getColumn(PlanField field) const;
+        int getSettlementId(const string &settlementName) const;
+        int getPolicyId(const string &policyName) const;
+        const string &getSettlementName(int settlementId) const;
+        const string &getPolicyName(int policyId) const;
+        void getNameRanks(PlanField field, vector<int32_t> &ranks) const;
+
+    private:
+        static int findId(const string &name, const std::unordered_map<uint32_t, int> &ids);
+        static int intern(uint32_t name, vector<uint32_t> &names, std::unordered_map<uint32_t, int> &ids);
+
+        vector<int32_t> columns[NUM_OF_FIELDS];
+        vector<uint32_t> settlementNames; //Symbols, in the order the settlements were first seen
+        std::unordered_map<uint32_t, int> settlementIds;
+        vector<uint32_t> policyNames;
+        std::unordered_map<uint32_t, int> policyIds;
+};
+
+/*
+query plans [where <field> <op> <value> [and ...]] [order by <field> [asc|desc]] [limit <n>]
+
+Fields: id, settlement, type, policy, status, life, eco, env, operational, construction
+Operators: = != < <= > >=, settlements and policies only take = and !=
+Types are village/city/metropolis, policies are nve/bal/eco/env, statuses are available/busy.
+An unknown settlement is an error. Settlements and policies are ordered by name.
+Each condition is a branch free scan over one column that clears the rows it rejects in a byte
+mask; large plan sets are split into ranges that are scanned on several threads.
+*/
+class PlanQuery {
+    public:
+        enum Operator { EQUAL, NOT_EQUAL, LESS, LESS_EQUAL, GREATER, GREATER_EQUAL };
+        static const size_t PARALLEL_THRESHOLD = 1 << 16;
+        PlanQuery();
+        bool parse(const string &query, const PlanColumns &columns);
+        void run(const PlanColumns &columns, vector<uint32_t> &result) const;
+        static void print(std::ostream &out, const PlanColumns &columns, uint32_t row);
+
+    private:
+        struct Condition {
+            PlanField field;
+            Operator op;
+            int32_t value;
+        };
+        void scan(const PlanColumns &columns, size_t begin, size_t end, vector<uint32_t> &rows) const;
+        static bool parseField(const string &name, PlanField &field);
+        static bool parseOperator(const string &name, Operator &op);
+        static bool parseValue(PlanField field, const string &text, const PlanColumns &columns, int32_t &value);
+
+        vector<Condition> conditions;
+        bool ordered;
+        PlanField orderField;
+        bool descending;
+        size_t limit;
+};
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Facility.h"
+#include "SelectionPolicy.h"
+#include "Settlement.h"
+using std::string;
+using std::vector;
+
+class Plan;
+
+/*
+A plan as a fixed size record of a PlanRecordFile. The record of plan i is record i of the file.
+Facilities under construction are kept as indices into the facility options. Operational
+facilities are never stepped again, so they are kept out of the record, in the history of the
+file, and the record only points to the last one.
+*/
+struct PlanRecord {
+    int32_t settlementIndex;           //Index into the simulation's settlements
+    uint8_t settlementType;            //SettlementType, which sets the construction limit
+    uint8_t status;                    //PlanStatus
+    uint8_t policyKind;                //PolicyKind, never CUSTOM
+    uint8_t numOfUnderConstruction;
+    int32_t policy[3];                 //The PolicyState: the scores of a balanced policy, the last selected index of the others
+    int32_t scores[3];                 //Life quality, economy and environment
+    int32_t underConstruction[3];      //Facility option index of every facility under construction
+    int32_t timeLeft[3];
+    int64_t lastOperational;           //History entry of the facility that became operational last, PlanRecordFile::NO_ENTRY if none
+};
+
+static_assert(sizeof(PlanRecord) == 64, "a plan record must fill one cache line");
+
+//A facility that became operational, entry i of the history of a PlanRecordFile
+struct OperationalEntry {
+    int64_t previous;                  //The entry of the plan's facility before it, PlanRecordFile::NO_ENTRY if none
+    int32_t facilityIndex;
+};
+
+/*
+Plans kept out of memory, as fixed size records in a file.
+scan() maps the file one window of WINDOW_RECORDS records at a time, asks the kernel to read the
+next window ahead while the current one is visited, and hands finished windows back (clean ones
+are dropped from the page cache, dirty ones are queued for writing), so only about two windows
+are resident however many plans there are. Single records are read and written with pread and
+pwrite, and appended records are buffered.
+The facilities of the plans that became operational are appended to a history at <path>.history,
+each entry linking back to the plan's entry before it. Entries are only ever appended, through a
+buffer, so stepping writes the history sequentially, and a plan's operational facilities are read
+back by following the links from its record.
+*/
+class PlanRecordFile {
+    public:
+        static const size_t WINDOW_RECORDS = 1 << 18; //16 MiB
+        static const size_t APPEND_BUFFER_RECORDS = 4096;
+        static const int64_t NO_ENTRY = -1;
+
+        //Visits the records of one window, first is the plan id of records[0]
+        class Visitor {
+            public:
+                virtual void visit(PlanRecord *records, size_t first, size_t count) = 0;
+                virtual ~Visitor() = default;
+        };
+
+        PlanRecordFile();
+        PlanRecordFile(const PlanRecordFile &other) = delete;
+        PlanRecordFile &operator=(const PlanRecordFile &other) = delete;
+        ~PlanRecordFile();
+        bool create(const string &path);
+        const string &getPath() const;
+        size_t size() const;
+        bool append(const PlanRecord &record);
+        bool read(size_t planId, PlanRecord &record);
+        bool write(size_t planId, const PlanRecord &record);
+        bool scan(Visitor &visitor, bool writable);
+        bool step(const FacilityCatalog &facilitiesOptions);
+        void addOperational(PlanRecord &record, int facilityIndex);
+        bool readOperational(const PlanRecord &record, vector<int32_t> &facilityIndices);
+        bool toRecord(const Plan &plan, int settlementIndex, const FacilityCatalog &facilitiesOptions, PlanRecord &record);
+
+        static PlanRecord makeRecord(int settlementIndex, SettlementType settlementType, const PolicyState &policy);
+        static PolicyState getPolicy(const PlanRecord &record);
+        static void setPolicy(PlanRecord &record, const PolicyState &policy);
+
+    private:
+        bool flush();
+        bool flushHistory();
+
+        int fd;
+        int historyFd;
+        string path;
+        size_t numOfRecords; //Including the buffered records
+        vector<PlanRecord> pending;
+        int64_t numOfEntries; //Including the buffered entries
+        vector<OperationalEntry> pendingEntries;
+        bool historyFailed; //An entry could not be written, which step() reports
+};
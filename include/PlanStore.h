@@ -0,0 +1,133 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Plan.h"
+using std::vector;
+
+/*
+The plans of a simulation, in chunks of CHUNK_PLANS plans.
+A plan is constructed in place in the last chunk and never moves, so appending does not relocate
+(move construct) the plans already there and references to a plan stay valid for as long as the
+store holds it. Iterating walks each chunk front to back, the same as walking a vector.
+Plans are looked up by id through a dense table from plan id to slot.
+*/
+class PlanStore {
+    private:
+        struct Chunk;
+
+    public:
+        static const size_t CHUNK_BITS = 10;
+        static const size_t CHUNK_PLANS = (size_t)1 << CHUNK_BITS;
+
+        template <class P>
+        class Iterator {
+            public:
+                typedef std::forward_iterator_tag iterator_category;
+                typedef P value_type;
+                typedef std::ptrdiff_t difference_type;
+                typedef P *pointer;
+                typedef P &reference;
+
+                Iterator(Chunk *const *chunks, size_t slot, size_t numOfPlans): chunks(chunks), slot(slot), numOfPlans(numOfPlans), current(nullptr) {
+                    if (slot < numOfPlans)
+                    {
+                        current = chunks[slot >> CHUNK_BITS]->at(slot & CHUNK_MASK);
+                    }
+                }
+                P &operator*() const {
+                    return *current;
+                }
+                P *operator->() const {
+                    return current;
+                }
+                //Plans of a chunk follow each other in memory, only the first plan of a chunk is looked up
+                Iterator &operator++() {
+                    slot++;
+                    if ((slot & CHUNK_MASK) != 0)
+                    {
+                        current++;
+                    }
+                    else
+                    {
+                        current = slot < numOfPlans ? chunks[slot >> CHUNK_BITS]->at(0) : nullptr;
+                    }
+                    return *this;
+                }
+                Iterator operator++(int) {
+                    Iterator previous = *this;
+                    ++*this;
+                    return previous;
+                }
+                bool operator==(const Iterator &other) const {
+                    return slot == other.slot;
+                }
+                bool operator!=(const Iterator &other) const {
+                    return slot != other.slot;
+                }
+
+            private:
+                Chunk *const *chunks;
+                size_t slot;
+                size_t numOfPlans;
+                P *current;
+        };
+        typedef Iterator<Plan> iterator;
+        typedef Iterator<const Plan> const_iterator;
+
+        PlanStore();
+        PlanStore(const PlanStore &other) = delete;
+        PlanStore &operator=(const PlanStore &other) = delete;
+        PlanStore(PlanStore &&other) noexcept;
+        PlanStore &operator=(PlanStore &&other) noexcept;
+        ~PlanStore();
+
+        template <class... Args>
+        Plan &emplace_back(Args&&... args);
+        void reserve(size_t numOfPlans);
+        void clear();
+        size_t size() const;
+        bool empty() const;
+        Plan &operator[](size_t slot);
+        const Plan &operator[](size_t slot) const;
+        Plan &back();
+        Plan *find(int planId);
+        iterator begin();
+        iterator end();
+        const_iterator begin() const;
+        const_iterator end() const;
+
+    private:
+        static const size_t CHUNK_MASK = CHUNK_PLANS - 1;
+        static const uint32_t NO_SLOT = UINT32_MAX;
+
+        struct Chunk {
+            std::aligned_storage<sizeof(Plan), alignof(Plan)>::type plans[CHUNK_PLANS];
+            Plan *at(size_t index) {
+                return reinterpret_cast<Plan*>(&plans[index]);
+            }
+        };
+
+        Plan *slotAddress(size_t slot) const;
+        void mapId(int planId, size_t slot);
+
+        vector<Chunk*> chunks;
+        size_t numOfPlans;
+        vector<uint32_t> slots; //Slot of every plan id, NO_SLOT for ids without a plan
+};
+
+template <class... Args>
+Plan &PlanStore::emplace_back(Args&&... args) {
+    if ((numOfPlans >> CHUNK_BITS) == chunks.size())
+    {
+        chunks.push_back(new Chunk);
+    }
+    Plan *plan = new (slotAddress(numOfPlans)) Plan(std::forward<Args>(args)...);
+    mapId(plan->getPlanId(), numOfPlans);
+    numOfPlans++;
+    return *plan;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+
+/*
+A counter based random number generator: a draw is a hash of its key and its counter, with no
+state carried from one draw to the next, so draws can be made in any order and on any thread and
+still come out the same. The hash absorbs the seed, the stream and the counter one after another
+through the SplitMix64 finalizer.
+*/
+class CounterRandom {
+    public:
+        static uint64_t draw(uint64_t seed, uint64_t stream, uint64_t counter) {
+            uint64_t value = mix(seed + GAMMA);
+            value = mix(value ^ (stream + GAMMA));
+            return mix(value ^ (counter + GAMMA));
+        }
+        //Uniform in [0, 1), from the top 53 bits of the draw
+        static double uniform(uint64_t seed, uint64_t stream, uint64_t counter) {
+            return (draw(seed, stream, counter) >> 11) * (1.0 / 9007199254740992.0);
+        }
+
+    private:
+        static const uint64_t GAMMA = 0x9E3779B97F4A7C15ULL;
+
+        static uint64_t mix(uint64_t value) {
+            value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+            return value ^ (value >> 31);
+        }
+};
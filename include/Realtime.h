@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+
+class CommandPipeline;
+class Simulation;
+
+/*
+Steps the simulation on a fixed wall clock cadence, from a periodic timerfd.
+Once started, the clock runs the command loop of Simulation::start(): one epoll waits on the timer
+and on the commands of the CommandPipeline, so commands run between ticks and a slow command
+delays a tick instead of a tick waiting for input. Commands and due ticks take turns.
+When ticks overrun and several fall due at once, the clock either steps once for each of them
+(catch up) or steps once and drops the others. How late every tick started is kept in a
+histogram with power of two buckets of microseconds.
+While there are no plans, ticks still fall due and count towards the lateness, but only the first
+of them steps and warns that there is nothing to simulate.
+*/
+class RealtimeClock {
+    public:
+        static const int NUM_OF_BUCKETS = 24; //The last one holds ticks late by 2^22 microseconds (4 s) or more
+
+        RealtimeClock();
+        RealtimeClock(const RealtimeClock &other) = delete;
+        RealtimeClock &operator=(const RealtimeClock &other) = delete;
+        ~RealtimeClock();
+        bool arm(int msPerTick, bool dropLateTicks);
+        void disarm();
+        bool isArmed() const;
+        void run(Simulation &simulation, CommandPipeline &pipeline);
+        void printLateness(std::ostream &out) const;
+
+    private:
+        void tick(Simulation &simulation);
+        void step(Simulation &simulation, uint64_t scheduled);
+
+        int timerFd;
+        int epollFd;
+        bool armed;
+        bool dropLateTicks;
+        bool warnedNoPlans;    //The last tick found no plans and warned about it
+        uint64_t period;       //Nanoseconds
+        uint64_t firstTick;    //CLOCK_MONOTONIC nanoseconds of tick 0
+        uint64_t numOfTicks;   //Ticks stepped or dropped so far
+        uint64_t dueTicks;     //Ticks that fell due and were not stepped yet
+        uint64_t numOfDropped;
+        uint64_t lateness[NUM_OF_BUCKETS];
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+using std::string;
+
+/*
+Formats report text into a fixed size buffer: integers are formatted by hand and strings are copied
+straight in, so no field makes a temporary string. The buffer is written to the renderer's stream,
+or appended to its string, whenever it fills up and when the renderer is flushed or destroyed.
+*/
+class ReportRenderer {
+    public:
+        static const size_t BUFFER_SIZE = 1 << 16;
+
+        explicit ReportRenderer(std::ostream &out);
+        explicit ReportRenderer(string &text);
+        ReportRenderer(const ReportRenderer &other) = delete;
+        ReportRenderer &operator=(const ReportRenderer &other) = delete;
+        ~ReportRenderer();
+        ReportRenderer &operator<<(const char *text);
+        ReportRenderer &operator<<(const string &text);
+        ReportRenderer &operator<<(char c);
+        ReportRenderer &operator<<(int64_t value);
+        ReportRenderer &operator<<(int value);
+        ReportRenderer &operator<<(size_t value);
+        void flush();
+
+    private:
+        void append(const char *text, size_t length);
+
+        std::ostream *out;
+        string *text;
+        size_t length;
+        char buffer[BUFFER_SIZE];
+};
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "PlanStore.h"
+using std::string;
+using std::vector;
+
+enum class ScoreMetric {
+    LIFE_QUALITY,
+    ECONOMY,
+    ENVIRONMENT,
+    SUM,
+};
+
+struct ScoreAggregate {
+    int numOfPlans;
+    long long lifeQualityScore;
+    long long economyScore;
+    long long environmentScore;
+};
+
+/*
+Score totals of the plans per settlement, per settlement type and per selection policy, and a
+leaderboard of the plans for every metric.
+Everything is updated as facilities turn operational, so reading a total is O(1) and reading the
+top k plans of a metric is O(k + log n). Plans are looked up by id, which is dense.
+A leaderboard is a treap whose nodes are kept by plan id in one vector, ordered by score and then
+by plan id, with priorities hashed from the plan id. Moving a plan whose score changed relinks its
+node, so stepping never allocates, and adding a plan only grows the vector.
+*/
+class Rollups : public PlanObserver {
+    public:
+        static const int NUM_OF_METRICS = 4;
+        Rollups();
+        void clear();
+        void rebuild(const PlanStore &plans);
+        void reserve(size_t numOfPlans, size_t numOfSettlements);
+        int addSettlement(uint32_t settlementName);
+        void addPlan(const Plan &plan);
+        void changePolicy(const Plan &plan);
+        void onFacilityOperational(const Plan &plan, const Facility &facility) override;
+        const ScoreAggregate &getTotal() const;
+        const ScoreAggregate *getSettlementTotal(uint32_t settlementName) const;
+        const ScoreAggregate &getTypeTotal(SettlementType type) const;
+        const vector<uint32_t> &getPolicySymbols() const;
+        const ScoreAggregate &getPolicyTotal(size_t policyIndex) const;
+        void getTop(ScoreMetric metric, size_t k, vector<std::pair<long long, int>> &top) const;
+        static bool parseMetric(const string &name, ScoreMetric &metric);
+
+    private:
+        static void add(ScoreAggregate &aggregate, long long lifeQualityScore, long long economyScore, long long environmentScore);
+        static long long getScore(ScoreMetric metric, long long lifeQualityScore, long long economyScore, long long environmentScore);
+        int getPolicyIndex(uint32_t policyName);
+
+        static const int NO_PLAN = -1;
+
+        struct LeaderboardNode {
+            long long score;
+            int left;  //Plan ids
+            int right;
+        };
+
+        LeaderboardNode &getNode(int metric, int planId);
+        const LeaderboardNode &getNode(int metric, int planId) const;
+        bool isBelow(int metric, int planId, int otherPlanId) const;
+        void insert(int metric, int planId);
+        void erase(int metric, int planId);
+        void split(int metric, int root, int planId, int &below, int &above);
+        int merge(int metric, int below, int above);
+        void collectTop(int metric, int root, size_t k, vector<std::pair<long long, int>> &top) const;
+
+        ScoreAggregate total;
+        ScoreAggregate typeTotals[3];
+        vector<ScoreAggregate> settlementTotals;
+        std::unordered_map<uint32_t, int> settlementIndex; //By symbol
+        vector<ScoreAggregate> policyTotals;
+        vector<uint32_t> policySymbols;
+        vector<int> planSettlement; //Indexed by plan id
+        vector<int> planPolicy;     //Indexed by plan id
+        int leaderboardRoots[NUM_OF_METRICS];
+        vector<LeaderboardNode> leaderboardNodes; //Of plan id * NUM_OF_METRICS + metric
+};
@@ -0,0 +1,65 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "ConfigImage.h"
+#include "Facility.h"
+#include "Plan.h"
+#include "SelectionPolicy.h"
+#include "Settlement.h"
+#include "Simulation.h"
+using std::string;
+using std::vector;
+
+struct PlanScores {
+    int planId;
+    int lifeQualityScore;
+    int economyScore;
+    int environmentScore;
+    PlanStatus status;
+};
+
+struct FacilityInfo {
+    const FacilityType *type;
+    FacilityStatus status;
+    int timeLeft;
+};
+
+/*
+Typed entry point of libspland.
+Drives a Simulation directly, without parsing commands and without writing to the console.
+Operations report failure through their return value instead of printing an error, and they
+are not recorded in the actions log (only actions parsed from text are).
+run() hands the simulation to the command loop of the console, which is all the simulation binary
+does after loading its configuration through this class.
+*/
+class SPLand {
+    public:
+        SPLand();
+        SPLand(const string &configFilePath);
+        SPLand(const SPLand &other) = delete;
+        SPLand &operator=(const SPLand &other) = delete;
+        bool loadConfig(const string &configFilePath);
+        void loadImage(const ConfigImage &image);
+        bool spill(const string &storePath);
+        void run();
+        bool addSettlement(const string &name, SettlementType type);
+        bool addFacility(const string &name, FacilityCategory category, int price, int lifeQualityScore, int economyScore, int environmentScore);
+        int addPlan(const string &settlementName, PolicyKind policy);
+        int addPlan(const string &settlementName, SelectionPolicy *policy);
+        bool changePolicy(int planId, PolicyKind policy);
+        void step(int numOfSteps);
+        int getNumOfPlans();
+        bool getPlanScores(int planId, PlanScores &scores);
+        bool getPlanFacilities(int planId, vector<FacilityInfo> &facilities);
+        bool snapshot();
+        bool restore();
+        bool startRecording(const string &path);
+        bool stopRecording();
+        Simulation &getSimulation();
+        static SelectionPolicy *createPolicy(PolicyKind policy);
+
+    private:
+        bool getRecordFacilities(int planId, vector<FacilityInfo> &facilities);
+
+        Simulation simulation;
+};
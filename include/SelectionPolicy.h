@@ -1,59 +1,147 @@
 #pragma once
+#include <algorithm>
+#include <cstdint>
 #include <vector>
 #include "Facility.h"
+#include "FacilityCatalog.h"
 using std::vector;
 
+enum class PolicyKind {
+    NAIVE,
+    BALANCED,
+    ECONOMY,
+    SUSTAINABILITY,
+    CUSTOM,
+};
+
+/*
+A built in selection policy, held by value in the Plan that uses it.
+Plan::step() is instantiated for every kind and calls select<KIND>() directly, so selecting a
+facility is neither a virtual call nor an allocation, and copying a plan copies the policy with it.
+CUSTOM plans hold a SelectionPolicy object instead and select through its virtual interface.
+*/
+struct PolicyState {
+    PolicyState();
+    explicit PolicyState(PolicyKind kind, int lifeQualityScore = 0, int economyScore = 0, int environmentScore = 0);
+    template <PolicyKind KIND>
+    const FacilityType &select(const FacilityCatalog &facilitiesOptions);
+    const FacilityType &selectNext(FacilityCategory category, const FacilityCatalog &facilitiesOptions);
+    static bool parse(const string &name, PolicyKind &kind);
+    static const string &getName(PolicyKind kind);
+    static uint32_t getSymbol(PolicyKind kind);
+
+    PolicyKind kind;
+    int lastSelectedIndex; //Naive, economy and sustainability
+    int lifeQualityScore;  //Balanced, the scores of the facilities selected so far
+    int economyScore;
+    int environmentScore;
+};
+
 class SelectionPolicy {
     public:
-        virtual const FacilityType& selectFacility(const vector<FacilityType>& facilitiesOptions) = 0;
-        virtual const string toString() const = 0;
+        virtual const FacilityType& selectFacility(const FacilityCatalog& facilitiesOptions) = 0;
+        virtual const string &toString() const = 0;
         virtual SelectionPolicy* clone() const = 0;
+        virtual bool getState(PolicyState &state) const;
+        virtual uint32_t getNameSymbol() const;
+        virtual uint64_t mixDigest(uint64_t digest) const;
         virtual ~SelectionPolicy() = default;
 };
 
 class NaiveSelection: public SelectionPolicy {
     public:
         NaiveSelection();
-        const FacilityType& selectFacility(const vector<FacilityType>& facilitiesOptions) override;
-        const string toString() const override;
+        const FacilityType& selectFacility(const FacilityCatalog& facilitiesOptions) override;
+        const string &toString() const override;
         NaiveSelection *clone() const override;
+        bool getState(PolicyState &state) const override;
         ~NaiveSelection() override = default;
     private:
-        int lastSelectedIndex;
+        PolicyState state;
 };
 
 class BalancedSelection: public SelectionPolicy {
     public:
         BalancedSelection(int LifeQualityScore, int EconomyScore, int EnvironmentScore);
-        const FacilityType& selectFacility(const vector<FacilityType>& facilitiesOptions) override;
-        const string toString() const override;
+        const FacilityType& selectFacility(const FacilityCatalog& facilitiesOptions) override;
+        const string &toString() const override;
         BalancedSelection *clone() const override;
+        bool getState(PolicyState &state) const override;
         ~BalancedSelection() override = default;
     private:
-        int LifeQualityScore;
-        int EconomyScore;
-        int EnvironmentScore;
+        PolicyState state;
 };
 
 class EconomySelection: public SelectionPolicy {
     public:
         EconomySelection();
-        const FacilityType& selectFacility(const vector<FacilityType>& facilitiesOptions) override;
-        const string toString() const override;
+        const FacilityType& selectFacility(const FacilityCatalog& facilitiesOptions) override;
+        const string &toString() const override;
         EconomySelection *clone() const override;
+        bool getState(PolicyState &state) const override;
         ~EconomySelection() override = default;
     private:
-        int lastSelectedIndex;
+        PolicyState state;
 
 };
 
 class SustainabilitySelection: public SelectionPolicy {
     public:
         SustainabilitySelection();
-        const FacilityType& selectFacility(const vector<FacilityType>& facilitiesOptions) override;
-        const string toString() const override;
+        const FacilityType& selectFacility(const FacilityCatalog& facilitiesOptions) override;
+        const string &toString() const override;
         SustainabilitySelection *clone() const override;
+        bool getState(PolicyState &state) const override;
         ~SustainabilitySelection() override = default;
     private:
-        int lastSelectedIndex;
-};
\ No newline at end of file
+        PolicyState state;
+};
+
+inline const FacilityType &PolicyState::selectNext(FacilityCategory category, const FacilityCatalog &facilitiesOptions) {
+    lastSelectedIndex = (lastSelectedIndex+1)%facilitiesOptions.size();
+    while (facilitiesOptions[lastSelectedIndex].getCategory() != category)
+    {
+        lastSelectedIndex = (lastSelectedIndex+1)%facilitiesOptions.size();
+    }
+    return facilitiesOptions[lastSelectedIndex];
+}
+
+template <>
+inline const FacilityType &PolicyState::select<PolicyKind::NAIVE>(const FacilityCatalog &facilitiesOptions) {
+    lastSelectedIndex = (lastSelectedIndex+1)%facilitiesOptions.size();
+    return facilitiesOptions[lastSelectedIndex];
+}
+
+//Selects the facility that leaves the three scores closest to each other
+template <>
+inline const FacilityType &PolicyState::select<PolicyKind::BALANCED>(const FacilityCatalog &facilitiesOptions) {
+    const FacilityType *selected = &facilitiesOptions[0];
+    int diff = 0;
+    for (size_t i = 0; i < facilitiesOptions.size(); i++)
+    {
+        const FacilityType &facility = facilitiesOptions[i];
+        const int life = lifeQualityScore + facility.getLifeQualityScore();
+        const int economy = economyScore + facility.getEconomyScore();
+        const int environment = environmentScore + facility.getEnvironmentScore();
+        const int newDiff = std::max(std::max(life, economy), environment) - std::min(std::min(life, economy), environment);
+        if (i == 0 || newDiff < diff)
+        {
+            diff = newDiff;
+            selected = &facility;
+        }
+    }
+    lifeQualityScore += selected->getLifeQualityScore();
+    economyScore += selected->getEconomyScore();
+    environmentScore += selected->getEnvironmentScore();
+    return *selected;
+}
+
+template <>
+inline const FacilityType &PolicyState::select<PolicyKind::ECONOMY>(const FacilityCatalog &facilitiesOptions) {
+    return selectNext(FacilityCategory::ECONOMY, facilitiesOptions);
+}
+
+template <>
+inline const FacilityType &PolicyState::select<PolicyKind::SUSTAINABILITY>(const FacilityCatalog &facilitiesOptions) {
+    return selectNext(FacilityCategory::ENVIRONMENT, facilitiesOptions);
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <string>
 #include <vector>
 using std::string;
@@ -19,10 +20,11 @@ class Settlement {
         Settlement(const Settlement &other);
         Settlement &operator=(const Settlement &other);
         const string &getName() const;
+        uint32_t getNameSymbol() const;
         SettlementType getType() const;
         const string toString() const;
 
         private:
-            const string name;
+            const uint32_t name; //Symbol
             SettlementType type;
 };
\ No newline at end of file
@@ -1,17 +1,34 @@
 #pragma once
+#include <cstdint>
+#include <iostream>
 #include <string>
 #include <vector>
+#include "ActionLog.h"
 #include "Facility.h"
 #include "Plan.h"
+#include "PlanQuery.h"
+#include "PlanStore.h"
+#include "Rollups.h"
 #include "Settlement.h"
+using std::ostream;
 using std::string;
 using std::vector;
 
+class Autosaver;
 class BaseAction;
+class ChangeFeed;
+class CommandPipeline;
+class ConstructionDelays;
+class PlanRecordFile;
+class RealtimeClock;
+struct PlanRecord;
 class SelectionPolicy;
+struct PolicyState;
+class TimeSeriesRecorder;
 
 class Simulation {
     public:
+        Simulation();
         Simulation(const string &configFilePath);
         Simulation(Simulation&& other);
         Simulation(Simulation& other);
@@ -19,28 +36,86 @@ class Simulation {
         Simulation& operator=(Simulation& other);
         virtual ~Simulation();
         void start();
-        void addPlan(const Settlement &settlement, SelectionPolicy *selectionPolicy);
+        void execute(const string &command);
+        static BaseAction *parse(const string &command, string &label);
+        int addPlan(const Settlement &settlement, SelectionPolicy *selectionPolicy);
+        int addPlan(const Settlement &settlement, const PolicyState &policy);
+        size_t addPlans(int settlementType, const PolicyState &policy);
+        size_t addPlans(int settlementType, const SelectionPolicy &prototype);
         void addAction(BaseAction *action);
         bool addSettlement(Settlement *settlement);
         bool addFacility(FacilityType facility);
         bool isSettlementExists(const string &settlementName);
-        Settlement* findSettlement(const string st);
+        Settlement* findSettlement(const string &st);
+        Settlement* findSettlement(uint32_t symbol);
+        Plan* findPlan(const int planID);
         bool isPlanExists(const int planID);
         Settlement &getSettlement(const string &settlementName);
         Plan &getPlan(const int planID);
-        vector<BaseAction*> &getActionsLog();
-        vector<Plan> &getPlans();
+        ActionLog &getActionsLog();
+        PlanStore &getPlans();
+        bool hasPlans() const;
+        const vector<Settlement*> &getSettlements() const;
+        const FacilityCatalog &getFacilityOptions() const;
+        bool shareFacilityOptions(const FacilityCatalog &catalog);
+        Rollups &getRollups();
+        PlanColumns &getPlanColumns();
+        void setPlanPolicy(Plan &plan, SelectionPolicy *selectionPolicy);
+        void setPlanPolicy(Plan &plan, const PolicyState &policy);
         void step();
         void close();
         void open();
+        bool isOpen() const;
+        Simulation* getBackup();
+        void setBackup(Simulation* snapshot);
+        ostream &out();
+        void setOutput(ostream &output);
+        void writeParts(vector<string> &parts);
+        int getTick() const;
+        uint64_t getDigest() const;
+        bool startRecording(const string &path);
+        bool stopRecording();
+        bool spill(const string &path);
+        bool isSpilled() const;
+        PlanRecordFile *getPlanRecords();
+        bool startAutosave(int everyNumOfTicks, const string &directory);
+        void stopAutosave();
+        Autosaver *getAutosaver();
+        bool startRealtime(int msPerTick, bool dropLateTicks);
+        void stopRealtime();
+        void setDelays(const ConstructionDelays &delays);
+        void clearDelays();
+        bool startFeed(const string &output, const string &path, bool dropWhenFull);
+        void stopFeed();
 
     private:
+        friend class CommandPipeline;
+        friend class ConfigImage;
+        friend class ConfigLoader;
         bool isRunning;
+        Simulation* backup; //Owned, never copied along with the simulation
+        ostream* output;
+        TimeSeriesRecorder* recorder; //Owned, like the backup it is not part of the copied state
+        PlanRecordFile* planRecords; //Owned, holds the plans instead of 'plans' once they are spilled, not copied
+        Autosaver* autosaver; //Owned, not copied
+        RealtimeClock* realtime; //Owned, not copied, runs the command loop once created
+        ChangeFeed* feed; //Owned, not copied
+        CommandPipeline* pipeline; //Running the simulation from start(), not owned
         int planCounter; //For assigning unique plan IDs
-        vector<BaseAction*> actionsLog;
-        vector<Plan> plans;
+        int currentTick;
+        ActionLog actionsLog; //Shared with backups, see ActionLog
+        PlanStore plans;
         vector<Settlement*> settlements;
-        vector<FacilityType> facilitiesOptions;
+        FacilityCatalog facilitiesOptions;
+        Rollups rollups; //Derived from plans, rebuilt rather than copied
+        PlanColumns planColumns; //Derived from plans, rebuilt rather than copied
+        void perform(const string &command, BaseAction *action);
+        void copyPlans(const Simulation &other);
+        void registerSettlement(const Settlement &settlement);
+        void registerPlan(const Plan &plan);
+        int addPlanRecord(int settlementIndex, const PolicyState &policy);
+        void findSettlements(int settlementType, vector<size_t> &indices) const;
+        void rebuildDerivedState();
 
 };
 
@@ -0,0 +1,53 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+/*
+The process wide table of interned names: settlement, facility and policy names. A symbol is the
+32 bit id of a name, names are compared and hashed by symbol and only resolved back to text for
+output. Symbol 0 is the empty string. Free text, such as what is typed in a command, is not
+interned, it would never be freed.
+Strings are kept in chunks of CHUNK_SYMBOLS that never move, so resolve() takes no lock and the
+reference it returns stays valid for the life of the process. Names are found through an open
+addressing hash table of symbols, which find() and intern() probe without a lock. Only adding a
+name takes the lock: the slot is filled after the string is published, and a table that fills up
+is replaced by a larger copy and kept, since a reader may still be probing it.
+*/
+class SymbolTable {
+    public:
+        static const size_t CHUNK_BITS = 12;
+        static const size_t CHUNK_SYMBOLS = (size_t)1 << CHUNK_BITS;
+        static const size_t MAX_CHUNKS = (size_t)1 << 16;
+
+        static uint32_t intern(const string &name);
+        static bool find(const string &name, uint32_t &symbol);
+        static const string &resolve(uint32_t symbol) {
+            return instance().chunks[symbol >> CHUNK_BITS].load(std::memory_order_acquire)[symbol & (CHUNK_SYMBOLS - 1)];
+        }
+
+    private:
+        struct Index {
+            explicit Index(size_t size);
+            const size_t mask;
+            std::unique_ptr<std::atomic<uint32_t>[]> slots; //Symbol + 1 by name hash, 0 for empty slots
+        };
+
+        SymbolTable();
+        static SymbolTable &instance();
+        uint32_t add(const string &name, size_t slot);
+        static size_t findSlot(const Index &index, const string &name);
+        void grow();
+
+        std::mutex mutex; //Held to add symbols
+        std::atomic<string*> chunks[MAX_CHUNKS];
+        uint32_t numOfSymbols;
+        std::atomic<Index*> index;
+        vector<std::unique_ptr<Index>> indices; //Every index there has been, the last is the current one
+};
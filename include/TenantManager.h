@@ -0,0 +1,68 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Simulation.h"
+using std::string;
+using std::vector;
+
+class Tenant {
+    public:
+        Tenant(const string &name, const string &configFilePath);
+        const string &getName() const;
+        Simulation &getSimulation();
+
+    private:
+        friend class TenantManager;
+        const string name;
+        Simulation simulation;
+        std::ostringstream output;    //Rendered output of the commands run in the current turn
+        std::deque<string> commands;  //Guarded by TenantManager::lock
+        bool scheduled;               //True while queued in the run queue or owned by a worker
+};
+
+/*
+Hosts many named simulations in one process.
+Every tenant has its own simulation (and therefore its own backup and action log) and its own
+command queue. A fixed pool of workers takes turns on the tenants in round robin order: a worker
+runs at most 'quantum' queued commands of one tenant and then puts it at the back of the run queue,
+so a busy tenant can not starve the others. Commands of a single tenant always run in order and
+never on two workers at once.
+Tenants loaded from the same configuration share one version of its facility catalog, which is
+immutable, instead of each keeping a copy. A tenant that adds a facility gets a version of its own.
+*/
+class TenantManager {
+    public:
+        TenantManager(std::ostream &sink, int numOfWorkers, int quantum);
+        TenantManager(const TenantManager &other) = delete;
+        TenantManager &operator=(const TenantManager &other) = delete;
+        ~TenantManager();
+        bool addTenant(const string &name, const string &configFilePath);
+        bool isTenantExists(const string &name);
+        bool submit(const string &name, const string &command);
+        void drain();
+        void shutdown();
+
+    private:
+        void work();
+        void publish(Tenant &tenant);
+
+        std::ostream &sink;
+        const int quantum;
+        bool stopping;
+        int pending; //Commands submitted but not executed yet
+        std::mutex lock;
+        std::mutex sinkLock;
+        std::condition_variable hasWork;
+        std::condition_variable idle;
+        std::map<string, std::unique_ptr<Tenant>> tenants;
+        std::map<string, FacilityCatalog> catalogs; //By configuration path, shared by the tenants loaded from it
+        std::deque<Tenant*> runQueue;
+        vector<std::thread> workers;
+};
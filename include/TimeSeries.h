@@ -0,0 +1,103 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+using std::string;
+using std::vector;
+
+class Plan;
+class PlanStore;
+
+/*
+Per step score trajectories, stored in columns.
+
+File layout:
+    header: "SPTS" magic, uint32 version
+    blocks: uint32 numOfRows, uint32 payload size, then one encoded column after another
+A column is the zigzag encoded difference of every value from the previous value in the same
+column, written as a varint. Rows of one tick are consecutive and ordered by plan id, so ticks and
+plan ids shrink to a single byte per row and scores to a byte or two. Digests do not shrink, the
+difference of two digests wraps around and takes up to ten bytes, the most any value takes.
+*/
+struct TimeSeriesRow {
+    int64_t tick;
+    int64_t planId;
+    int64_t lifeQualityScore;
+    int64_t economyScore;
+    int64_t environmentScore;
+    int64_t activeConstructions;
+    int64_t digest; //Plan::getDigest(), stored as is
+};
+
+class TimeSeriesBlock {
+    public:
+        static const int NUM_OF_COLUMNS = 7;
+        static const size_t MAX_VALUE_BYTES = 10;
+        TimeSeriesBlock();
+        void append(const TimeSeriesRow &row);
+        size_t size() const;
+        void clear();
+        void encode(vector<unsigned char> &payload) const;
+        bool decode(const vector<unsigned char> &payload, size_t numOfRows);
+        TimeSeriesRow getRow(size_t index) const;
+
+    private:
+        vector<int64_t> columns[NUM_OF_COLUMNS];
+};
+
+/*
+Appends one row per plan after every simulation step.
+Rows are collected into blocks of BLOCK_ROWS rows, and full blocks are handed to a background
+thread that encodes and writes them. At most MAX_PENDING_BLOCKS blocks wait for the writer; when
+the writer falls behind, the simulation waits for it instead of buffering more history.
+The writer checks the file after every block. Once a write failed it drops the remaining blocks,
+and record() and close() return false.
+*/
+class TimeSeriesRecorder {
+    public:
+        static const size_t BLOCK_ROWS = 4096;
+        static const size_t MAX_PENDING_BLOCKS = 8;
+        TimeSeriesRecorder(const string &path);
+        TimeSeriesRecorder(const TimeSeriesRecorder &other) = delete;
+        TimeSeriesRecorder &operator=(const TimeSeriesRecorder &other) = delete;
+        ~TimeSeriesRecorder();
+        bool isOpen() const;
+        bool record(int tick, const PlanStore &plans);
+        bool close();
+
+    private:
+        void submit();
+        void write();
+
+        std::ofstream file;
+        TimeSeriesBlock current;
+        std::deque<TimeSeriesBlock> pending;
+        vector<TimeSeriesBlock> spare; //Written blocks kept for reuse, so their columns are not reallocated
+        bool closing;
+        std::atomic<bool> failed;
+        std::mutex lock;
+        std::condition_variable hasBlocks;
+        std::condition_variable hasRoom;
+        std::thread writer;
+};
+
+class TimeSeriesReader {
+    public:
+        TimeSeriesReader(const string &path);
+        bool isOpen() const;
+        bool next(TimeSeriesRow &row);
+
+    private:
+        bool readBlock();
+
+        std::ifstream file;
+        bool valid;
+        TimeSeriesBlock block;
+        size_t position;
+};
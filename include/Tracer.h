@@ -0,0 +1,56 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+using std::string;
+
+/*
+Records spans of what the process spends its time on and writes them as Chrome trace event JSON,
+which chrome://tracing and Perfetto show as a timeline per thread.
+The tracer is process wide. Every thread appends to a buffer of its own, without locking, and the
+buffers are only read when the trace is written. The buffer of a thread that exits is reused by
+the next new thread, so worker threads that come and go do not add a buffer each. Spans are TraceSpan objects, which check a
+single relaxed atomic when the tracer is off.
+COMMANDS traces commands, actions, ticks and copies of the simulation, PLANS also traces the
+selection and construction of every plan in every tick.
+*/
+class Tracer {
+    public:
+        enum Level {
+            OFF,
+            COMMANDS,
+            PLANS,
+        };
+
+        static bool start(const string &path, Level level);
+        static bool stop();
+        static bool isEnabled(Level level) {
+            return enabledLevel.load(std::memory_order_relaxed) >= level;
+        }
+        static uint64_t now();
+        static void record(const char *name, uint64_t begin, uint64_t end, int64_t value);
+        static const char *intern(const string &name);
+
+    private:
+        static std::atomic<int> enabledLevel;
+};
+
+//Records the time from its construction to its destruction as a span, when the tracer is on at 'level'
+class TraceSpan {
+    public:
+        explicit TraceSpan(const char *name, Tracer::Level level = Tracer::COMMANDS, int64_t value = -1)
+        : name(Tracer::isEnabled(level) ? name : nullptr), value(value), begin(this->name != nullptr ? Tracer::now() : 0) {}
+        TraceSpan(const TraceSpan &other) = delete;
+        TraceSpan &operator=(const TraceSpan &other) = delete;
+        ~TraceSpan() {
+            if (name != nullptr)
+            {
+                Tracer::record(name, begin, Tracer::now(), value);
+            }
+        }
+
+    private:
+        const char *name;
+        const int64_t value; //Shown as the span's argument if not negative, e.g. the tick or the plan id
+        const uint64_t begin;
+};
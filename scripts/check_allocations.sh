@@ -0,0 +1,39 @@
+#!/bin/sh
+# Builds the simulation with allocation counting into build/allocations, runs every command that
+# has an allocation budget, with enough plans that the plan indexed vectors grow and policies that
+# are used for the first time, and fails if any command went over its budget.
+set -e
+cd "$(dirname "$0")/.."
+DIR=build/allocations
+make --no-print-directory COUNT_ALLOCATIONS=1 BUILD_DIR=$DIR LIB_DIR=$DIR/lib EXECUTABLE=$DIR/SPLand_simulation
+cat > $DIR/config.txt <<'CONFIG'
+settlement KfarSPL 0
+settlement KiryatSPL 2
+settlement Bet 1
+facility hospital 0 5 5 3 2
+facility kindergarten 0 3 4 2 1
+facility factory 1 4 1 5 0
+facility solarfarm 2 3 0 2 6
+facility park 2 2 2 0 4
+plan KfarSPL eco
+plan KiryatSPL bal
+CONFIG
+{
+    echo "settlement Neve 1"
+    for i in $(seq 1 20); do
+        for settlement in KfarSPL KiryatSPL Bet Neve; do
+            echo "plan $settlement nve"
+            echo "plan $settlement bal"
+        done
+    done
+    echo "step 3"
+    for id in 0 1 17 40 65 161; do
+        echo "planStatus $id"
+        echo "changePolicy $id env"
+        echo "changePolicy $id eco"
+    done
+    echo "step 10"
+    echo "log"
+    echo "close"
+} | $DIR/SPLand_simulation $DIR/config.txt > /dev/null
+echo "All commands kept to their allocation budgets"
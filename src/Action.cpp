@@ -1,11 +1,22 @@
 #include "Action.h" 
+#include "Autosave.h"
+#include "ConstructionDelays.h"
 #include "Auxiliary.h"
 #include "Plan.h"
 #include "Settlement.h"
 #include "SelectionPolicy.h"
 #include "Facility.h"
+#include "LookaheadSelection.h"
+#include "MonteCarlo.h"
+#include "PlanRecords.h"
+#include "Renderer.h"
 #include "Simulation.h"
+#include "SymbolTable.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <iomanip>
 #include <iostream>
+#include <thread>
 using namespace std;
 
 //----------------------------------------------------------------
@@ -18,6 +29,11 @@ ActionStatus BaseAction::getStatus() const {
     return status;
 }
 
+ActionRecord BaseAction::makeRecord(ActionCode code) const {
+    ActionRecord record = {(uint8_t)code, (uint8_t)status, {0, 0, 0, 0, 0}, {0, 0}};
+    return record;
+}
+
 void BaseAction::complete() {
     status = ActionStatus::COMPLETED;
 }
@@ -42,6 +58,11 @@ void SimulateStep::act(Simulation& simulation) {
     for (int i = 0; i < numOfSteps; i++) 
     {
         simulation.step();
+        Autosaver *autosaver = simulation.getAutosaver();
+        if (autosaver != nullptr)
+        {
+            autosaver->onTick(simulation);
+        }
     }
     complete();
 }
@@ -50,10 +71,38 @@ const string SimulateStep::toString() const {
     return "step " + to_string(numOfSteps);
 }
 
+ActionRecord SimulateStep::toRecord(ActionLog &) const {
+    ActionRecord record = makeRecord(ActionCode::STEP);
+    record.values[0] = numOfSteps;
+    return record;
+}
+
 SimulateStep* SimulateStep::clone() const {
     return new SimulateStep(numOfSteps);
 }
 
+//Acts for consecutive steps at once, stepping for all of them and completing each one
+void SimulateStep::actMerged(Simulation &simulation, const vector<SimulateStep*> &steps) {
+    long long numOfTicks = 0;
+    for (const SimulateStep *step : steps)
+    {
+        numOfTicks += max(step->numOfSteps, 0);
+    }
+    for (long long i = 0; i < numOfTicks; i++)
+    {
+        simulation.step();
+        Autosaver *autosaver = simulation.getAutosaver();
+        if (autosaver != nullptr)
+        {
+            autosaver->onTick(simulation);
+        }
+    }
+    for (SimulateStep *step : steps)
+    {
+        step->complete();
+    }
+}
+
 //----------------------------------------------------------------
 //AddPlan Class
 //----------------------------------------------------------------
@@ -61,37 +110,26 @@ SimulateStep* SimulateStep::clone() const {
 AddPlan::AddPlan(const string &settlementName, const string &selectionPolicy) :BaseAction(), settlementName(settlementName), selectionPolicy(selectionPolicy) {}
 
 void AddPlan::act(Simulation& simulation) {
-    if (!(simulation.Simulation::isSettlementExists(settlementName)))
+    const Settlement *actSet = simulation.Simulation::findSettlement(settlementName);
+    if (actSet == nullptr)
     {
         BaseAction::error("Cannot create this plan");
-        cout << "Error: " + BaseAction::getErrorMsg() << endl;
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
         return;
     } 
-    const Settlement& actSet = simulation.Simulation::getSettlement(settlementName);
-    if (selectionPolicy == "bal")
-    {
-        BalancedSelection* balancedSelection = new BalancedSelection(0,0,0);
-        simulation.Simulation::addPlan(actSet, balancedSelection);
-    }
-    else if (selectionPolicy == "nve")
-    {
-        NaiveSelection* naiveSelection = new NaiveSelection();
-        simulation.Simulation::addPlan(actSet, naiveSelection);
-    }
-    else if (selectionPolicy == "eco")
+    PolicyKind kind;
+    if (PolicyState::parse(selectionPolicy, kind))
     {
-        EconomySelection* economySelection = new EconomySelection();
-        simulation.Simulation::addPlan(actSet, economySelection);
+        simulation.Simulation::addPlan(*actSet, PolicyState(kind));
     }
-    else if (selectionPolicy == "env")
+    else if (LookaheadSelection *lookahead = LookaheadSelection::parse(selectionPolicy))
     {
-        SustainabilitySelection* sustainabilitySelection = new SustainabilitySelection();
-        simulation.Simulation::addPlan(actSet, sustainabilitySelection);
+        simulation.Simulation::addPlan(*actSet, lookahead);
     }
     else 
     {
         BaseAction::error("Cannot create this plan");
-        cout << "Error: " + BaseAction::getErrorMsg() << endl;
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
     }
     complete();
 }
@@ -100,10 +138,74 @@ const string AddPlan::toString() const {
     return "plan " + settlementName + " " + selectionPolicy;
 }
 
+ActionRecord AddPlan::toRecord(ActionLog &actionLog) const {
+    ActionRecord record = makeRecord(ActionCode::PLAN);
+    record.strings[0] = actionLog.intern(settlementName);
+    record.strings[1] = actionLog.intern(selectionPolicy);
+    return record;
+}
+
 AddPlan* AddPlan::clone() const {
     return new AddPlan(settlementName, selectionPolicy);
 }
 
+//----------------------------------------------------------------
+//AddPlans Class
+//----------------------------------------------------------------
+
+AddPlans::AddPlans(const string &settlements, const string &selectionPolicy): BaseAction(), settlements(settlements), selectionPolicy(selectionPolicy) {}
+
+bool AddPlans::isSelector(const string &settlementName) {
+    return settlementName == "*" || settlementName.compare(0, 5, "type=") == 0;
+}
+
+void AddPlans::act(Simulation& simulation) {
+    int settlementType = -1;
+    if (settlements != "*")
+    {
+        if (settlements.size() != 6 || settlements[5] < '0' || settlements[5] > '2')
+        {
+            BaseAction::error("Cannot create this plan");
+            simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+            return;
+        }
+        settlementType = settlements[5] - '0';
+    }
+    size_t added = 0;
+    PolicyKind kind;
+    if (PolicyState::parse(selectionPolicy, kind))
+    {
+        added = simulation.Simulation::addPlans(settlementType, PolicyState(kind));
+    }
+    else if (LookaheadSelection *prototype = LookaheadSelection::parse(selectionPolicy))
+    {
+        added = simulation.Simulation::addPlans(settlementType, *prototype);
+        delete prototype;
+    }
+    if (added == 0)
+    {
+        BaseAction::error("Cannot create this plan");
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+        return;
+    }
+    complete();
+}
+
+const string AddPlans::toString() const {
+    return "plan " + settlements + " " + selectionPolicy;
+}
+
+ActionRecord AddPlans::toRecord(ActionLog &actionLog) const {
+    ActionRecord record = makeRecord(ActionCode::PLAN);
+    record.strings[0] = actionLog.intern(settlements);
+    record.strings[1] = actionLog.intern(selectionPolicy);
+    return record;
+}
+
+AddPlans* AddPlans::clone() const {
+    return new AddPlans(settlements, selectionPolicy);
+}
+
 //----------------------------------------------------------------
 //AddSettlement Class
 //----------------------------------------------------------------
@@ -115,7 +217,7 @@ void AddSettlement::act(Simulation& simulation) {
     if (!(simulation.Simulation::addSettlement(toAdd)))
     {
         BaseAction::error("Settlement already exists");
-        cout << "Error: " + BaseAction::getErrorMsg() << endl;
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
         return;
     }
     complete();
@@ -142,6 +244,13 @@ const string AddSettlement::toString() const {
     return "settlement " + settlementName + " " + type;
 }
 
+ActionRecord AddSettlement::toRecord(ActionLog &actionLog) const {
+    ActionRecord record = makeRecord(ActionCode::SETTLEMENT);
+    record.strings[0] = actionLog.intern(settlementName);
+    record.values[0] = (int32_t)settlementType;
+    return record;
+}
+
 //----------------------------------------------------------------
 //AddFacility Class
 //----------------------------------------------------------------
@@ -160,7 +269,7 @@ void AddFacility::act(Simulation& simulation) {
     if (!(simulation.Simulation::addFacility(facilityType)))
     {
         BaseAction::error("Facility already exists");
-        cout << "Error: " + BaseAction::getErrorMsg() << endl;
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
         return;
     }
     complete();
@@ -187,39 +296,95 @@ const string AddFacility::toString() const {
     return "facility " + facilityName + " " + cat + " " + to_string(price) + " " + to_string(lifeQualityScore) + " " + to_string(economyScore) + " " + to_string(environmentScore);
 }
 
+ActionRecord AddFacility::toRecord(ActionLog &actionLog) const {
+    ActionRecord record = makeRecord(ActionCode::FACILITY);
+    record.strings[0] = actionLog.intern(facilityName);
+    record.values[0] = (int32_t)facilityCategory;
+    record.values[1] = price;
+    record.values[2] = lifeQualityScore;
+    record.values[3] = economyScore;
+    record.values[4] = environmentScore;
+    return record;
+}
+
 //----------------------------------------------------------------
 //PrintPlanStatus Class
 //----------------------------------------------------------------
 
 PrintPlanStatus::PrintPlanStatus (int planId) : BaseAction(), planId(const_cast<int const&>(planId)) {}
 
+//The status of a spilled plan, with its operational facilities read back from the history
+static bool printRecordStatus(Simulation &simulation, int planId) {
+    //Kept from one call to the next, so only a plan with more facilities than before allocates
+    static thread_local vector<int32_t> operational;
+    PlanRecordFile *planRecords = simulation.Simulation::getPlanRecords();
+    PlanRecord record;
+    if (!(planRecords->read(planId, record)) || !(planRecords->readOperational(record, operational)))
+    {
+        return false;
+    }
+    const FacilityCatalog &facilitiesOptions = simulation.Simulation::getFacilityOptions();
+    ReportRenderer renderer(simulation.out());
+    renderer << "Plan ID: " << planId << '\n';
+    renderer << "Settlement name: " << simulation.Simulation::getSettlements()[record.settlementIndex]->getName() << '\n';
+    renderer << "Plan status: " << (record.status == (uint8_t)PlanStatus::AVAILABLE ? "Available" : "Busy") << '\n';
+    renderer << "Selection Policy: " << PolicyState::getName((PolicyKind)record.policyKind) << '\n';
+    renderer << "Life Quality Score: " << record.scores[0] << '\n';
+    renderer << "Economy Score: " << record.scores[1] << '\n';
+    renderer << "Environmanation Score: " << record.scores[2] << '\n';
+    for (int32_t index : operational)
+    {
+        renderer << "Facility Name: " << facilitiesOptions[index].getName() << '\n';
+        renderer << "Facility Status: Operational\n";
+    }
+    for (size_t i = 0; i < record.numOfUnderConstruction; i++)
+    {
+        renderer << "Facility Name: " << facilitiesOptions[record.underConstruction[i]].getName() << '\n';
+        renderer << "Facility Status: Under Construction\n";
+    }
+    return true;
+}
+
 void PrintPlanStatus::act(Simulation& simulation) {
+    if (simulation.Simulation::isSpilled())
+    {
+        if (!printRecordStatus(simulation, planId))
+        {
+            BaseAction::error("Plan doesn't exist");
+            simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+            return;
+        }
+        complete();
+        return;
+    }
     if (!(simulation.Simulation::isPlanExists(planId))) 
     {
         BaseAction::error("Plan doesn't exist");
-        cout << "Error: " + BaseAction::getErrorMsg() << endl;
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
         return;
     }
     const Plan& plan = simulation.Simulation::getPlan(planId);
-    const vector<Facility*> facilities = plan.Plan::getFacilities();
-    const vector<Facility*> underConstructionFacilities = plan.Plan::getUnderConstructionFacilities();
-    cout << "Plan ID: " << planId << endl;
-    cout << "Settlement name: " << plan.Plan::getSettlementName() << endl;
-    cout << "Plan status: " << plan.Plan::getStatus() << endl;
-    cout << "Selection Policy: " << plan.Plan::getSelectionPolicyName() << endl;
-    cout << "Life Quality Score: " << plan.Plan::getlifeQualityScore() << endl;
-    cout << "Economy Score: " << plan.Plan::getEconomyScore() << endl;
-    cout << "Environmanation Score: " << plan.Plan::getEnvironmentScore() << endl;
+    const vector<Facility*> &facilities = plan.Plan::getFacilities();
+    const vector<Facility*> &underConstructionFacilities = plan.Plan::getUnderConstructionFacilities();
+    ReportRenderer renderer(simulation.out());
+    renderer << "Plan ID: " << planId << '\n';
+    renderer << "Settlement name: " << plan.Plan::getSettlementName() << '\n';
+    renderer << "Plan status: " << (plan.Plan::getPlanStatus() == PlanStatus::AVAILABLE ? "Available" : "Busy") << '\n';
+    renderer << "Selection Policy: " << plan.Plan::getSelectionPolicyName() << '\n';
+    renderer << "Life Quality Score: " << plan.Plan::getlifeQualityScore() << '\n';
+    renderer << "Economy Score: " << plan.Plan::getEconomyScore() << '\n';
+    renderer << "Environmanation Score: " << plan.Plan::getEnvironmentScore() << '\n';
     for (Facility* facility : facilities)
     {
-        cout << "Facility Name: " << facility->FacilityType::getName() << endl;
-        cout << "Facility Status: Operational" << endl;
+        renderer << "Facility Name: " << facility->FacilityType::getName() << '\n';
+        renderer << "Facility Status: Operational\n";
     }
     for (Facility* facility : underConstructionFacilities)
     {
-        cout << "Facility Name: " << facility->FacilityType::getName() << endl;
-        cout << "Facility Status: Under Construction" << endl;
+        renderer << "Facility Name: " << facility->FacilityType::getName() << '\n';
+        renderer << "Facility Status: Under Construction\n";
     }
+    renderer.flush();
     complete();
 }
 
@@ -227,44 +392,110 @@ PrintPlanStatus* PrintPlanStatus::clone() const {
     return new PrintPlanStatus(planId);
 }
 
+int PrintPlanStatus::getPlanId() const {
+    return planId;
+}
+
 const string PrintPlanStatus::toString() const {
     return "planStatus " + to_string(planId);
 }
 
+ActionRecord PrintPlanStatus::toRecord(ActionLog &) const {
+    ActionRecord record = makeRecord(ActionCode::PLAN_STATUS);
+    record.values[0] = planId;
+    return record;
+}
+
 //----------------------------------------------------------------
 //ChangePlanPolicy Class
 //----------------------------------------------------------------
 
 ChangePlanPolicy::ChangePlanPolicy(const int planId, const string& newPolicy) : BaseAction(), planId(planId), newPolicy(newPolicy) {}
 
+//Changes the policy of a spilled plan, which can only have a built in policy
+static bool changeRecordPolicy(Simulation &simulation, int planId, const string &newPolicy, string &errorMsg) {
+    PlanRecordFile *planRecords = simulation.Simulation::getPlanRecords();
+    PlanRecord record;
+    PolicyKind kind;
+    if (!(planRecords->read(planId, record)))
+    {
+        errorMsg = "Cannot change selection policy";
+        return false;
+    }
+    if (PolicyState::getName((PolicyKind)record.policyKind) == newPolicy)
+    {
+        errorMsg = "Selection policy is already " + newPolicy;
+        return false;
+    }
+    if (!PolicyState::parse(newPolicy, kind))
+    {
+        errorMsg = "Cannot change selection policy";
+        return false;
+    }
+    if (kind == PolicyKind::BALANCED)
+    {
+        PlanRecordFile::setPolicy(record, PolicyState(kind, record.scores[0], record.scores[1], record.scores[2]));
+    }
+    else
+    {
+        PlanRecordFile::setPolicy(record, PolicyState(kind));
+    }
+    if (!(planRecords->write(planId, record)))
+    {
+        errorMsg = "Cannot change selection policy";
+        return false;
+    }
+    return true;
+}
+
 void ChangePlanPolicy::act(Simulation& simulation) {
+    if (simulation.Simulation::isSpilled())
+    {
+        string errorMsg;
+        if (!changeRecordPolicy(simulation, planId, newPolicy, errorMsg))
+        {
+            BaseAction::error(errorMsg);
+            simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+            return;
+        }
+        complete();
+        return;
+    }
     if (!(simulation.Simulation::isPlanExists(planId)))
     {
         BaseAction::error("Cannot change selection policy");
-        cout << "Error: " + BaseAction::getErrorMsg() << endl;
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
         return;
     }
     Plan &plan = simulation.Simulation::getPlan(planId);
     if (plan.Plan::getSelectionPolicyName() == newPolicy)
     {
         BaseAction::error("Selection policy is already " + newPolicy);
-        cout << "Error: " + BaseAction::getErrorMsg() << endl;
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
         return;
     }
-    SelectionPolicy* newPolicyObj;
-    if (newPolicy == "nve")
+    PolicyKind kind;
+    if (!PolicyState::parse(newPolicy, kind))
     {
-        newPolicyObj = new NaiveSelection();
+        LookaheadSelection *lookahead = LookaheadSelection::parse(newPolicy, plan.Plan::getlifeQualityScore(), plan.Plan::getEconomyScore(), plan.Plan::getEnvironmentScore());
+        if (lookahead != nullptr)
+        {
+            simulation.Simulation::setPlanPolicy(plan, lookahead);
+            complete();
+            return;
+        }
+        BaseAction::error("Cannot change selection policy");
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+        return;
     }
-    else if (newPolicy == "eco")
+    if (kind == PolicyKind::BALANCED)
     {
-        newPolicyObj = new EconomySelection();
+        simulation.Simulation::setPlanPolicy(plan, PolicyState(kind, plan.Plan::getlifeQualityScore(), plan.Plan::getEconomyScore(), plan.Plan::getEnvironmentScore()));
     }
-    else if (newPolicy == "env")
+    else
     {
-        newPolicyObj = new SustainabilitySelection();
+        simulation.Simulation::setPlanPolicy(plan, PolicyState(kind));
     }
-    plan.Plan::setSelectionPolicy(newPolicyObj);
     complete();
 }
 
@@ -276,53 +507,216 @@ const string ChangePlanPolicy::toString() const {
     return "changePolicy " + to_string(planId) + " " + newPolicy;
 }
 
+ActionRecord ChangePlanPolicy::toRecord(ActionLog &actionLog) const {
+    ActionRecord record = makeRecord(ActionCode::CHANGE_POLICY);
+    record.values[0] = planId;
+    record.strings[0] = actionLog.intern(newPolicy);
+    return record;
+}
+
 //----------------------------------------------------------------
-//PrintActionsLog Class
+//ChangePlanPolicies Class
 //----------------------------------------------------------------
 
-PrintActionsLog::PrintActionsLog(): BaseAction() {}
+ChangePlanPolicies::ChangePlanPolicies(const int from, const int to, const string &newPolicy): BaseAction(), from(from), to(to), newPolicy(newPolicy) {}
 
-void PrintActionsLog::act(Simulation& simulation) {
-    int size = simulation.Simulation::getActionsLog().size();
-    for (int i = 0 ; i < size ; i++) 
+//Plans that do not exist or already have the policy are skipped, it is an error if no plan changed
+void ChangePlanPolicies::act(Simulation& simulation) {
+    PolicyKind kind;
+    const bool builtIn = PolicyState::parse(newPolicy, kind);
+    LookaheadSelection *prototype = builtIn ? nullptr : LookaheadSelection::parse(newPolicy);
+    size_t changed = 0;
+    if (from >= 0 && from <= to && (builtIn || prototype != nullptr))
     {
-        string status;
-        if (simulation.Simulation::getActionsLog()[i]->getStatus() == ActionStatus::COMPLETED)
+        if (simulation.Simulation::isSpilled())
         {
-            status = "COMPLETED";
+            const int last = min<long long>(to, (long long)simulation.Simulation::getPlanRecords()->size() - 1);
+            string errorMsg;
+            for (int planId = from; builtIn && planId <= last; planId++)
+            {
+                changed += changeRecordPolicy(simulation, planId, newPolicy, errorMsg);
+            }
         }
-        else if (simulation.Simulation::getActionsLog()[i]->getStatus() == ActionStatus::ERROR)
+        else
         {
-            status = "ERROR";
+            const int last = min<long long>(to, (long long)simulation.Simulation::getPlans().size() - 1);
+            for (int planId = from; planId <= last; planId++)
+            {
+                Plan *plan = simulation.Simulation::findPlan(planId);
+                if (plan == nullptr || plan->Plan::getSelectionPolicyName() == newPolicy)
+                {
+                    continue;
+                }
+                if (prototype != nullptr)
+                {
+                    simulation.Simulation::setPlanPolicy(*plan, new LookaheadSelection(prototype->getSettings(),
+                        plan->Plan::getlifeQualityScore(), plan->Plan::getEconomyScore(), plan->Plan::getEnvironmentScore()));
+                }
+                else if (kind == PolicyKind::BALANCED)
+                {
+                    simulation.Simulation::setPlanPolicy(*plan, PolicyState(kind, plan->Plan::getlifeQualityScore(), plan->Plan::getEconomyScore(), plan->Plan::getEnvironmentScore()));
+                }
+                else
+                {
+                    simulation.Simulation::setPlanPolicy(*plan, PolicyState(kind));
+                }
+                changed++;
+            }
         }
-        cout << simulation.Simulation::getActionsLog()[i]->toString() + " " + status << endl;
+    }
+    delete prototype;
+    if (changed == 0)
+    {
+        BaseAction::error("Cannot change selection policy");
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+        return;
+    }
+    complete();
+}
+
+ChangePlanPolicies* ChangePlanPolicies::clone() const {
+    return new ChangePlanPolicies(from, to, newPolicy);
+}
+
+const string ChangePlanPolicies::toString() const {
+    return "changePolicy range " + to_string(from) + " " + to_string(to) + " " + newPolicy;
+}
+
+ActionRecord ChangePlanPolicies::toRecord(ActionLog &actionLog) const {
+    ActionRecord record = makeRecord(ActionCode::CHANGE_POLICY_RANGE);
+    record.values[0] = from;
+    record.values[1] = to;
+    record.strings[0] = actionLog.intern(newPolicy);
+    return record;
+}
+
+//----------------------------------------------------------------
+//PrintActionsLog Class
+//----------------------------------------------------------------
+
+PrintActionsLog::PrintActionsLog(): BaseAction(), from(0), count(-1) {}
+
+PrintActionsLog::PrintActionsLog(const int from, const int count): BaseAction(), from(from), count(count) {}
+
+void PrintActionsLog::act(Simulation& simulation) {
+    if (from < 0 || count < -1)
+    {
+        BaseAction::error("Invalid log range");
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+        return;
+    }
+    const ActionLog &actionsLog = simulation.Simulation::getActionsLog();
+    size_t end = actionsLog.size();
+    if (count >= 0 && (size_t)from + count < end)
+    {
+        end = from + count;
+    }
+    for (size_t i = from; i < end; i++)
+    {
+        actionsLog.print(simulation.out(), i);
+        simulation.out() << endl;
     }
     complete();
 }
 
 PrintActionsLog* PrintActionsLog::clone() const {
-    return new PrintActionsLog();
+    return new PrintActionsLog(from, count);
 }
 
 const string PrintActionsLog::toString() const {
-    return "log";
+    if (count < 0)
+    {
+        return "log";
+    }
+    return "log " + to_string(from) + " " + to_string(count);
+}
+
+ActionRecord PrintActionsLog::toRecord(ActionLog &) const {
+    ActionRecord record = makeRecord(ActionCode::LOG);
+    record.values[0] = from;
+    record.values[1] = count;
+    return record;
 }
 
 //----------------------------------------------------------------
 //Close Class
 //----------------------------------------------------------------
 
+//Prints the final results of spilled plans as Close does for plans in memory
+class CloseVisitor : public PlanRecordFile::Visitor {
+    public:
+        CloseVisitor(Simulation &simulation): simulation(simulation), renderer(simulation.out()) {}
+
+        void visit(PlanRecord *records, size_t first, size_t count) override {
+            const vector<Settlement*> &settlements = simulation.Simulation::getSettlements();
+            for (size_t i = 0; i < count; i++)
+            {
+                const PlanRecord &record = records[i];
+                renderer << "PlanID: " << first + i << '\n';
+                renderer << "SettlementName: " << settlements[record.settlementIndex]->getName() << '\n';
+                renderer << "LifeQuality_Score: " << record.scores[0] << '\n';
+                renderer << "Economy_Score: " << record.scores[1] << '\n';
+                renderer << "Environment_Score: " << record.scores[2] << '\n';
+            }
+        }
+
+    private:
+        Simulation &simulation;
+        ReportRenderer renderer;
+};
+
+//Renders the final report of the plans in slots [first, last) of the store
+static void renderPlans(const PlanStore &plans, size_t first, size_t last, ReportRenderer &renderer) {
+    for (size_t slot = first; slot < last; slot++)
+    {
+        const Plan &plan = plans[slot];
+        renderer << "PlanID: " << plan.Plan::getPlanId() << '\n';
+        renderer << "SettlementName: " << plan.Plan::getSettlementName() << '\n';
+        renderer << "LifeQuality_Score: " << plan.Plan::getlifeQualityScore() << '\n';
+        renderer << "Economy_Score: " << plan.Plan::getEconomyScore() << '\n';
+        renderer << "Environment_Score: " << plan.Plan::getEnvironmentScore() << '\n';
+    }
+}
+
+static void renderPlansInto(const PlanStore &plans, size_t first, size_t last, string &text) {
+    ReportRenderer renderer(text);
+    renderPlans(plans, first, last, renderer);
+}
+
+const size_t Close::PARALLEL_THRESHOLD;
+
 Close::Close(): BaseAction() {}
 
+//Large reports are rendered by a thread per range of plans, and written out in plan order
 void Close::act(Simulation& simulation) {
-    vector<Plan> simPlans = simulation.Simulation::getPlans();
-    for (Plan& plan : simPlans)
+    if (simulation.Simulation::isSpilled())
+    {
+        CloseVisitor visitor(simulation);
+        simulation.Simulation::getPlanRecords()->scan(visitor, false);
+    }
+    const PlanStore &simPlans = simulation.Simulation::getPlans();
+    const size_t numOfPlans = simPlans.size();
+    const size_t numOfThreads = thread::hardware_concurrency();
+    if (numOfPlans < PARALLEL_THRESHOLD || numOfThreads < 2)
+    {
+        ReportRenderer renderer(simulation.out());
+        renderPlans(simPlans, 0, numOfPlans, renderer);
+    }
+    else
     {
-        cout << "PlanID: " << plan.Plan::getPlanId() << endl;
-        cout << "SettlementName: " << plan.Plan::getSettlementName() << endl;
-        cout << "LifeQuality_Score: " << plan.Plan::getlifeQualityScore() << endl;
-        cout << "Economy_Score: " << plan.Plan::getEconomyScore() << endl;
-        cout << "Environment_Score: " << plan.Plan::getEnvironmentScore() << endl;
+        vector<string> parts(numOfThreads);
+        vector<thread> workers;
+        for (size_t t = 1; t < numOfThreads; t++)
+        {
+            workers.push_back(thread(renderPlansInto, cref(simPlans), numOfPlans * t / numOfThreads,
+                numOfPlans * (t + 1) / numOfThreads, ref(parts[t])));
+        }
+        renderPlansInto(simPlans, 0, numOfPlans / numOfThreads, parts[0]);
+        for (thread &worker : workers)
+        {
+            worker.join();
+        }
+        simulation.writeParts(parts);
     }
     simulation.Simulation::close();
     complete();
@@ -336,6 +730,10 @@ const string Close::toString() const {
     return "close";
 }
 
+ActionRecord Close::toRecord(ActionLog &) const {
+    return makeRecord(ActionCode::CLOSE);
+}
+
 //----------------------------------------------------------------
 //BackupSimulation Class
 //----------------------------------------------------------------
@@ -343,12 +741,13 @@ const string Close::toString() const {
 BackupSimulation::BackupSimulation(): BaseAction() {}
 
 void BackupSimulation::act(Simulation &simulation) {
-    extern Simulation* backup;
-    if (backup != nullptr)
+    if (simulation.Simulation::isSpilled())
     {
-        delete backup;
+        BaseAction::error("Not available for spilled plans");
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+        return;
     }
-    backup = new Simulation(simulation);
+    simulation.Simulation::setBackup(new Simulation(simulation));
     complete();                                                                                 
 }
 
@@ -360,6 +759,10 @@ const string BackupSimulation::toString() const {
     return "backup";
 }
 
+ActionRecord BackupSimulation::toRecord(ActionLog &) const {
+    return makeRecord(ActionCode::BACKUP);
+}
+
 //----------------------------------------------------------------
 //RestoreSimulation Class
 //----------------------------------------------------------------
@@ -367,11 +770,11 @@ const string BackupSimulation::toString() const {
 RestoreSimulation::RestoreSimulation(): BaseAction() {}
 
 void RestoreSimulation::act(Simulation &simulation) {
-    extern Simulation* backup;
+    Simulation* backup = simulation.Simulation::getBackup();
     if (backup == nullptr)
     {
         BaseAction::error("No backup available");
-        cout << "Error: " + BaseAction::getErrorMsg() << endl;
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
         return;
     }
     simulation = *backup;
@@ -384,4 +787,589 @@ RestoreSimulation* RestoreSimulation::clone() const {
 
 const string RestoreSimulation::toString() const {
     return "restore";
-}
\ No newline at end of file
+}
+
+ActionRecord RestoreSimulation::toRecord(ActionLog &) const {
+    return makeRecord(ActionCode::RESTORE);
+}
+
+//----------------------------------------------------------------
+//RecordTimeSeries Class
+//----------------------------------------------------------------
+
+RecordTimeSeries::RecordTimeSeries(const string &path): BaseAction(), path(path) {}
+
+void RecordTimeSeries::act(Simulation &simulation) {
+    if (path == "off")
+    {
+        if (!(simulation.Simulation::stopRecording()))
+        {
+            BaseAction::error("Cannot write the time series");
+            simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+            return;
+        }
+        complete();
+        return;
+    }
+    if (simulation.Simulation::isSpilled())
+    {
+        BaseAction::error("Not available for spilled plans");
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+        return;
+    }
+    if (path.empty() || !(simulation.Simulation::startRecording(path)))
+    {
+        BaseAction::error("Cannot record to " + path);
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+        return;
+    }
+    complete();
+}
+
+RecordTimeSeries* RecordTimeSeries::clone() const {
+    return new RecordTimeSeries(path);
+}
+
+const string RecordTimeSeries::toString() const {
+    return "record " + path;
+}
+
+ActionRecord RecordTimeSeries::toRecord(ActionLog &actionLog) const {
+    ActionRecord record = makeRecord(ActionCode::RECORD);
+    record.strings[0] = actionLog.intern(path);
+    return record;
+}
+
+//----------------------------------------------------------------
+//PrintSummary Class
+//----------------------------------------------------------------
+
+static void printAggregate(ostream &out, const string &label, const ScoreAggregate &aggregate) {
+    const double count = aggregate.numOfPlans > 0 ? aggregate.numOfPlans : 1;
+    const ios::fmtflags flags = out.flags();
+    const streamsize precision = out.precision();
+    out << fixed << setprecision(2);
+    out << label << ": Plans: " << aggregate.numOfPlans
+        << ", LifeQuality_Score: " << aggregate.lifeQualityScore << " (mean " << aggregate.lifeQualityScore / count << ")"
+        << ", Economy_Score: " << aggregate.economyScore << " (mean " << aggregate.economyScore / count << ")"
+        << ", Environment_Score: " << aggregate.environmentScore << " (mean " << aggregate.environmentScore / count << ")" << endl;
+    out.flags(flags);
+    out.precision(precision);
+}
+
+PrintSummary::PrintSummary(const string &settlementName): BaseAction(), settlementName(settlementName) {}
+
+void PrintSummary::act(Simulation &simulation) {
+    if (simulation.Simulation::isSpilled())
+    {
+        BaseAction::error("Not available for spilled plans");
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+        return;
+    }
+    const Rollups &rollups = simulation.Simulation::getRollups();
+    if (!settlementName.empty())
+    {
+        const Settlement *settlement = simulation.Simulation::findSettlement(settlementName);
+        if (settlement == nullptr)
+        {
+            BaseAction::error("Settlement doesn't exist");
+            simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+            return;
+        }
+        const ScoreAggregate *settlementTotal = rollups.getSettlementTotal(settlement->getNameSymbol());
+        const ScoreAggregate noPlans = {0, 0, 0, 0};
+        printAggregate(simulation.out(), settlementName, settlementTotal != nullptr ? *settlementTotal : noPlans);
+        complete();
+        return;
+    }
+    printAggregate(simulation.out(), "Total", rollups.getTotal());
+    printAggregate(simulation.out(), "Village", rollups.getTypeTotal(SettlementType::VILLAGE));
+    printAggregate(simulation.out(), "City", rollups.getTypeTotal(SettlementType::CITY));
+    printAggregate(simulation.out(), "Metropolis", rollups.getTypeTotal(SettlementType::METROPOLIS));
+    const vector<uint32_t> &policies = rollups.getPolicySymbols();
+    for (size_t i = 0; i < policies.size(); i++)
+    {
+        printAggregate(simulation.out(), SymbolTable::resolve(policies[i]), rollups.getPolicyTotal(i));
+    }
+    complete();
+}
+
+PrintSummary* PrintSummary::clone() const {
+    return new PrintSummary(settlementName);
+}
+
+const string PrintSummary::toString() const {
+    if (settlementName.empty())
+    {
+        return "summary";
+    }
+    return "summary " + settlementName;
+}
+
+ActionRecord PrintSummary::toRecord(ActionLog &actionLog) const {
+    ActionRecord record = makeRecord(ActionCode::SUMMARY);
+    record.strings[0] = actionLog.intern(settlementName);
+    return record;
+}
+
+//----------------------------------------------------------------
+//PrintLeaderboard Class
+//----------------------------------------------------------------
+
+PrintLeaderboard::PrintLeaderboard(const int count, const string &metric): BaseAction(), count(count), metric(metric) {}
+
+void PrintLeaderboard::act(Simulation &simulation) {
+    if (simulation.Simulation::isSpilled())
+    {
+        BaseAction::error("Not available for spilled plans");
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+        return;
+    }
+    ScoreMetric scoreMetric;
+    if (count < 0 || !Rollups::parseMetric(metric, scoreMetric))
+    {
+        BaseAction::error("Cannot print leaderboard");
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+        return;
+    }
+    vector<pair<long long, int>> top;
+    simulation.Simulation::getRollups().getTop(scoreMetric, count, top);
+    for (size_t i = 0; i < top.size(); i++)
+    {
+        const Plan &plan = simulation.Simulation::getPlan(top[i].second);
+        simulation.out() << i + 1 << ". PlanID: " << top[i].second << ", SettlementName: " << plan.Plan::getSettlementName()
+                         << ", Score: " << top[i].first << endl;
+    }
+    complete();
+}
+
+PrintLeaderboard* PrintLeaderboard::clone() const {
+    return new PrintLeaderboard(count, metric);
+}
+
+const string PrintLeaderboard::toString() const {
+    return "top " + to_string(count) + " " + metric;
+}
+
+ActionRecord PrintLeaderboard::toRecord(ActionLog &actionLog) const {
+    ActionRecord record = makeRecord(ActionCode::TOP);
+    record.values[0] = count;
+    record.strings[0] = actionLog.intern(metric);
+    return record;
+}
+
+//----------------------------------------------------------------
+//QueryPlans Class
+//----------------------------------------------------------------
+
+QueryPlans::QueryPlans(const string &query): BaseAction(), query(query) {}
+
+void QueryPlans::act(Simulation &simulation) {
+    if (simulation.Simulation::isSpilled())
+    {
+        BaseAction::error("Not available for spilled plans");
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+        return;
+    }
+    const PlanColumns &columns = simulation.Simulation::getPlanColumns();
+    PlanQuery planQuery;
+    if (!planQuery.parse(query, columns))
+    {
+        BaseAction::error("Invalid query");
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+        return;
+    }
+    vector<uint32_t> rows;
+    planQuery.run(columns, rows);
+    for (uint32_t row : rows)
+    {
+        PlanQuery::print(simulation.out(), columns, row);
+    }
+    complete();
+}
+
+QueryPlans* QueryPlans::clone() const {
+    return new QueryPlans(query);
+}
+
+const string QueryPlans::toString() const {
+    return "query " + query;
+}
+
+ActionRecord QueryPlans::toRecord(ActionLog &actionLog) const {
+    ActionRecord record = makeRecord(ActionCode::QUERY);
+    record.strings[0] = actionLog.intern(query);
+    return record;
+}
+
+//----------------------------------------------------------------
+//SpillPlans Class
+//----------------------------------------------------------------
+
+SpillPlans::SpillPlans(const string &path): BaseAction(), path(path) {}
+
+void SpillPlans::act(Simulation &simulation) {
+    if (path.empty() || !(simulation.Simulation::spill(path)))
+    {
+        BaseAction::error("Cannot spill plans to " + path);
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+        return;
+    }
+    complete();
+}
+
+SpillPlans* SpillPlans::clone() const {
+    return new SpillPlans(path);
+}
+
+const string SpillPlans::toString() const {
+    return "spill " + path;
+}
+
+ActionRecord SpillPlans::toRecord(ActionLog &actionLog) const {
+    ActionRecord record = makeRecord(ActionCode::SPILL);
+    record.strings[0] = actionLog.intern(path);
+    return record;
+}
+
+//----------------------------------------------------------------
+//PrintDigest Class
+//----------------------------------------------------------------
+
+PrintDigest::PrintDigest(int planId): BaseAction(), planId(planId) {}
+
+void PrintDigest::act(Simulation &simulation) {
+    if (simulation.Simulation::isSpilled())
+    {
+        BaseAction::error("Not available for spilled plans");
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+        return;
+    }
+    if (planId < 0)
+    {
+        simulation.out() << "Digest: " << hex << setw(16) << setfill('0') << simulation.Simulation::getDigest() << dec << setfill(' ') << endl;
+        complete();
+        return;
+    }
+    if (!(simulation.Simulation::isPlanExists(planId)))
+    {
+        BaseAction::error("Plan doesn't exist");
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+        return;
+    }
+    const uint64_t digest = simulation.Simulation::getPlan(planId).getDigest();
+    simulation.out() << "Plan " << planId << " digest: " << hex << setw(16) << setfill('0') << digest << dec << setfill(' ') << endl;
+    complete();
+}
+
+PrintDigest* PrintDigest::clone() const {
+    return new PrintDigest(planId);
+}
+
+const string PrintDigest::toString() const {
+    return planId < 0 ? "digest" : "digest " + to_string(planId);
+}
+
+ActionRecord PrintDigest::toRecord(ActionLog &) const {
+    ActionRecord record = makeRecord(ActionCode::DIGEST);
+    record.values[0] = planId;
+    return record;
+}
+
+//----------------------------------------------------------------
+//Autosave Class
+//----------------------------------------------------------------
+
+Autosave::Autosave(int everyNumOfTicks, const string &directory): BaseAction(), everyNumOfTicks(everyNumOfTicks), directory(directory) {}
+
+void Autosave::act(Simulation &simulation) {
+    if (directory == "off")
+    {
+        simulation.Simulation::stopAutosave();
+        complete();
+        return;
+    }
+    if (simulation.Simulation::isSpilled())
+    {
+        BaseAction::error("Not available for spilled plans");
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+        return;
+    }
+    if (directory.empty() || !(simulation.Simulation::startAutosave(everyNumOfTicks, directory)))
+    {
+        BaseAction::error("Cannot autosave to " + directory);
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+        return;
+    }
+    complete();
+}
+
+Autosave* Autosave::clone() const {
+    return new Autosave(everyNumOfTicks, directory);
+}
+
+const string Autosave::toString() const {
+    return directory == "off" ? "autosave off" : "autosave " + to_string(everyNumOfTicks) + " " + directory;
+}
+
+ActionRecord Autosave::toRecord(ActionLog &actionLog) const {
+    ActionRecord record = makeRecord(ActionCode::AUTOSAVE);
+    record.values[0] = everyNumOfTicks;
+    record.strings[0] = actionLog.intern(directory);
+    return record;
+}
+
+//----------------------------------------------------------------
+//RunRealtime Class
+//----------------------------------------------------------------
+
+RunRealtime::RunRealtime(int msPerTick, const string &policy): BaseAction(), msPerTick(msPerTick), policy(policy.empty() ? "catchup" : policy) {}
+
+void RunRealtime::act(Simulation &simulation) {
+    if (policy == "off")
+    {
+        simulation.Simulation::stopRealtime();
+        complete();
+        return;
+    }
+    if (!(policy == "catchup" || policy == "drop") || !(simulation.Simulation::startRealtime(msPerTick, policy == "drop")))
+    {
+        BaseAction::error("Cannot run in real time");
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+        return;
+    }
+    complete();
+}
+
+RunRealtime* RunRealtime::clone() const {
+    return new RunRealtime(msPerTick, policy);
+}
+
+const string RunRealtime::toString() const {
+    return policy == "off" ? "realtime off" : "realtime " + to_string(msPerTick) + " " + policy;
+}
+
+ActionRecord RunRealtime::toRecord(ActionLog &actionLog) const {
+    ActionRecord record = makeRecord(ActionCode::REALTIME);
+    record.values[0] = msPerTick;
+    record.strings[0] = actionLog.intern(policy);
+    return record;
+}
+
+//----------------------------------------------------------------
+//FeedChanges Class
+//----------------------------------------------------------------
+
+FeedChanges::FeedChanges(const string &output, const string &path, const string &policy): BaseAction(), output(output), path(path), policy(policy.empty() ? "block" : policy) {}
+
+void FeedChanges::act(Simulation &simulation) {
+    if (output == "off")
+    {
+        simulation.Simulation::stopFeed();
+        complete();
+        return;
+    }
+    if (simulation.Simulation::isSpilled())
+    {
+        BaseAction::error("Not available for spilled plans");
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+        return;
+    }
+    if (path.empty() || !(policy == "block" || policy == "drop") || !(simulation.Simulation::startFeed(output, path, policy == "drop")))
+    {
+        BaseAction::error("Cannot feed changes to " + path);
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+        return;
+    }
+    complete();
+}
+
+FeedChanges* FeedChanges::clone() const {
+    return new FeedChanges(output, path, policy);
+}
+
+const string FeedChanges::toString() const {
+    return output == "off" ? "feed off" : "feed " + output + " " + path + " " + policy;
+}
+
+ActionRecord FeedChanges::toRecord(ActionLog &actionLog) const {
+    ActionRecord record = makeRecord(ActionCode::FEED);
+    record.values[0] = policy == "drop" ? 1 : policy == "block" ? 0 : -1;
+    record.strings[0] = actionLog.intern(output);
+    record.strings[1] = actionLog.intern(path);
+    return record;
+}
+
+//----------------------------------------------------------------
+//SetDelays Class
+//----------------------------------------------------------------
+
+SetDelays::SetDelays(const string &target, const string &distribution, int low, int mode, int high): BaseAction(), target(target), distribution(distribution), low(low), mode(mode), high(high) {}
+
+void SetDelays::act(Simulation &simulation) {
+    if (target == "off")
+    {
+        simulation.Simulation::clearDelays();
+        complete();
+        return;
+    }
+    if (simulation.Simulation::isSpilled())
+    {
+        BaseAction::error("Not available for spilled plans");
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+        return;
+    }
+    const ConstructionDelays *current = simulation.Simulation::getFacilityOptions().getDelays();
+    ConstructionDelays delays = current != nullptr ? *current : ConstructionDelays();
+    if (target == "seed")
+    {
+        delays.setSeed(low);
+        simulation.Simulation::setDelays(delays);
+        complete();
+        return;
+    }
+    const int category = target.size() == 1 ? target[0] - '0' : -1;
+    const DelayDistribution bounds = {low, distribution == "uniform" ? -1 : mode, high};
+    const bool valid = distribution == "fixed" || ((distribution == "uniform" || distribution == "triangular") && ConstructionDelays::isValid(bounds));
+    if (category < 0 || category >= ConstructionDelays::NUM_OF_CATEGORIES || !valid)
+    {
+        BaseAction::error("Invalid construction delays");
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+        return;
+    }
+    if (distribution == "fixed")
+    {
+        delays.reset((FacilityCategory)category);
+    }
+    else
+    {
+        delays.set((FacilityCategory)category, bounds);
+    }
+    simulation.Simulation::setDelays(delays);
+    complete();
+}
+
+SetDelays* SetDelays::clone() const {
+    return new SetDelays(target, distribution, low, mode, high);
+}
+
+const string SetDelays::toString() const {
+    if (target == "off")
+    {
+        return "delays off";
+    }
+    if (target == "seed")
+    {
+        return "delays seed " + to_string(low);
+    }
+    if (distribution == "uniform")
+    {
+        return "delays " + target + " uniform " + to_string(low) + " " + to_string(high);
+    }
+    if (distribution == "triangular")
+    {
+        return "delays " + target + " triangular " + to_string(low) + " " + to_string(mode) + " " + to_string(high);
+    }
+    return "delays " + target + " " + distribution;
+}
+
+ActionRecord SetDelays::toRecord(ActionLog &actionLog) const {
+    ActionRecord record = makeRecord(ActionCode::DELAYS);
+    record.values[0] = low;
+    record.values[1] = mode;
+    record.values[2] = high;
+    record.strings[0] = actionLog.intern(target);
+    record.strings[1] = actionLog.intern(distribution);
+    return record;
+}
+
+//----------------------------------------------------------------
+//RunMonteCarlo Class
+//----------------------------------------------------------------
+
+RunMonteCarlo::RunMonteCarlo(int numOfRuns, int numOfSteps): BaseAction(), numOfRuns(numOfRuns), numOfSteps(numOfSteps) {}
+
+void RunMonteCarlo::act(Simulation &simulation) {
+    if (simulation.Simulation::isSpilled())
+    {
+        BaseAction::error("Not available for spilled plans");
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+        return;
+    }
+    if (numOfRuns <= 0 || numOfRuns > MonteCarlo::MAX_RUNS || numOfSteps < 0)
+    {
+        BaseAction::error("Invalid number of runs or steps");
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+        return;
+    }
+    if (simulation.Simulation::getPlans().empty())
+    {
+        BaseAction::error("No plans to simulate");
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+        return;
+    }
+    MonteCarlo monteCarlo(simulation.Simulation::getPlans(), simulation.Simulation::getFacilityOptions());
+    {
+        TraceSpan span("montecarlo", Tracer::COMMANDS, numOfRuns);
+        monteCarlo.run(numOfRuns, numOfSteps);
+    }
+    monteCarlo.print(simulation.out());
+    complete();
+}
+
+RunMonteCarlo* RunMonteCarlo::clone() const {
+    return new RunMonteCarlo(numOfRuns, numOfSteps);
+}
+
+const string RunMonteCarlo::toString() const {
+    return "montecarlo " + to_string(numOfRuns) + " " + to_string(numOfSteps);
+}
+
+ActionRecord RunMonteCarlo::toRecord(ActionLog &) const {
+    ActionRecord record = makeRecord(ActionCode::MONTE_CARLO);
+    record.values[0] = numOfRuns;
+    record.values[1] = numOfSteps;
+    return record;
+}
+
+//----------------------------------------------------------------
+//RecordTrace Class
+//----------------------------------------------------------------
+
+RecordTrace::RecordTrace(const string &path, const string &detail): BaseAction(), path(path), detail(detail) {}
+
+void RecordTrace::act(Simulation &simulation) {
+    if (path == "off")
+    {
+        if (!detail.empty() || !Tracer::stop())
+        {
+            BaseAction::error("No trace to write");
+            simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+            return;
+        }
+        complete();
+        return;
+    }
+    if (path.empty() || !(detail.empty() || detail == "plans") || !Tracer::start(path, detail.empty() ? Tracer::COMMANDS : Tracer::PLANS))
+    {
+        BaseAction::error("Cannot trace to " + path);
+        simulation.out() << "Error: " + BaseAction::getErrorMsg() << endl;
+        return;
+    }
+    complete();
+}
+
+RecordTrace* RecordTrace::clone() const {
+    return new RecordTrace(path, detail);
+}
+
+const string RecordTrace::toString() const {
+    return detail.empty() ? "trace " + path : "trace " + path + " " + detail;
+}
+
+ActionRecord RecordTrace::toRecord(ActionLog &actionLog) const {
+    ActionRecord record = makeRecord(ActionCode::TRACE);
+    record.strings[0] = actionLog.intern(path);
+    record.strings[1] = actionLog.intern(detail);
+    return record;
+}
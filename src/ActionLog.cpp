@@ -0,0 +1,189 @@
+#include "ActionLog.h"
+#include "Action.h"
+#include <algorithm>
+
+using namespace std;
+
+ActionLog::ActionLog(): pool(make_shared<StringPool>()), numOfRecords(0) {
+    intern("");
+}
+
+uint32_t ActionLog::intern(const string &text) {
+    unordered_map<string, uint32_t>::const_iterator it = pool->ids.find(text);
+    if (it != pool->ids.end())
+    {
+        return it->second;
+    }
+    const uint32_t id = pool->strings.size();
+    pool->strings.push_back(text);
+    pool->ids.insert(make_pair(text, id));
+    return id;
+}
+
+const string &ActionLog::getString(uint32_t id) const {
+    return pool->strings[id];
+}
+
+void ActionLog::append(const ActionRecord &record) {
+    const size_t offset = numOfRecords % SEGMENT_RECORDS;
+    if (offset == 0)
+    {
+        segments.push_back(shared_ptr<Segment>(new Segment()));
+    }
+    else if (segments.back()->size != offset)
+    {
+        //A log sharing the segment has appended past our end, continue in a copy of our part of it
+        shared_ptr<Segment> copy(new Segment());
+        copy_n(segments.back()->records, offset, copy->records);
+        copy->size = offset;
+        segments.back() = copy;
+    }
+    Segment &segment = *segments.back();
+    segment.records[offset] = record;
+    segment.size = offset + 1;
+    numOfRecords++;
+}
+
+size_t ActionLog::size() const {
+    return numOfRecords;
+}
+
+const ActionRecord &ActionLog::get(size_t index) const {
+    return segments[index / SEGMENT_RECORDS]->records[index % SEGMENT_RECORDS];
+}
+
+ActionStatus ActionLog::getStatus(size_t index) const {
+    return (ActionStatus)get(index).status;
+}
+
+//Prints the record the way the action was typed, followed by its status
+void ActionLog::print(ostream &out, size_t index) const {
+    const ActionRecord &record = get(index);
+    const int32_t *values = record.values;
+    switch ((ActionCode)record.code)
+    {
+        case ActionCode::STEP:
+            out << "step " << values[0];
+            break;
+        case ActionCode::PLAN:
+            out << "plan " << getString(record.strings[0]) << ' ' << getString(record.strings[1]);
+            break;
+        case ActionCode::SETTLEMENT:
+            out << "settlement " << getString(record.strings[0]) << ' ' << values[0];
+            break;
+        case ActionCode::FACILITY:
+            out << "facility " << getString(record.strings[0]) << ' ' << values[0] << ' ' << values[1] << ' ' << values[2] << ' ' << values[3] << ' ' << values[4];
+            break;
+        case ActionCode::PLAN_STATUS:
+            out << "planStatus " << values[0];
+            break;
+        case ActionCode::CHANGE_POLICY:
+            out << "changePolicy " << values[0] << ' ' << getString(record.strings[0]);
+            break;
+        case ActionCode::LOG:
+            out << "log";
+            if (values[1] >= 0)
+            {
+                out << ' ' << values[0] << ' ' << values[1];
+            }
+            break;
+        case ActionCode::CLOSE:
+            out << "close";
+            break;
+        case ActionCode::BACKUP:
+            out << "backup";
+            break;
+        case ActionCode::RESTORE:
+            out << "restore";
+            break;
+        case ActionCode::RECORD:
+            out << "record " << getString(record.strings[0]);
+            break;
+        case ActionCode::SUMMARY:
+            out << "summary";
+            if (record.strings[0] != 0)
+            {
+                out << ' ' << getString(record.strings[0]);
+            }
+            break;
+        case ActionCode::TOP:
+            out << "top " << values[0] << ' ' << getString(record.strings[0]);
+            break;
+        case ActionCode::QUERY:
+            out << "query " << getString(record.strings[0]);
+            break;
+        case ActionCode::CHANGE_POLICY_RANGE:
+            out << "changePolicy range " << values[0] << ' ' << values[1] << ' ' << getString(record.strings[0]);
+            break;
+        case ActionCode::SPILL:
+            out << "spill " << getString(record.strings[0]);
+            break;
+        case ActionCode::AUTOSAVE:
+            out << "autosave ";
+            if (getString(record.strings[0]) != "off")
+            {
+                out << values[0] << ' ';
+            }
+            out << getString(record.strings[0]);
+            break;
+        case ActionCode::CHECKPOINT:
+            out << "checkpoint " << values[0] << ' ' << getString(record.strings[0]);
+            break;
+        case ActionCode::DIGEST:
+            out << "digest";
+            if (values[0] >= 0)
+            {
+                out << ' ' << values[0];
+            }
+            break;
+        case ActionCode::REALTIME:
+            out << "realtime ";
+            if (getString(record.strings[0]) != "off")
+            {
+                out << values[0] << ' ';
+            }
+            out << getString(record.strings[0]);
+            break;
+        case ActionCode::FEED:
+            out << "feed " << getString(record.strings[0]);
+            if (getString(record.strings[0]) != "off")
+            {
+                out << ' ' << getString(record.strings[1]);
+                if (values[0] >= 0)
+                {
+                    out << (values[0] == 1 ? " drop" : " block");
+                }
+            }
+            break;
+        case ActionCode::DELAYS:
+            out << "delays " << getString(record.strings[0]);
+            if (getString(record.strings[0]) == "seed")
+            {
+                out << ' ' << values[0];
+            }
+            else if (record.strings[1] != 0)
+            {
+                out << ' ' << getString(record.strings[1]);
+                if (getString(record.strings[1]) == "uniform")
+                {
+                    out << ' ' << values[0] << ' ' << values[2];
+                }
+                else if (getString(record.strings[1]) == "triangular")
+                {
+                    out << ' ' << values[0] << ' ' << values[1] << ' ' << values[2];
+                }
+            }
+            break;
+        case ActionCode::MONTE_CARLO:
+            out << "montecarlo " << values[0] << ' ' << values[1];
+            break;
+        case ActionCode::TRACE:
+            out << "trace " << getString(record.strings[0]);
+            if (record.strings[1] != 0)
+            {
+                out << ' ' << getString(record.strings[1]);
+            }
+            break;
+    }
+    out << (getStatus(index) == ActionStatus::COMPLETED ? " COMPLETED" : " ERROR");
+}
@@ -0,0 +1,141 @@
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+using namespace std;
+
+//Allocations a command may make in act() with the built in policies, not counting what the output
+//stream allocates. Commands that are not listed are not checked, and neither are commands that
+//failed, since building their error message is part of the output.
+struct CommandBudget {
+    const char *command;
+    size_t budget;
+};
+
+static const CommandBudget BUDGETS[] = {
+    {"planStatus", 0},
+    {"close", 0},
+    {"log", 0},
+    //Only when the plan indexed vectors grow: 14 (10 query columns, 3 rollups and the plan store's
+    //id table), and 2 more when the plan store starts a chunk and its chunk table grows
+    {"plan", 16},
+    {"changePolicy", 0},
+};
+
+static atomic<bool> exceeded(false);
+
+#ifdef SPLAND_COUNT_ALLOCATIONS
+
+//Per thread, so what the parsing and output threads of the pipeline allocate is not counted
+//against the command being executed
+static thread_local size_t allocations = 0;
+static thread_local int uncounted = 0;
+
+static void countAllocation() {
+    if (uncounted == 0)
+    {
+        allocations++;
+    }
+}
+
+static void *allocate(size_t size) {
+    countAllocation();
+    void *ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr)
+    {
+        throw bad_alloc();
+    }
+    return ptr;
+}
+
+void *operator new(size_t size) {
+    return allocate(size);
+}
+
+void *operator new[](size_t size) {
+    return allocate(size);
+}
+
+void *operator new(size_t size, const nothrow_t&) noexcept {
+    countAllocation();
+    return malloc(size == 0 ? 1 : size);
+}
+
+void *operator new[](size_t size, const nothrow_t&) noexcept {
+    countAllocation();
+    return malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void *ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void *ptr, const nothrow_t&) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void *ptr, const nothrow_t&) noexcept {
+    free(ptr);
+}
+
+bool AllocationCounter::isEnabled() {
+    return true;
+}
+
+size_t AllocationCounter::getCount() {
+    return allocations;
+}
+
+UncountedAllocations::UncountedAllocations() {
+    uncounted++;
+}
+
+UncountedAllocations::~UncountedAllocations() {
+    uncounted--;
+}
+
+#else
+
+bool AllocationCounter::isEnabled() {
+    return false;
+}
+
+size_t AllocationCounter::getCount() {
+    return 0;
+}
+
+UncountedAllocations::UncountedAllocations() {}
+
+UncountedAllocations::~UncountedAllocations() {}
+
+#endif
+
+size_t AllocationCounter::getBudget(const string &command) {
+    for (const CommandBudget &entry : BUDGETS)
+    {
+        if (command == entry.command)
+        {
+            return entry.budget;
+        }
+    }
+    return UNLIMITED;
+}
+
+void AllocationCounter::check(const string &command, size_t allocations) {
+    const size_t budget = getBudget(command);
+    if (budget != UNLIMITED && allocations > budget)
+    {
+        cerr << "Allocation budget exceeded: " << command << " made " << allocations << " allocations, budget is " << budget << endl;
+        exceeded.store(true, memory_order_relaxed);
+    }
+}
+
+bool AllocationCounter::wasExceeded() {
+    return exceeded.load(memory_order_relaxed);
+}
@@ -0,0 +1,162 @@
+#include "Autosave.h"
+#include "Action.h"
+#include "Simulation.h"
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+const size_t Autosaver::KEEP_CHECKPOINTS;
+
+Autosaver::Autosaver(int everyNumOfTicks, const string &directory)
+: everyNumOfTicks(everyNumOfTicks), directory(directory), writer(-1), writingTick(0) {}
+
+//Waits for the checkpoint being written, so no child outlives the simulation
+Autosaver::~Autosaver() {
+    if (writer > 0)
+    {
+        int status;
+        waitpid(writer, &status, 0);
+    }
+}
+
+int Autosaver::getInterval() const {
+    return everyNumOfTicks;
+}
+
+const string &Autosaver::getDirectory() const {
+    return directory;
+}
+
+//Called after every tick, forks a writer when a checkpoint is due
+void Autosaver::onTick(Simulation &simulation) {
+    const int tick = simulation.getTick();
+    if (!reap(simulation, false) || tick % everyNumOfTicks != 0)
+    {
+        return;
+    }
+    const string path = directory + "/checkpoint-" + to_string(tick) + ".txt";
+    const pid_t child = fork();
+    if (child < 0)
+    {
+        fail(simulation, tick, path);
+        return;
+    }
+    if (child == 0)
+    {
+        //_exit rather than exit, the child must not run the parent's exit handlers or flush its output
+        _exit(write(simulation, path) ? 0 : 1);
+    }
+    writer = child;
+    writingTick = tick;
+    writingPath = path;
+}
+
+//Waits for the checkpoint being written, when autosave is turned off
+void Autosaver::finish(Simulation &simulation) {
+    reap(simulation, true);
+}
+
+//Collects a finished writer and rotates the checkpoints, returns false if the writer is still running
+bool Autosaver::reap(Simulation &simulation, bool wait) {
+    if (writer < 0)
+    {
+        return true;
+    }
+    int status;
+    const pid_t finished = waitpid(writer, &status, wait ? 0 : WNOHANG);
+    if (finished == 0)
+    {
+        return false;
+    }
+    writer = -1;
+    if (finished < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+        fail(simulation, writingTick, writingPath);
+        return true;
+    }
+    checkpoints.push_back(writingPath);
+    while (checkpoints.size() > KEEP_CHECKPOINTS)
+    {
+        unlink(checkpoints.front().c_str());
+        checkpoints.pop_front();
+    }
+    return true;
+}
+
+void Autosaver::fail(Simulation &simulation, int tick, const string &path) {
+    ActionRecord record = ActionRecord();
+    record.code = (uint8_t)ActionCode::CHECKPOINT;
+    record.status = (uint8_t)ActionStatus::ERROR;
+    record.values[0] = tick;
+    record.strings[0] = simulation.getActionsLog().intern(path);
+    simulation.getActionsLog().append(record);
+}
+
+//Writes a checkpoint to a temporary file first, so 'path' is either complete or missing
+bool Autosaver::write(Simulation &simulation, const string &path) {
+    const string temporaryPath = path + ".tmp";
+    ofstream out(temporaryPath);
+    if (!out.is_open())
+    {
+        return false;
+    }
+    out << "tick " << simulation.getTick() << '\n';
+    for (const Settlement *settlement : simulation.getSettlements())
+    {
+        out << "settlement " << settlement->getName() << ' ' << (int)settlement->getType() << '\n';
+    }
+    for (const FacilityType &facility : simulation.getFacilityOptions())
+    {
+        out << "facility " << facility.getName() << ' ' << (int)facility.getCategory() << ' ' << facility.getCost() << ' '
+            << facility.getLifeQualityScore() << ' ' << facility.getEconomyScore() << ' ' << facility.getEnvironmentScore() << '\n';
+    }
+    for (const Plan &plan : simulation.getPlans())
+    {
+        const PolicyState &policy = plan.getPolicyState();
+        out << "plan " << plan.getPlanId() << ' ' << plan.getSettlementName() << ' ' << (int)plan.getPlanStatus() << ' '
+            << plan.getlifeQualityScore() << ' ' << plan.getEconomyScore() << ' ' << plan.getEnvironmentScore() << ' '
+            << (int)policy.kind << ' ' << policy.lastSelectedIndex << ' '
+            << policy.lifeQualityScore << ' ' << policy.economyScore << ' ' << policy.environmentScore;
+        if (policy.kind == PolicyKind::CUSTOM)
+        {
+            out << ' ' << plan.getSelectionPolicyName();
+        }
+        out << '\n';
+        for (const Facility *facility : plan.getFacilities())
+        {
+            out << "operational " << plan.getPlanId() << ' ' << facility->getName() << '\n';
+        }
+        for (const Facility *facility : plan.getUnderConstructionFacilities())
+        {
+            out << "construction " << plan.getPlanId() << ' ' << facility->getName() << ' ' << facility->getTimeLeft() << '\n';
+        }
+    }
+    const ActionLog &log = simulation.getActionsLog();
+    for (size_t i = 0; i < log.size(); i++)
+    {
+        out << "log ";
+        log.print(out, i);
+        out << '\n';
+    }
+    out.close();
+    bool written = !out.fail();
+    if (written)
+    {
+        const int fd = open(temporaryPath.c_str(), O_RDONLY);
+        written = fd >= 0 && fsync(fd) == 0;
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+    }
+    if (!written || rename(temporaryPath.c_str(), path.c_str()) != 0)
+    {
+        unlink(temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
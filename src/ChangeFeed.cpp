@@ -0,0 +1,254 @@
+#include "ChangeFeed.h"
+#include "Plan.h"
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+static_assert(sizeof(ChangeEvent) == 32, "ChangeEvent is written as is");
+
+const size_t ChangeFeed::CAPACITY;
+const size_t ChangeFeed::BATCH_EVENTS;
+const uint64_t ChangeFeed::ROTATE_BYTES;
+const int ChangeFeed::KEEP_FILES;
+const uint32_t ChangeFeed::VERSION;
+
+static const char MAGIC[4] = {'S', 'P', 'C', 'F'};
+static const size_t HEADER_SIZE = sizeof(MAGIC) + 2 * sizeof(uint32_t);
+
+//----------------------------------------------------------------
+//ChangeFeed Class
+//----------------------------------------------------------------
+
+//'output' is "fifo", "socket" or "file". A socket is connected and a file created right away, a
+//FIFO has to exist and is opened by the consumer.
+ChangeFeed::ChangeFeed(const string &output, const string &path, bool dropWhenFull):
+    output(FIFO),
+    path(path),
+    dropWhenFull(dropWhenFull),
+    valid(false),
+    fd(-1),
+    fileBytes(0),
+    sequence(0),
+    numOfDropped(0),
+    numOfWritten(0),
+    events(CAPACITY),
+    closing(false) {
+        if (output == "fifo")
+        {
+            struct stat status;
+            valid = stat(path.c_str(), &status) == 0 && S_ISFIFO(status.st_mode);
+        }
+        else if (output == "socket")
+        {
+            this->output = SOCKET;
+            sockaddr_un address = sockaddr_un();
+            address.sun_family = AF_UNIX;
+            fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (fd >= 0 && path.size() < sizeof(address.sun_path))
+            {
+                memcpy(address.sun_path, path.c_str(), path.size());
+                valid = ::connect(fd, (const sockaddr*)&address, sizeof(address)) == 0;
+            }
+        }
+        else if (output == "file")
+        {
+            this->output = ROTATING_FILE;
+            valid = openFile();
+        }
+        if (valid)
+        {
+            consumer = thread(&ChangeFeed::consume, this);
+        }
+}
+
+ChangeFeed::~ChangeFeed() {
+    close();
+}
+
+bool ChangeFeed::isOpen() const {
+    return valid;
+}
+
+//Called by the step engine after the plan changed
+void ChangeFeed::emit(ChangeEventType type, int tick, const Plan &plan, int facility) {
+    ChangeEvent event = ChangeEvent();
+    event.sequence = sequence++;
+    event.tick = tick;
+    event.planId = plan.getPlanId();
+    event.facility = facility;
+    event.type = (uint8_t)type;
+    event.lifeQualityScore = plan.getlifeQualityScore();
+    event.economyScore = plan.getEconomyScore();
+    event.environmentScore = plan.getEnvironmentScore();
+    if (events.tryPush(event))
+    {
+        return;
+    }
+    hasEvents.ring();
+    if (dropWhenFull)
+    {
+        numOfDropped++;
+        return;
+    }
+    hasRoom.waitUntil([this] {
+        return !events.isFull();
+    });
+    events.tryPush(event);
+}
+
+//Hands the events of a step to the consumer
+void ChangeFeed::publish() {
+    hasEvents.ring();
+}
+
+//Writes the events still queued, as far as the output takes them, and stops the consumer
+void ChangeFeed::close() {
+    if (!consumer.joinable())
+    {
+        return;
+    }
+    closing.store(true, memory_order_release);
+    hasEvents.ring();
+    consumer.join();
+    if (fd >= 0)
+    {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+uint64_t ChangeFeed::getNumOfEvents() const {
+    return sequence;
+}
+
+uint64_t ChangeFeed::getNumOfWritten() const {
+    return numOfWritten.load(memory_order_acquire);
+}
+
+uint64_t ChangeFeed::getNumOfDropped() const {
+    return numOfDropped;
+}
+
+//Opens the FIFO once a reader opened it, giving up when the feed is closed first
+bool ChangeFeed::connect() {
+    while (fd < 0)
+    {
+        fd = ::open(path.c_str(), O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fd >= 0)
+        {
+            break;
+        }
+        if (errno != ENXIO || closing.load(memory_order_acquire))
+        {
+            return false;
+        }
+        this_thread::sleep_for(chrono::milliseconds(10));
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+    return true;
+}
+
+bool ChangeFeed::openFile() {
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    fileBytes = 0;
+    return fd >= 0;
+}
+
+//Moves the full file out of the way, dropping the oldest, and starts a new one
+bool ChangeFeed::rotate() {
+    ::close(fd);
+    fd = -1;
+    for (int i = KEEP_FILES - 1; i > 0; i--)
+    {
+        const string older = path + "." + to_string(i);
+        const string newer = i == 1 ? path : path + "." + to_string(i - 1);
+        rename(newer.c_str(), older.c_str());
+    }
+    return openFile() && writeHeader();
+}
+
+bool ChangeFeed::writeHeader() {
+    char header[HEADER_SIZE];
+    const uint32_t version = VERSION;
+    const uint32_t eventSize = sizeof(ChangeEvent);
+    memcpy(header, MAGIC, sizeof(MAGIC));
+    memcpy(header + sizeof(MAGIC), &version, sizeof(version));
+    memcpy(header + sizeof(MAGIC) + sizeof(version), &eventSize, sizeof(eventSize));
+    return writeAll(header, sizeof(header));
+}
+
+bool ChangeFeed::writeAll(const char *data, size_t size) {
+    while (size > 0)
+    {
+        const ssize_t written = ::write(fd, data, size);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            return false;
+        }
+        data += written;
+        size -= written;
+        fileBytes += written;
+    }
+    return true;
+}
+
+bool ChangeFeed::write(const ChangeEvent *batch, size_t count) {
+    const size_t size = count * sizeof(ChangeEvent);
+    if (output == ROTATING_FILE && fileBytes > HEADER_SIZE && fileBytes + size > ROTATE_BYTES && !rotate())
+    {
+        return false;
+    }
+    return writeAll((const char*)batch, size);
+}
+
+//The consumer thread. Once writing failed, it goes on taking events so that a blocking feed never
+//stalls the simulation on a dead output.
+void ChangeFeed::consume() {
+    //A reader that went away makes writes fail with EPIPE instead of killing the process
+    sigset_t blocked;
+    sigemptyset(&blocked);
+    sigaddset(&blocked, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &blocked, nullptr);
+    bool writing = (output != FIFO || connect()) && writeHeader();
+    ChangeEvent batch[BATCH_EVENTS];
+    while (true)
+    {
+        //Read before taking events, the step engine emits nothing after closing the feed
+        const bool closed = closing.load(memory_order_acquire);
+        size_t count = 0;
+        while (count < BATCH_EVENTS && events.tryPop(batch[count]))
+        {
+            count++;
+        }
+        if (count > 0)
+        {
+            hasRoom.ring();
+            writing = writing && write(batch, count);
+            if (writing)
+            {
+                numOfWritten.fetch_add(count, memory_order_release);
+            }
+            continue;
+        }
+        if (closed)
+        {
+            break;
+        }
+        hasEvents.waitUntil([this] {
+            return !events.isEmpty() || closing.load(memory_order_acquire);
+        });
+    }
+}
@@ -0,0 +1,366 @@
+#include "ConfigImage.h"
+#include "Plan.h"
+#include "LookaheadSelection.h"
+#include "SelectionPolicy.h"
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const char MAGIC[8] = {'S', 'P', 'L', 'I', 'M', 'G', '\0', '\0'};
+static const uint32_t VERSION = 2;
+
+//FNV-1a hash of the whole file, 0 if it can not be read
+static uint64_t hashFile(const string &path) {
+    ifstream file(path, ios::binary);
+    if (!file.is_open())
+    {
+        return 0;
+    }
+    uint64_t hash = 1469598103934665603ULL;
+    char buffer[1 << 16];
+    while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0)
+    {
+        for (streamsize i = 0; i < file.gcount(); i++)
+        {
+            hash ^= (unsigned char)buffer[i];
+            hash *= 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+static void align(vector<unsigned char> &out) {
+    while (out.size() % 8 != 0)
+    {
+        out.push_back(0);
+    }
+}
+
+static void putColumn(vector<unsigned char> &out, const vector<uint32_t> &column) {
+    const unsigned char *bytes = (const unsigned char*)column.data();
+    out.insert(out.end(), bytes, bytes + column.size() * sizeof(uint32_t));
+    align(out);
+}
+
+class NameTable {
+    public:
+        uint32_t intern(const string &name) {
+            unordered_map<string, uint32_t>::iterator it = ids.find(name);
+            if (it != ids.end())
+            {
+                return it->second;
+            }
+            uint32_t id = offsets.size();
+            ids[name] = id;
+            offsets.push_back(data.size());
+            data.insert(data.end(), name.begin(), name.end());
+            return id;
+        }
+        unordered_map<string, uint32_t> ids;
+        vector<uint32_t> offsets;
+        vector<unsigned char> data;
+};
+
+ConfigImage::ConfigImage(): image(nullptr), size(0), header(nullptr) {}
+
+ConfigImage::~ConfigImage() {
+    close();
+}
+
+//Parses and validates the text configuration exactly like the Simulation constructor does, then writes its image
+bool ConfigImage::compile(const string &configFilePath, const string &imagePath) {
+    struct stat source;
+    if (stat(configFilePath.c_str(), &source) != 0)
+    {
+        cerr << "Error: could not open file " << configFilePath << endl;
+        return false;
+    }
+    Simulation simulation(configFilePath);
+
+    ConfigImageHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.sourceSize = source.st_size;
+    header.sourceModified = source.st_mtime;
+    header.sourceHash = hashFile(configFilePath);
+
+    NameTable names;
+    char resolved[PATH_MAX];
+    header.sourcePathId = names.intern(realpath(configFilePath.c_str(), resolved) != nullptr ? string(resolved) : configFilePath);
+
+    vector<uint32_t> settlements;
+    unordered_map<string, uint32_t> settlementIndex;
+    size_t numOfSettlements = 0;
+    const PlanStore &plans = simulation.getPlans();
+    for (Settlement *settlement : simulation.settlements)
+    {
+        settlementIndex[settlement->getName()] = numOfSettlements++;
+        settlements.push_back(names.intern(settlement->getName()));
+        settlements.push_back((uint32_t)settlement->getType());
+    }
+
+    const FacilityCatalog &facilities = simulation.getFacilityOptions();
+    vector<uint32_t> facilityColumns[6];
+    for (const FacilityType &facility : facilities)
+    {
+        facilityColumns[0].push_back(names.intern(facility.getName()));
+        facilityColumns[1].push_back((uint32_t)facility.getCategory());
+        facilityColumns[2].push_back(facility.getCost());
+        facilityColumns[3].push_back(facility.getLifeQualityScore());
+        facilityColumns[4].push_back(facility.getEconomyScore());
+        facilityColumns[5].push_back(facility.getEnvironmentScore());
+    }
+
+    vector<uint32_t> planDescriptors;
+    for (const Plan &plan : plans)
+    {
+        planDescriptors.push_back(settlementIndex[plan.getSettlementName()]);
+        if (plan.getPolicyKind() == PolicyKind::CUSTOM)
+        {
+            planDescriptors.push_back((uint32_t)PolicyKind::CUSTOM + names.intern(plan.getSelectionPolicyName()));
+        }
+        else
+        {
+            planDescriptors.push_back((uint32_t)plan.getPolicyKind());
+        }
+    }
+    names.offsets.push_back(names.data.size());
+
+    header.numOfNames = names.offsets.size() - 1;
+    header.numOfSettlements = numOfSettlements;
+    header.numOfFacilities = facilities.size();
+    header.numOfPlans = plans.size();
+
+    vector<unsigned char> out(sizeof(header));
+    header.nameTableOffset = out.size();
+    putColumn(out, names.offsets);
+    header.nameDataOffset = out.size();
+    out.insert(out.end(), names.data.begin(), names.data.end());
+    align(out);
+    header.settlementsOffset = out.size();
+    putColumn(out, settlements);
+    header.facilitiesOffset = out.size();
+    for (const vector<uint32_t> &column : facilityColumns)
+    {
+        putColumn(out, column);
+    }
+    header.plansOffset = out.size();
+    putColumn(out, planDescriptors);
+    header.imageSize = out.size();
+    memcpy(out.data(), &header, sizeof(header));
+
+    ofstream image(imagePath, ios::binary | ios::trunc);
+    if (!image.is_open() || !image.write((const char*)out.data(), out.size()))
+    {
+        cerr << "Error: could not write image " << imagePath << endl;
+        return false;
+    }
+    return true;
+}
+
+bool ConfigImage::isImage(const string &path) {
+    ifstream file(path, ios::binary);
+    char magic[sizeof(MAGIC)];
+    return file.read(magic, sizeof(magic)) && memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+bool ConfigImage::open(const string &imagePath) {
+    close();
+    int fd = ::open(imagePath.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || (size_t)status.st_size < sizeof(ConfigImageHeader))
+    {
+        ::close(fd);
+        return false;
+    }
+    void *mapped = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        return false;
+    }
+    madvise(mapped, status.st_size, MADV_SEQUENTIAL);
+    madvise(mapped, status.st_size, MADV_WILLNEED);
+    image = (const unsigned char*)mapped;
+    size = status.st_size;
+    header = (const ConfigImageHeader*)image;
+    if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION || header->imageSize != size || !isValid())
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void ConfigImage::close() {
+    if (image != nullptr)
+    {
+        munmap((void*)image, size);
+    }
+    image = nullptr;
+    size = 0;
+    header = nullptr;
+}
+
+//An image is stale when its text source has changed since it was compiled
+bool ConfigImage::isStale() const {
+    struct stat source;
+    if (stat(getSourcePath().c_str(), &source) != 0 || (uint64_t)source.st_size != header->sourceSize)
+    {
+        return true;
+    }
+    if ((int64_t)source.st_mtime == header->sourceModified)
+    {
+        return false;
+    }
+    return hashFile(getSourcePath()) != header->sourceHash;
+}
+
+string ConfigImage::getSourcePath() const {
+    return getName(header->sourcePathId);
+}
+
+//A section that starts on an 8 byte boundary after the header and ends inside the image
+bool ConfigImage::hasSection(uint64_t offset, uint64_t length) const {
+    return offset >= sizeof(ConfigImageHeader) && offset % 8 == 0 && offset <= size && length <= size - offset;
+}
+
+//Checks every offset and length against the size of the image and every id and index against its table,
+//so that load() and getName() can trust the image. A corrupt or truncated image is refused, not loaded.
+bool ConfigImage::isValid() const {
+    const uint64_t numOfNames = header->numOfNames;
+    const uint64_t numOfFacilities = header->numOfFacilities;
+    const uint64_t paddedFacilities = (numOfFacilities + 1) & ~1ull;
+    if (!hasSection(header->nameTableOffset, (numOfNames + 1) * sizeof(uint32_t)) ||
+        !hasSection(header->settlementsOffset, 2 * (uint64_t)header->numOfSettlements * sizeof(uint32_t)) ||
+        !hasSection(header->facilitiesOffset, 6 * paddedFacilities * sizeof(uint32_t)) ||
+        !hasSection(header->plansOffset, 2 * (uint64_t)header->numOfPlans * sizeof(uint32_t)) ||
+        !hasSection(header->nameDataOffset, 0) || header->sourcePathId >= numOfNames)
+    {
+        return false;
+    }
+    const uint32_t *offsets = section(header->nameTableOffset);
+    for (uint64_t i = 0; i < numOfNames; i++)
+    {
+        if (offsets[i] > offsets[i + 1])
+        {
+            return false;
+        }
+    }
+    if (!hasSection(header->nameDataOffset, offsets[numOfNames]))
+    {
+        return false;
+    }
+
+    const uint32_t *settlements = section(header->settlementsOffset);
+    for (uint32_t i = 0; i < header->numOfSettlements; i++)
+    {
+        if (settlements[2 * i] >= numOfNames || settlements[2 * i + 1] > (uint32_t)SettlementType::METROPOLIS)
+        {
+            return false;
+        }
+    }
+
+    const uint32_t *names = section(header->facilitiesOffset);
+    const uint32_t *categories = names + paddedFacilities;
+    for (uint32_t i = 0; i < numOfFacilities; i++)
+    {
+        if (names[i] >= numOfNames || categories[i] > (uint32_t)FacilityCategory::ENVIRONMENT)
+        {
+            return false;
+        }
+    }
+
+    const uint32_t *plans = section(header->plansOffset);
+    for (uint32_t i = 0; i < header->numOfPlans; i++)
+    {
+        const uint32_t policy = plans[2 * i + 1];
+        if (plans[2 * i] >= header->numOfSettlements)
+        {
+            return false;
+        }
+        if (policy >= (uint32_t)PolicyKind::CUSTOM)
+        {
+            if (policy - (uint32_t)PolicyKind::CUSTOM >= numOfNames)
+            {
+                return false;
+            }
+            unique_ptr<SelectionPolicy> selectionPolicy(LookaheadSelection::parse(getName(policy - (uint32_t)PolicyKind::CUSTOM)));
+            if (selectionPolicy == nullptr)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+const uint32_t *ConfigImage::section(uint64_t offset) const {
+    return (const uint32_t*)(image + offset);
+}
+
+string ConfigImage::getName(uint32_t nameId) const {
+    const uint32_t *offsets = section(header->nameTableOffset);
+    const char *data = (const char*)(image + header->nameDataOffset);
+    return string(data + offsets[nameId], offsets[nameId + 1] - offsets[nameId]);
+}
+
+//Fills an empty simulation. open() validated the image, so nothing is checked again.
+void ConfigImage::load(Simulation &simulation) const {
+    const uint32_t *settlements = section(header->settlementsOffset);
+    simulation.settlements.reserve(simulation.settlements.size() + header->numOfSettlements);
+    vector<Settlement*> loaded;
+    loaded.reserve(header->numOfSettlements);
+    for (uint32_t i = 0; i < header->numOfSettlements; i++)
+    {
+        Settlement *settlement = new Settlement(getName(settlements[2 * i]), (SettlementType)settlements[2 * i + 1]);
+        simulation.settlements.push_back(settlement);
+        simulation.registerSettlement(*settlement);
+        loaded.push_back(settlement);
+    }
+
+    const uint32_t numOfFacilities = header->numOfFacilities;
+    const uint32_t *names = section(header->facilitiesOffset);
+    const uint32_t *categories = names + ((numOfFacilities + 1) & ~1u);
+    const uint32_t *prices = categories + ((numOfFacilities + 1) & ~1u);
+    const uint32_t *lifeQualityScores = prices + ((numOfFacilities + 1) & ~1u);
+    const uint32_t *economyScores = lifeQualityScores + ((numOfFacilities + 1) & ~1u);
+    const uint32_t *environmentScores = economyScores + ((numOfFacilities + 1) & ~1u);
+    for (uint32_t i = 0; i < numOfFacilities; i++)
+    {
+        simulation.facilitiesOptions = simulation.facilitiesOptions.add(FacilityType(getName(names[i]), (FacilityCategory)categories[i], prices[i],
+            lifeQualityScores[i], economyScores[i], environmentScores[i]));
+    }
+
+    const uint32_t *plans = section(header->plansOffset);
+    simulation.plans.reserve(simulation.plans.size() + header->numOfPlans);
+    for (uint32_t i = 0; i < header->numOfPlans; i++)
+    {
+        const uint32_t policy = plans[2 * i + 1];
+        if (policy < (uint32_t)PolicyKind::CUSTOM)
+        {
+            simulation.plans.emplace_back(simulation.planCounter++, *loaded[plans[2 * i]], PolicyState((PolicyKind)policy), simulation.facilitiesOptions);
+        }
+        else
+        {
+            SelectionPolicy *selectionPolicy = LookaheadSelection::parse(getName(policy - (uint32_t)PolicyKind::CUSTOM));
+            simulation.plans.emplace_back(simulation.planCounter++, *loaded[plans[2 * i]], selectionPolicy, simulation.facilitiesOptions);
+        }
+        simulation.registerPlan(simulation.plans.back());
+    }
+}
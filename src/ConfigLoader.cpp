@@ -0,0 +1,307 @@
+#include "ConfigLoader.h"
+#include "LookaheadSelection.h"
+#include "Plan.h"
+#include "SelectionPolicy.h"
+#include "Settlement.h"
+#include <cctype>
+#include <climits>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <unordered_map>
+
+using namespace std;
+
+static const int MAX_ARGUMENTS = 8;
+
+struct Token {
+    const char *begin;
+    const char *end;
+};
+
+//Reads a leading integer the way stoi does. Returns false when there are no digits or the value does not fit.
+static bool parseInt(const Token &token, int &value) {
+    const char *p = token.begin;
+    bool negative = false;
+    if (p < token.end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        p++;
+    }
+    if (p == token.end || !isdigit((unsigned char)*p))
+    {
+        return false;
+    }
+    long long result = 0;
+    while (p < token.end && isdigit((unsigned char)*p))
+    {
+        result = result * 10 + (*p - '0');
+        if (result > (long long)INT_MAX + 1)
+        {
+            return false;
+        }
+        p++;
+    }
+    result = negative ? -result : result;
+    if (result > INT_MAX || result < INT_MIN)
+    {
+        return false;
+    }
+    value = (int)result;
+    return true;
+}
+
+static bool equals(const Token &token, const char *word) {
+    const char *p = token.begin;
+    while (p < token.end && *word != '\0' && *p == *word)
+    {
+        p++;
+        word++;
+    }
+    return p == token.end && *word == '\0';
+}
+
+static void addError(vector<ConfigRecord> &records, ConfigRecord::Kind kind, const char *message) {
+    ConfigRecord record;
+    record.kind = kind;
+    record.name = message;
+    records.push_back(move(record));
+}
+
+bool ConfigLoader::load(const string &configFilePath, Simulation &simulation) {
+    ifstream configFile(configFilePath, ios::binary);
+    if (!configFile.is_open())
+    {
+        return false;
+    }
+    string content;
+    configFile.seekg(0, ios::end);
+    streamoff length = configFile.tellg();
+    configFile.seekg(0, ios::beg);
+    if (length > 0)
+    {
+        content.resize(length);
+        configFile.read(&content[0], length);
+        content.resize(configFile.gcount());
+    }
+
+    size_t numOfChunks = content.size() / MIN_CHUNK_SIZE + 1;
+    size_t numOfThreads = thread::hardware_concurrency();
+    if (numOfThreads == 0)
+    {
+        numOfThreads = 1;
+    }
+    if (numOfChunks > numOfThreads)
+    {
+        numOfChunks = numOfThreads;
+    }
+
+    //Chunk i covers [bounds[i], bounds[i + 1]), and every bound except the last one starts a line
+    const char *data = content.data();
+    vector<const char*> bounds(1, data);
+    for (size_t i = 1; i < numOfChunks; i++)
+    {
+        const char *bound = data + content.size() * i / numOfChunks;
+        if (bound < bounds.back())
+        {
+            bound = bounds.back();
+        }
+        while (bound < data + content.size() && *(bound - 1) != '\n')
+        {
+            bound++;
+        }
+        bounds.push_back(bound);
+    }
+    bounds.push_back(data + content.size());
+
+    vector<vector<ConfigRecord>> chunks(numOfChunks);
+    vector<thread> workers;
+    for (size_t i = 1; i < numOfChunks; i++)
+    {
+        workers.push_back(thread(&ConfigLoader::parseChunk, bounds[i], bounds[i + 1], ref(chunks[i])));
+    }
+    parseChunk(bounds[0], bounds[1], chunks[0]);
+    for (thread &worker : workers)
+    {
+        worker.join();
+    }
+    apply(chunks, simulation);
+    return true;
+}
+
+void ConfigLoader::parseChunk(const char *begin, const char *end, vector<ConfigRecord> &records) {
+    while (begin < end)
+    {
+        const char *lineEnd = begin;
+        while (lineEnd < end && *lineEnd != '\n')
+        {
+            lineEnd++;
+        }
+        parseLine(begin, lineEnd, records);
+        begin = lineEnd + 1;
+    }
+}
+
+void ConfigLoader::parseLine(const char *begin, const char *end, vector<ConfigRecord> &records) {
+    Token arguments[MAX_ARGUMENTS];
+    size_t numOfArguments = 0;
+    const char *p = begin;
+    while (true)
+    {
+        while (p < end && isspace((unsigned char)*p))
+        {
+            p++;
+        }
+        if (p == end)
+        {
+            break;
+        }
+        const char *tokenBegin = p;
+        while (p < end && !isspace((unsigned char)*p))
+        {
+            p++;
+        }
+        if (numOfArguments < MAX_ARGUMENTS)
+        {
+            arguments[numOfArguments].begin = tokenBegin;
+            arguments[numOfArguments].end = p;
+        }
+        numOfArguments++;
+    }
+    if (numOfArguments == 0)
+    {
+        addError(records, ConfigRecord::ERROR_OUT, "Error: invalid configuration line");
+        return;
+    }
+    ConfigRecord record;
+    if (equals(arguments[0], "settlement"))
+    {
+        if (numOfArguments != 3 || !parseInt(arguments[2], record.values[0]))
+        {
+            addError(records, ConfigRecord::ERROR_ERR, "Error: invalid Settlement configuration");
+            return;
+        }
+        record.kind = ConfigRecord::SETTLEMENT;
+        record.name.assign(arguments[1].begin, arguments[1].end);
+    }
+    else if (equals(arguments[0], "facility"))
+    {
+        bool valid = numOfArguments == 7;
+        for (size_t i = 2; valid && i < 7; i++)
+        {
+            valid = parseInt(arguments[i], record.values[i - 2]);
+        }
+        if (!valid)
+        {
+            addError(records, ConfigRecord::ERROR_ERR, "Error: invalid Facility configuration");
+            return;
+        }
+        record.kind = ConfigRecord::FACILITY;
+        record.name.assign(arguments[1].begin, arguments[1].end);
+    }
+    else if (equals(arguments[0], "plan"))
+    {
+        if (numOfArguments != 3)
+        {
+            addError(records, ConfigRecord::ERROR_ERR, "Error: invalid Plan configuration");
+            return;
+        }
+        record.kind = ConfigRecord::PLAN;
+        record.name.assign(arguments[1].begin, arguments[1].end);
+        record.policy.assign(arguments[2].begin, arguments[2].end);
+    }
+    else
+    {
+        return;
+    }
+    records.push_back(move(record));
+}
+
+//Applies the parsed lines in order with the same checks Simulation::addSettlement, addFacility and addPlan make,
+//using hash sets instead of scanning the simulation for every line
+void ConfigLoader::apply(const vector<vector<ConfigRecord>> &chunks, Simulation &simulation) {
+    unordered_map<string, int> settlements;
+    for (size_t i = 0; i < simulation.settlements.size(); i++)
+    {
+        settlements[simulation.settlements[i]->getName()] = i;
+    }
+    size_t numOfPlans = simulation.plans.size();
+    for (const vector<ConfigRecord> &records : chunks)
+    {
+        for (const ConfigRecord &record : records)
+        {
+            numOfPlans += record.kind == ConfigRecord::PLAN;
+        }
+    }
+    if (!simulation.isSpilled())
+    {
+        simulation.plans.reserve(numOfPlans);
+    }
+    for (const vector<ConfigRecord> &records : chunks)
+    {
+        for (const ConfigRecord &record : records)
+        {
+            if (record.kind == ConfigRecord::ERROR_OUT)
+            {
+                cout << record.name << endl;
+            }
+            else if (record.kind == ConfigRecord::ERROR_ERR)
+            {
+                cerr << record.name << endl;
+            }
+            else if (record.kind == ConfigRecord::SETTLEMENT)
+            {
+                if (settlements.count(record.name) == 0)
+                {
+                    settlements[record.name] = simulation.settlements.size();
+                    simulation.settlements.push_back(new Settlement(record.name, (SettlementType)record.values[0]));
+                    simulation.registerSettlement(*simulation.settlements.back());
+                }
+            }
+            else if (record.kind == ConfigRecord::FACILITY)
+            {
+                if (simulation.facilitiesOptions.find(record.name) == FacilityCatalog::NOT_FOUND)
+                {
+                    simulation.facilitiesOptions = simulation.facilitiesOptions.add(FacilityType(record.name, (FacilityCategory)record.values[0],
+                        record.values[1], record.values[2], record.values[3], record.values[4]));
+                }
+            }
+            else if (record.kind == ConfigRecord::PLAN)
+            {
+                unordered_map<string, int>::const_iterator settlementIndex = settlements.find(record.name);
+                if (settlementIndex == settlements.end())
+                {
+                    cerr << "Error: Settlement does not exist" << endl;
+                    continue;
+                }
+                const Settlement &settlement = *simulation.settlements[settlementIndex->second];
+                PolicyKind kind;
+                if (PolicyState::parse(record.policy, kind))
+                {
+                    if (simulation.isSpilled())
+                    {
+                        simulation.addPlanRecord(settlementIndex->second, PolicyState(kind));
+                        continue;
+                    }
+                    simulation.plans.emplace_back(simulation.planCounter++, settlement, PolicyState(kind), simulation.facilitiesOptions);
+                }
+                else if (LookaheadSelection *lookahead = LookaheadSelection::parse(record.policy))
+                {
+                    if (simulation.isSpilled())
+                    {
+                        delete lookahead;
+                        cerr << "Error: Spilled plans cannot use selection policy " << record.policy << endl;
+                        continue;
+                    }
+                    simulation.plans.emplace_back(simulation.planCounter++, settlement, lookahead, simulation.facilitiesOptions);
+                }
+                else
+                {
+                    cerr << "Error: Invalid selection policy" << endl;
+                    continue;
+                }
+                simulation.registerPlan(simulation.plans.back());
+            }
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#include "ConstructionDelays.h"
+#include "Random.h"
+#include <cmath>
+
+using namespace std;
+
+const int ConstructionDelays::NUM_OF_CATEGORIES;
+const int ConstructionDelays::MAX_PERCENT;
+
+//----------------------------------------------------------------
+//ConstructionDelays Class
+//----------------------------------------------------------------
+
+//Percentages from 0 to MAX_PERCENT, with the mode, if any, between low and high
+bool ConstructionDelays::isValid(const DelayDistribution &distribution) {
+    if (distribution.low < 0 || distribution.low > distribution.high || distribution.high > MAX_PERCENT)
+    {
+        return false;
+    }
+    return distribution.mode < 0 || (distribution.low <= distribution.mode && distribution.mode <= distribution.high);
+}
+
+ConstructionDelays::ConstructionDelays(): seed(0), hasDistribution(), distributions() {}
+
+uint64_t ConstructionDelays::getSeed() const {
+    return seed;
+}
+
+void ConstructionDelays::setSeed(uint64_t seed) {
+    this->seed = seed;
+}
+
+void ConstructionDelays::set(FacilityCategory category, const DelayDistribution &distribution) {
+    hasDistribution[(int)category] = true;
+    distributions[(int)category] = distribution;
+}
+
+void ConstructionDelays::reset(FacilityCategory category) {
+    hasDistribution[(int)category] = false;
+}
+
+//The construction time of the facility that is the plan's 'ordinal'th, counting from 0
+int ConstructionDelays::getDuration(const FacilityType &type, int planId, uint32_t ordinal) const {
+    const int category = (int)type.getCategory();
+    if (!hasDistribution[category])
+    {
+        return type.getCost();
+    }
+    const DelayDistribution &distribution = distributions[category];
+    const double u = CounterRandom::uniform(seed, (uint32_t)planId, ordinal);
+    const double low = distribution.low;
+    const double high = distribution.high;
+    double percent;
+    if (distribution.mode < 0)
+    {
+        percent = low + u * (high - low);
+    }
+    else
+    {
+        //Inverse of the triangular distribution function
+        const double mode = distribution.mode;
+        if (u * (high - low) < mode - low)
+        {
+            percent = low + sqrt(u * (high - low) * (mode - low));
+        }
+        else
+        {
+            percent = high - sqrt((1 - u) * (high - low) * (high - mode));
+        }
+    }
+    const long duration = lround(type.getCost() * percent / 100);
+    return duration < 1 ? 1 : (int)duration;
+}
@@ -3,6 +3,8 @@
 #include "Settlement.h"
 #include "SelectionPolicy.h"
 #include "Facility.h"
+#include "Renderer.h"
+#include "SymbolTable.h"
 #include <string>
 #include <iostream>
 
@@ -18,7 +20,7 @@ FacilityType::FacilityType(
     const int lifeQuality_score,
     const int economy_score,
     const int environment_score)
-    : name(name),
+    : name(SymbolTable::intern(name)),
       category(category),
       price(price),
       lifeQuality_score(lifeQuality_score),
@@ -36,7 +38,7 @@ FacilityType::FacilityType(const FacilityType &other)
 FacilityType& FacilityType::operator=(const FacilityType &other) {
         if (this != &other) 
         {
-            const_cast<string &>(name) = other.name; 
+            const_cast<uint32_t &>(name) = other.name; 
             const_cast<FacilityCategory &>(category) = other.category;
             const_cast<int &>(price) = other.price;
             const_cast<int &>(lifeQuality_score) = other.lifeQuality_score;
@@ -47,7 +49,7 @@ FacilityType& FacilityType::operator=(const FacilityType &other) {
 }
 
 FacilityType::FacilityType(FacilityType &&other) noexcept
-        : name(move(other.name)), 
+        : name(other.name), 
           category(other.category), 
           price(other.price),
           lifeQuality_score(other.lifeQuality_score), 
@@ -56,7 +58,7 @@ FacilityType::FacilityType(FacilityType &&other) noexcept
 
 FacilityType& FacilityType::operator=(FacilityType &&other) noexcept {
         if (this != &other) {
-            const_cast<string &>(name) = move(other.name); 
+            const_cast<uint32_t &>(name) = other.name; 
             const_cast<FacilityCategory &>(category) = other.category;
             const_cast<int &>(price) = other.price;
             const_cast<int &>(lifeQuality_score) = other.lifeQuality_score;
@@ -67,6 +69,11 @@ FacilityType& FacilityType::operator=(FacilityType &&other) noexcept {
     }
 
 const string &FacilityType::getName() const
+{
+    return SymbolTable::resolve(name);
+}
+
+uint32_t FacilityType::getNameSymbol() const
 {
     return name;
 }
@@ -108,16 +115,22 @@ Facility::Facility(
     const int economy_score,
     const int environment_score)
     : FacilityType(name, category, price, lifeQuality_score, economy_score, environment_score),
-      settlementName(settlementName),
+      settlementName(SymbolTable::intern(settlementName)),
       status(FacilityStatus::UNDER_CONSTRUCTIONS),
       timeLeft(price){}
 
        
 Facility::Facility (const FacilityType &type, const string &settlementName):
+    Facility(type, SymbolTable::intern(settlementName)) {}
+
+Facility::Facility (const FacilityType &type, uint32_t settlementName):
+    Facility(type, settlementName, type.getCost()) {}
+
+Facility::Facility (const FacilityType &type, uint32_t settlementName, int timeLeft):
     FacilityType(type),
     settlementName(settlementName),
     status(FacilityStatus::UNDER_CONSTRUCTIONS),
-    timeLeft(type.getCost()) {}
+    timeLeft(timeLeft) {}
 
 Facility::Facility(const Facility& other)
     : FacilityType(other),
@@ -129,7 +142,7 @@ Facility& Facility::operator=(const Facility &other) {
     if (this != &other) 
     {
         FacilityType::operator=(other); 
-        const_cast<string &>(settlementName) = other.settlementName; 
+        const_cast<uint32_t &>(settlementName) = other.settlementName; 
         status = other.status;
         timeLeft = other.timeLeft;
     }
@@ -137,7 +150,7 @@ Facility& Facility::operator=(const Facility &other) {
 }
 Facility::Facility(Facility &&other) noexcept
     : FacilityType(move(other)), 
-      settlementName(move(other.settlementName)),
+      settlementName(other.settlementName),
       status(other.status), 
       timeLeft(other.timeLeft) {}
 
@@ -145,7 +158,7 @@ Facility& Facility::operator=(Facility &&other) noexcept {
     if (this != &other) 
     {
         FacilityType::operator=(move(other)); 
-        const_cast<string &>(settlementName) = move(other.settlementName); 
+        const_cast<uint32_t &>(settlementName) = other.settlementName; 
         status = other.status;
         timeLeft = other.timeLeft;
     }
@@ -154,7 +167,12 @@ Facility& Facility::operator=(Facility &&other) noexcept {
 
 const string &Facility::getSettlementName() const
 {
-    return this->settlementName;
+    return SymbolTable::resolve(settlementName);
+}
+
+uint32_t Facility::getSettlementSymbol() const
+{
+    return settlementName;
 }
      
 const int Facility::getTimeLeft() const
@@ -185,13 +203,7 @@ const FacilityStatus& Facility::getStatus() const
 }
 
 Facility* Facility::clone() const {
-    Facility* a = new Facility(this->getName(), 
-    this->getSettlementName(),
-    this->getCategory(),
-    this->getCost(),
-    this->getLifeQualityScore(),
-    this->getEconomyScore(),
-    this->getEnvironmentScore());
+    Facility* a = new Facility(*this, this->settlementName);
     a->setTimeLeft(this->timeLeft);
     return a;
 }
@@ -202,8 +214,12 @@ void Facility::setTimeLeft(int time) {
         
 const string Facility::toString() const
 {
-    return  "settlement: " + getSettlementName() + ", faciility: " + getName() + ", price: " + std::to_string(getCost()) + ", time left: " + std::to_string(getTimeLeft()) + ", life quality score: " + std::to_string(getLifeQualityScore())
-    + ", economy score: " + std::to_string(getEconomyScore()) + ", environment score: " + std::to_string(getEnvironmentScore());
+    string text;
+    ReportRenderer renderer(text);
+    renderer << "settlement: " << getSettlementName() << ", faciility: " << getName() << ", price: " << getCost() << ", time left: " << getTimeLeft() << ", life quality score: " << getLifeQualityScore()
+    << ", economy score: " << getEconomyScore() << ", environment score: " << getEnvironmentScore();
+    renderer.flush();
+    return text;
 }
         
 
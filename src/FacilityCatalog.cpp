@@ -0,0 +1,146 @@
+#include "FacilityCatalog.h"
+#include "SymbolTable.h"
+#include <new>
+
+using namespace std;
+
+const int FacilityCatalog::NOT_FOUND;
+const size_t FacilityCatalog::MIN_CAPACITY;
+
+static atomic<uint64_t> nextStorageId(1);
+
+static size_t hashSymbol(uint32_t symbol) {
+    return (size_t)((symbol * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+//----------------------------------------------------------------
+//FacilityCatalog Class
+//----------------------------------------------------------------
+
+//The index has twice as many slots as the storage has entries, so probing stays short
+FacilityCatalog::Storage::Storage(size_t capacity):
+    entries(static_cast<FacilityType*>(::operator new(capacity * sizeof(FacilityType)))),
+    capacity(capacity),
+    claimed(0),
+    index(new atomic<uint32_t>[2 * capacity]),
+    indexMask(2 * capacity - 1),
+    id(nextStorageId.fetch_add(1, memory_order_relaxed)) {
+        for (size_t slot = 0; slot <= indexMask; slot++)
+        {
+            index[slot].store(0, memory_order_relaxed);
+        }
+}
+
+FacilityCatalog::Storage::~Storage() {
+    const size_t numOfEntries = claimed.load(memory_order_relaxed);
+    for (size_t i = 0; i < numOfEntries; i++)
+    {
+        entries[i].~FacilityType();
+    }
+    ::operator delete(entries);
+}
+
+//Takes the position for a version that ends right before it. Only one version can, so two
+//versions never append to the same storage at once.
+bool FacilityCatalog::Storage::claim(size_t position) {
+    size_t expected = position;
+    return position < capacity && claimed.compare_exchange_strong(expected, position + 1, memory_order_acq_rel);
+}
+
+void FacilityCatalog::Storage::construct(size_t position, const FacilityType &facility) {
+    new (&entries[position]) FacilityType(facility);
+    size_t slot = hashSymbol(facility.getNameSymbol()) & indexMask;
+    uint32_t empty = 0;
+    while (!index[slot].compare_exchange_strong(empty, position + 1, memory_order_release))
+    {
+        slot = (slot + 1) & indexMask;
+        empty = 0;
+    }
+}
+
+FacilityCatalog::FacilityCatalog(): storage(), entries(nullptr), count(0), delays() {}
+
+//Returns the position of the facility, NOT_FOUND if the catalog has none by that name
+int FacilityCatalog::find(const string &name) const {
+    uint32_t symbol;
+    return SymbolTable::find(name, symbol) ? find(symbol) : NOT_FOUND;
+}
+
+int FacilityCatalog::find(uint32_t name) const {
+    if (storage == nullptr)
+    {
+        return NOT_FOUND;
+    }
+    size_t slot = hashSymbol(name) & storage->indexMask;
+    while (true)
+    {
+        const uint32_t position = storage->index[slot].load(memory_order_acquire);
+        if (position == 0)
+        {
+            return NOT_FOUND;
+        }
+        //Positions past this version belong to versions added after it
+        if (position - 1 < count && entries[position - 1].getNameSymbol() == name)
+        {
+            return position - 1;
+        }
+        slot = (slot + 1) & storage->indexMask;
+    }
+}
+
+//Returns the catalog with the facility added after the facilities of this one
+FacilityCatalog FacilityCatalog::add(const FacilityType &facility) const {
+    FacilityCatalog next;
+    if (storage != nullptr && storage->claim(count))
+    {
+        next.storage = storage;
+    }
+    else
+    {
+        //Capacities are powers of two, so the index can be probed with a mask
+        size_t capacity = MIN_CAPACITY;
+        while (capacity < 2 * count)
+        {
+            capacity *= 2;
+        }
+        next.storage = make_shared<Storage>(capacity);
+        for (size_t i = 0; i < count; i++)
+        {
+            next.storage->claim(i);
+            next.storage->construct(i, entries[i]);
+        }
+        next.storage->claim(count);
+    }
+    next.storage->construct(count, facility);
+    next.entries = next.storage->entries;
+    next.count = count + 1;
+    next.delays = delays;
+    return next;
+}
+
+//Returns the catalog with its facilities built with 'delays' instead, null for exactly their price
+FacilityCatalog FacilityCatalog::withDelays(shared_ptr<const ConstructionDelays> delays) const {
+    FacilityCatalog next(*this);
+    next.delays = delays;
+    return next;
+}
+
+//The same facilities in the same order, built with the same delays
+bool FacilityCatalog::isSameAs(const FacilityCatalog &other) const {
+    if (count != other.count || delays != other.delays)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        const FacilityType &facility = entries[i];
+        const FacilityType &otherFacility = other.entries[i];
+        if (facility.getNameSymbol() != otherFacility.getNameSymbol() || facility.getCategory() != otherFacility.getCategory() ||
+            facility.getCost() != otherFacility.getCost() || facility.getLifeQualityScore() != otherFacility.getLifeQualityScore() ||
+            facility.getEconomyScore() != otherFacility.getEconomyScore() || facility.getEnvironmentScore() != otherFacility.getEnvironmentScore())
+        {
+            return false;
+        }
+    }
+    return true;
+}
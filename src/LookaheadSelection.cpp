@@ -0,0 +1,423 @@
+#include "LookaheadSelection.h"
+#include "Digest.h"
+#include "SymbolTable.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <sstream>
+#include <unordered_map>
+
+using namespace std;
+
+//A facility score triple that appears in the facility options, with the first facility that has it
+struct LookaheadCandidate {
+    int64_t scores[3];
+    int index;
+};
+
+struct LookaheadNode {
+    int64_t scores[3];
+    int first; //Candidate the sequence starts with
+};
+
+struct LookaheadKey {
+    uint64_t context; //Facility options and settings
+    int64_t scores[3];
+
+    bool operator==(const LookaheadKey &other) const {
+        return context == other.context && scores[0] == other.scores[0] && scores[1] == other.scores[1] && scores[2] == other.scores[2];
+    }
+};
+
+struct LookaheadKeyHash {
+    size_t operator()(const LookaheadKey &key) const {
+        uint64_t hash = key.context;
+        for (int i = 0; i < 3; i++)
+        {
+            hash = (hash ^ (uint64_t)key.scores[i]) * 1099511628211ULL;
+        }
+        return hash ^ (hash >> 29);
+    }
+};
+
+//Per thread, so plans stepped on different threads never share it. Reused across selections, so
+//searching does not allocate once the vectors have grown.
+struct LookaheadWorkspace {
+    LookaheadWorkspace(): storageId(0), numOfOptions(0), fingerprint(0), maxSpread(0) {}
+    uint64_t storageId;  //The catalog version the candidates were built from, see FacilityCatalog::getStorageId
+    size_t numOfOptions;
+    uint64_t fingerprint; //Of the facility scores, so cached selections carry over to equal catalogs
+    vector<LookaheadCandidate> candidates;
+    int64_t maxGain[3];  //Highest score each candidate can add, per score
+    int64_t maxSpread;   //Largest gap between the scores of one candidate
+    vector<LookaheadNode> beam;
+    vector<LookaheadNode> children;
+    unordered_map<LookaheadKey, int, LookaheadKeyHash> cache;
+};
+
+static thread_local LookaheadWorkspace workspace;
+
+static uint64_t mix(uint64_t hash, int64_t value) {
+    return (hash ^ (uint64_t)value) * 1099511628211ULL;
+}
+
+static int64_t spread(const int64_t *scores) {
+    return max(max(scores[0], scores[1]), scores[2]) - min(min(scores[0], scores[1]), scores[2]);
+}
+
+//Rebuilds the candidates when the facility options are another catalog version than at the last
+//selection on this thread, which takes two comparisons when they are not
+static void prepare(LookaheadWorkspace &ws, const FacilityCatalog &facilitiesOptions) {
+    if (facilitiesOptions.getStorageId() == ws.storageId && facilitiesOptions.size() == ws.numOfOptions)
+    {
+        return;
+    }
+    ws.storageId = facilitiesOptions.getStorageId();
+    ws.numOfOptions = facilitiesOptions.size();
+    ws.fingerprint = 14695981039346656037ULL;
+    for (const FacilityType &facility : facilitiesOptions)
+    {
+        ws.fingerprint = mix(ws.fingerprint, facility.getLifeQualityScore());
+        ws.fingerprint = mix(ws.fingerprint, facility.getEconomyScore());
+        ws.fingerprint = mix(ws.fingerprint, facility.getEnvironmentScore());
+    }
+    ws.candidates.clear();
+    for (size_t i = 0; i < facilitiesOptions.size(); i++)
+    {
+        const FacilityType &facility = facilitiesOptions[i];
+        LookaheadCandidate candidate = {{facility.getLifeQualityScore(), facility.getEconomyScore(), facility.getEnvironmentScore()}, (int)i};
+        ws.candidates.push_back(candidate);
+    }
+    stable_sort(ws.candidates.begin(), ws.candidates.end(), [](const LookaheadCandidate &a, const LookaheadCandidate &b) {
+        return lexicographical_compare(a.scores, a.scores + 3, b.scores, b.scores + 3);
+    });
+    ws.candidates.erase(unique(ws.candidates.begin(), ws.candidates.end(), [](const LookaheadCandidate &a, const LookaheadCandidate &b) {
+        return equal(a.scores, a.scores + 3, b.scores);
+    }), ws.candidates.end());
+    sort(ws.candidates.begin(), ws.candidates.end(), [](const LookaheadCandidate &a, const LookaheadCandidate &b) {
+        return a.index < b.index;
+    });
+    ws.maxSpread = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        ws.maxGain[i] = ws.candidates.empty() ? 0 : ws.candidates[0].scores[i];
+    }
+    for (const LookaheadCandidate &candidate : ws.candidates)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            ws.maxGain[i] = max(ws.maxGain[i], candidate.scores[i]);
+        }
+        ws.maxSpread = max(ws.maxSpread, spread(candidate.scores));
+    }
+}
+
+//The objective, higher is better
+static int64_t value(const LookaheadSettings &settings, const int64_t *scores) {
+    switch (settings.objective)
+    {
+        case LookaheadObjective::BALANCE:
+            return -spread(scores);
+        case LookaheadObjective::MIN_SCORE:
+            return min(min(scores[0], scores[1]), scores[2]);
+        case LookaheadObjective::WEIGHTED:
+            break;
+    }
+    return settings.weights[0] * scores[0] + settings.weights[1] * scores[1] + settings.weights[2] * scores[2];
+}
+
+//The best value any 'remaining' more selections could reach from 'scores'
+static int64_t bound(const LookaheadSettings &settings, const LookaheadWorkspace &ws, const int64_t *scores, int remaining) {
+    switch (settings.objective)
+    {
+        case LookaheadObjective::BALANCE:
+            //One selection narrows the gap by at most the gap between its own scores
+            return -max((int64_t)0, spread(scores) - remaining * ws.maxSpread);
+        case LookaheadObjective::MIN_SCORE:
+            return min(min(scores[0] + remaining * ws.maxGain[0], scores[1] + remaining * ws.maxGain[1]), scores[2] + remaining * ws.maxGain[2]);
+        case LookaheadObjective::WEIGHTED:
+            break;
+    }
+    return value(settings, scores) + remaining * (settings.weights[0] * ws.maxGain[0] + settings.weights[1] * ws.maxGain[1] + settings.weights[2] * ws.maxGain[2]);
+}
+
+//Orders the nodes of one search level, best first. Ties are broken on the first selection and the
+//scores, so the search does not depend on the order of the nodes.
+static bool better(const LookaheadSettings &settings, const LookaheadNode &a, const LookaheadNode &b) {
+    const int64_t valueA = value(settings, a.scores);
+    const int64_t valueB = value(settings, b.scores);
+    if (valueA != valueB)
+    {
+        return valueA > valueB;
+    }
+    if (a.first != b.first)
+    {
+        return a.first < b.first;
+    }
+    return lexicographical_compare(a.scores, a.scores + 3, b.scores, b.scores + 3);
+}
+
+//Returns the candidate the best sequence from 'root' starts with. 'complete' is false if the time
+//budget ran out before every level was searched.
+static int search(const LookaheadSettings &settings, LookaheadWorkspace &ws, const int64_t *root, bool &complete) {
+    const vector<LookaheadCandidate> &candidates = ws.candidates;
+    const int numOfCandidates = candidates.size();
+    complete = true;
+    if (numOfCandidates == 1)
+    {
+        return 0;
+    }
+
+    //Greedy sequence, every selection the best single next step
+    int64_t greedy[3] = {root[0], root[1], root[2]};
+    int bestFirst = 0;
+    for (int level = 0; level < settings.depth; level++)
+    {
+        int best = 0;
+        int64_t bestValue = 0;
+        for (int c = 0; c < numOfCandidates; c++)
+        {
+            const int64_t next[3] = {greedy[0] + candidates[c].scores[0], greedy[1] + candidates[c].scores[1], greedy[2] + candidates[c].scores[2]};
+            const int64_t nextValue = value(settings, next);
+            if (c == 0 || nextValue > bestValue)
+            {
+                best = c;
+                bestValue = nextValue;
+            }
+        }
+        if (level == 0)
+        {
+            bestFirst = best;
+        }
+        for (int i = 0; i < 3; i++)
+        {
+            greedy[i] += candidates[best].scores[i];
+        }
+    }
+    int64_t incumbent = value(settings, greedy);
+
+    const chrono::steady_clock::time_point deadline = chrono::steady_clock::now() + chrono::microseconds(settings.timeBudgetMicros);
+    LookaheadNode start = {{root[0], root[1], root[2]}, -1};
+    ws.beam.assign(1, start);
+    for (int level = 1; level <= settings.depth; level++)
+    {
+        const int remaining = settings.depth - level;
+        ws.children.clear();
+        for (const LookaheadNode &node : ws.beam)
+        {
+            for (int c = 0; c < numOfCandidates; c++)
+            {
+                LookaheadNode child = {{node.scores[0] + candidates[c].scores[0], node.scores[1] + candidates[c].scores[1], node.scores[2] + candidates[c].scores[2]}, level == 1 ? c : node.first};
+                if (bound(settings, ws, child.scores, remaining) <= incumbent)
+                {
+                    continue;
+                }
+                if (remaining == 0)
+                {
+                    //At the last level the bound is the value itself
+                    incumbent = value(settings, child.scores);
+                    bestFirst = child.first;
+                    continue;
+                }
+                ws.children.push_back(child);
+            }
+        }
+        if (remaining == 0 || ws.children.empty())
+        {
+            break;
+        }
+
+        //Keep the best beamWidth distinct states. A few times more than that are ranked, so states
+        //reached in several orders do not crowd out the others.
+        const size_t ranked = min(ws.children.size(), (size_t)settings.beamWidth * 4);
+        nth_element(ws.children.begin(), ws.children.begin() + ranked - 1, ws.children.end(), [&settings](const LookaheadNode &a, const LookaheadNode &b) {
+            return better(settings, a, b);
+        });
+        sort(ws.children.begin(), ws.children.begin() + ranked, [&settings](const LookaheadNode &a, const LookaheadNode &b) {
+            return better(settings, a, b);
+        });
+        ws.beam.clear();
+        for (size_t i = 0; i < ranked && ws.beam.size() < (size_t)settings.beamWidth; i++)
+        {
+            bool duplicate = false;
+            for (const LookaheadNode &kept : ws.beam)
+            {
+                if (equal(kept.scores, kept.scores + 3, ws.children[i].scores))
+                {
+                    duplicate = true;
+                    break;
+                }
+            }
+            if (!duplicate)
+            {
+                ws.beam.push_back(ws.children[i]);
+            }
+        }
+
+        if (settings.timeBudgetMicros > 0 && chrono::steady_clock::now() > deadline)
+        {
+            complete = false;
+            break;
+        }
+    }
+    return bestFirst;
+}
+
+//----------------------------------------------------------------
+//LookaheadSelection Class
+//----------------------------------------------------------------
+
+LookaheadSelection::LookaheadSelection(const LookaheadSettings &settings, int lifeQualityScore, int economyScore, int environmentScore)
+: settings(settings), name(getName(settings)), nameSymbol(SymbolTable::intern(name)) {
+    scores[0] = lifeQualityScore;
+    scores[1] = economyScore;
+    scores[2] = environmentScore;
+}
+
+LookaheadSettings LookaheadSelection::getDefaultSettings() {
+    LookaheadSettings settings = {LookaheadObjective::BALANCE, DEFAULT_DEPTH, DEFAULT_BEAM_WIDTH, {1, 1, 1}, DEFAULT_TIME_BUDGET};
+    return settings;
+}
+
+const LookaheadSettings &LookaheadSelection::getSettings() const {
+    return settings;
+}
+
+//Returns null if 'name' is not a lookahead policy
+LookaheadSelection *LookaheadSelection::parse(const string &name, int lifeQualityScore, int economyScore, int environmentScore) {
+    vector<string> parts;
+    istringstream iss(name);
+    string part;
+    while (getline(iss, part, ':'))
+    {
+        parts.push_back(part);
+    }
+    if (parts.empty() || parts.size() > 5 || parts[0] != "lookahead")
+    {
+        return nullptr;
+    }
+    LookaheadSettings settings = getDefaultSettings();
+    if (parts.size() > 1)
+    {
+        if (parts[1] == "balance")
+        {
+            settings.objective = LookaheadObjective::BALANCE;
+        }
+        else if (parts[1] == "min")
+        {
+            settings.objective = LookaheadObjective::MIN_SCORE;
+        }
+        else if (parts[1] == "sum")
+        {
+            settings.objective = LookaheadObjective::WEIGHTED;
+        }
+        else
+        {
+            return nullptr;
+        }
+    }
+    const int limits[] = {0, 0, MAX_DEPTH, MAX_BEAM_WIDTH, MAX_TIME_BUDGET};
+    int *values[] = {nullptr, nullptr, &settings.depth, &settings.beamWidth, &settings.timeBudgetMicros};
+    for (size_t i = 2; i < parts.size(); i++)
+    {
+        char *end;
+        const long number = strtol(parts[i].c_str(), &end, 10);
+        if (parts[i].empty() || *end != '\0' || number < 1 || number > limits[i])
+        {
+            return nullptr;
+        }
+        *values[i] = number;
+    }
+    return new LookaheadSelection(settings, lifeQualityScore, economyScore, environmentScore);
+}
+
+string LookaheadSelection::getName(const LookaheadSettings &settings) {
+    const LookaheadSettings defaults = getDefaultSettings();
+    if (settings.objective == defaults.objective && settings.depth == defaults.depth && settings.beamWidth == defaults.beamWidth &&
+        settings.timeBudgetMicros == defaults.timeBudgetMicros)
+    {
+        return "lookahead";
+    }
+    static const char *OBJECTIVES[] = {"balance", "min", "sum"};
+    string name = string("lookahead:") + OBJECTIVES[(int)settings.objective] + ":" + to_string(settings.depth) + ":" + to_string(settings.beamWidth);
+    if (settings.timeBudgetMicros != defaults.timeBudgetMicros)
+    {
+        name += ":" + to_string(settings.timeBudgetMicros);
+    }
+    return name;
+}
+
+const FacilityType& LookaheadSelection::selectFacility(const FacilityCatalog& facilitiesOptions) {
+    LookaheadWorkspace &ws = workspace;
+    prepare(ws, facilitiesOptions);
+    int candidate = 0;
+    if (settings.objective == LookaheadObjective::WEIGHTED)
+    {
+        //Every selection adds to the sum on its own, so the best sequence repeats the best facility
+        int64_t bestValue = 0;
+        for (size_t c = 0; c < ws.candidates.size(); c++)
+        {
+            const int64_t candidateValue = value(settings, ws.candidates[c].scores);
+            if (c == 0 || candidateValue > bestValue)
+            {
+                candidate = c;
+                bestValue = candidateValue;
+            }
+        }
+    }
+    else
+    {
+        //Both objectives only compare the scores to each other, so shifting all three keeps the answer
+        const int64_t lowest = min(min(scores[0], scores[1]), scores[2]);
+        uint64_t context = ws.fingerprint;
+        context = mix(context, (int64_t)settings.objective);
+        context = mix(context, settings.depth);
+        context = mix(context, settings.beamWidth);
+        const LookaheadKey key = {context, {scores[0] - lowest, scores[1] - lowest, scores[2] - lowest}};
+        unordered_map<LookaheadKey, int, LookaheadKeyHash>::const_iterator it = ws.cache.find(key);
+        if (it != ws.cache.end())
+        {
+            candidate = it->second;
+        }
+        else
+        {
+            bool complete;
+            candidate = search(settings, ws, key.scores, complete);
+            if (complete)
+            {
+                if (ws.cache.size() >= CACHE_CAPACITY)
+                {
+                    ws.cache.clear();
+                }
+                ws.cache.insert(make_pair(key, candidate));
+            }
+        }
+    }
+    const FacilityType &selected = facilitiesOptions[ws.candidates[candidate].index];
+    scores[0] += selected.getLifeQualityScore();
+    scores[1] += selected.getEconomyScore();
+    scores[2] += selected.getEnvironmentScore();
+    return selected;
+}
+
+const string &LookaheadSelection::toString() const {
+    return name;
+}
+
+uint32_t LookaheadSelection::getNameSymbol() const {
+    return nameSymbol;
+}
+
+//The settings are in the name, the scores decide what the next search starts from
+uint64_t LookaheadSelection::mixDigest(uint64_t digest) const {
+    digest = Digest::mix(digest, name);
+    for (int64_t score : scores)
+    {
+        digest = Digest::mix(digest, (uint64_t)score);
+    }
+    return digest;
+}
+
+LookaheadSelection* LookaheadSelection::clone() const {
+    return new LookaheadSelection(*this);
+}
@@ -0,0 +1,117 @@
+#include "MonteCarlo.h"
+#include "Settlement.h"
+#include <algorithm>
+#include <iomanip>
+#include <memory>
+#include <thread>
+
+using namespace std;
+
+const int MonteCarlo::MAX_RUNS;
+const int MonteCarlo::NUM_OF_PERCENTILES;
+const int MonteCarlo::PERCENTILES[NUM_OF_PERCENTILES] = {5, 25, 50, 75, 95};
+const int MonteCarlo::NUM_OF_SCORES;
+
+static const char *const SCORE_NAMES[] = {"LifeQuality_Score", "Economy_Score", "Environment_Score"};
+
+//----------------------------------------------------------------
+//MonteCarlo Class
+//----------------------------------------------------------------
+
+MonteCarlo::MonteCarlo(const PlanStore &plans, const FacilityCatalog &facilities):
+    plans(plans),
+    facilities(facilities),
+    numOfRuns(0),
+    numOfSteps(0),
+    nextRun(0) {}
+
+void MonteCarlo::run(int numOfRuns, int numOfSteps) {
+    this->numOfRuns = numOfRuns;
+    this->numOfSteps = numOfSteps;
+    nextRun.store(0, memory_order_relaxed);
+    for (vector<int32_t> &score : scores)
+    {
+        score.assign(plans.size() * numOfRuns, 0);
+    }
+    const size_t numOfThreads = min((size_t)max(thread::hardware_concurrency(), 1u), (size_t)numOfRuns);
+    vector<thread> workers;
+    for (size_t t = 1; t < numOfThreads; t++)
+    {
+        workers.push_back(thread(&MonteCarlo::work, this));
+    }
+    work();
+    for (thread &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void MonteCarlo::work() {
+    int run;
+    while ((run = nextRun.fetch_add(1, memory_order_relaxed)) < numOfRuns)
+    {
+        runOne(run);
+    }
+}
+
+//Steps copies of the plans that build from a copy of the catalog with the run's seed
+void MonteCarlo::runOne(int run) {
+    ConstructionDelays delays = facilities.getDelays() != nullptr ? *facilities.getDelays() : ConstructionDelays();
+    delays.setSeed(delays.getSeed() + run);
+    const FacilityCatalog catalog = facilities.withDelays(make_shared<const ConstructionDelays>(delays));
+    vector<Plan> copies;
+    copies.reserve(plans.size());
+    for (const Plan &plan : plans)
+    {
+        copies.emplace_back(plan, plan.getSettlement(), catalog);
+    }
+    for (int i = 0; i < numOfSteps; i++)
+    {
+        for (Plan &plan : copies)
+        {
+            plan.step();
+        }
+    }
+    for (size_t slot = 0; slot < copies.size(); slot++)
+    {
+        const size_t index = slot * numOfRuns + run;
+        scores[0][index] = copies[slot].getlifeQualityScore();
+        scores[1][index] = copies[slot].getEconomyScore();
+        scores[2][index] = copies[slot].getEnvironmentScore();
+    }
+}
+
+//The mean and the nearest rank percentiles of every score of every plan
+void MonteCarlo::print(ostream &out) const {
+    const ios::fmtflags flags = out.flags();
+    const streamsize precision = out.precision();
+    out << "Runs: " << numOfRuns << ", steps: " << numOfSteps << endl;
+    vector<int32_t> sorted(numOfRuns);
+    size_t slot = 0;
+    for (const Plan &plan : plans)
+    {
+        out << "PlanID: " << plan.getPlanId() << endl;
+        out << "SettlementName: " << plan.getSettlementName() << endl;
+        for (int score = 0; score < NUM_OF_SCORES; score++)
+        {
+            const int32_t *first = scores[score].data() + slot * numOfRuns;
+            copy(first, first + numOfRuns, sorted.begin());
+            sort(sorted.begin(), sorted.end());
+            int64_t sum = 0;
+            for (int32_t value : sorted)
+            {
+                sum += value;
+            }
+            out << SCORE_NAMES[score] << ": mean " << fixed << setprecision(2) << (double)sum / numOfRuns;
+            for (int percentile : PERCENTILES)
+            {
+                const int rank = max((percentile * numOfRuns + 99) / 100, 1);
+                out << ", p" << percentile << ' ' << sorted[rank - 1];
+            }
+            out << endl;
+        }
+        slot++;
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
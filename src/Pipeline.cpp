@@ -0,0 +1,480 @@
+#include "Pipeline.h"
+#include "Action.h"
+#include "AllocationCounter.h"
+#include "Simulation.h"
+#include "Tracer.h"
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#include <cerrno>
+#include <unistd.h>
+
+using namespace std;
+
+const size_t CommandInput::CAPACITY;
+const size_t CommandInput::READ_SIZE;
+const size_t CommandPipeline::OUTPUT_CAPACITY;
+const size_t CommandPipeline::MAX_WRITE_PARTS;
+
+static const char *const PROMPT = "Enter an action you'd like to perform: ";
+
+//----------------------------------------------------------------
+//Doorbell Class
+//----------------------------------------------------------------
+
+Doorbell::Doorbell(): fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)), sleeping(false) {}
+
+Doorbell::~Doorbell() {
+    if (fd >= 0)
+    {
+        ::close(fd);
+    }
+}
+
+int Doorbell::getFd() const {
+    return fd;
+}
+
+//Called after changing the queue. The fence orders the change before reading 'sleeping', and
+//prepareWait() orders 'sleeping' before the waiter checks the queue again, so one of the two
+//threads always sees the other.
+void Doorbell::ring() {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (sleeping.load(memory_order_relaxed))
+    {
+        const uint64_t one = 1;
+        ssize_t written = ::write(fd, &one, sizeof(one));
+        (void)written;
+    }
+}
+
+void Doorbell::prepareWait() {
+    sleeping.store(true, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+void Doorbell::wait() {
+    if (fd < 0)
+    {
+        this_thread::yield();
+    }
+    else
+    {
+        pollfd ready = {fd, POLLIN, 0};
+        poll(&ready, 1, -1);
+    }
+    endWait();
+}
+
+void Doorbell::endWait() {
+    uint64_t count;
+    ssize_t drained = ::read(fd, &count, sizeof(count));
+    (void)drained;
+    sleeping.store(false, memory_order_relaxed);
+}
+
+//----------------------------------------------------------------
+//ParsedCommand and CommandInput
+//----------------------------------------------------------------
+
+ParsedCommand::ParsedCommand(): action(nullptr), label() {}
+
+ParsedCommand::ParsedCommand(BaseAction *action, const string &label): action(action), label(label) {}
+
+CommandInput::CommandInput(int fd): fd(fd), buffered(), atEnd(false), commands(CAPACITY), finished(false), stopped(false) {}
+
+//Deletes the actions of commands parsed after the pipeline stopped
+CommandInput::~CommandInput() {
+    ParsedCommand command;
+    while (commands.tryPop(command))
+    {
+        delete command.action;
+    }
+}
+
+//Reads the next line without its newline, like getline. Returns false at the end of input, or
+//once the pipeline stopped.
+bool CommandInput::readLine(string &line) {
+    size_t scanned = 0;
+    while (true)
+    {
+        const size_t end = buffered.find('\n', scanned);
+        if (end != string::npos)
+        {
+            line.assign(buffered, 0, end);
+            buffered.erase(0, end + 1);
+            return true;
+        }
+        scanned = buffered.size();
+        if (atEnd)
+        {
+            line.swap(buffered);
+            buffered.clear();
+            return !line.empty();
+        }
+        pollfd ready[2] = {{fd, POLLIN, 0}, {stopping.getFd(), POLLIN, 0}};
+        stopping.prepareWait();
+        if (stopped.load(memory_order_acquire))
+        {
+            stopping.endWait();
+            return false;
+        }
+        const int polled = poll(ready, 2, -1);
+        stopping.endWait();
+        if (polled < 0 && errno != EINTR)
+        {
+            atEnd = true;
+            continue;
+        }
+        if (polled <= 0 || ready[0].revents == 0)
+        {
+            continue;
+        }
+        char chunk[READ_SIZE];
+        const ssize_t length = ::read(fd, chunk, sizeof(chunk));
+        if (length > 0)
+        {
+            buffered.append(chunk, length);
+        }
+        else if (length == 0 || (errno != EINTR && errno != EAGAIN))
+        {
+            atEnd = true;
+        }
+    }
+}
+
+//----------------------------------------------------------------
+//OutputBuffer Class
+//----------------------------------------------------------------
+
+OutputBuffer::int_type OutputBuffer::overflow(int_type c) {
+    UncountedAllocations uncounted;
+    return stringbuf::overflow(c);
+}
+
+streamsize OutputBuffer::xsputn(const char *text, streamsize length) {
+    UncountedAllocations uncounted;
+    return stringbuf::xsputn(text, length);
+}
+
+//----------------------------------------------------------------
+//CommandPipeline Class
+//----------------------------------------------------------------
+
+CommandPipeline::CommandPipeline(Simulation &simulation, int inputFd):
+    simulation(simulation),
+    output(simulation.out()),
+    buffer(),
+    rendered(&buffer),
+    input(inputFd),
+    pending(),
+    hasPending(false),
+    statuses(),
+    outputs(OUTPUT_CAPACITY),
+    outputFd(&output == &cout ? STDOUT_FILENO : -1),
+    executed(false) {
+        output.flush();
+        simulation.setOutput(rendered);
+        simulation.pipeline = this;
+        parser = thread(&CommandPipeline::parse, this);
+        writer = thread(&CommandPipeline::write, this);
+}
+
+//Stops parsing, writes the remaining output and gives the simulation its output back. The parsing
+//thread is joined here, even when it is waiting for input, so no command is parsed after start()
+//returned.
+CommandPipeline::~CommandPipeline() {
+    input.stopped.store(true, memory_order_release);
+    input.hasRoom.ring();
+    input.stopping.ring();
+    parser.join();
+    flush();
+    executed.store(true, memory_order_release);
+    hasOutputs.ring();
+    writer.join();
+    simulation.setOutput(output);
+    simulation.pipeline = nullptr;
+    if (hasPending)
+    {
+        delete pending.action;
+    }
+}
+
+//Waits for the next command, returns false at the end of input
+bool CommandPipeline::next(ParsedCommand &command) {
+    input.hasCommands.waitUntil([this] {
+        return hasNext();
+    });
+    return tryNext(command);
+}
+
+//True if there is a command to take or the input ended
+bool CommandPipeline::hasNext() const {
+    return hasPending || !input.commands.isEmpty() || input.finished.load(memory_order_acquire);
+}
+
+bool CommandPipeline::tryNext(ParsedCommand &command) {
+    if (hasPending)
+    {
+        command = pending;
+        pending = ParsedCommand();
+        hasPending = false;
+        return true;
+    }
+    if (!input.commands.tryPop(command))
+    {
+        return false;
+    }
+    input.hasRoom.ring();
+    return true;
+}
+
+bool CommandPipeline::isFinished() const {
+    return !hasPending && input.finished.load(memory_order_acquire) && input.commands.isEmpty();
+}
+
+//Performs a command and hands its output, prompt included, to the output stage
+void CommandPipeline::perform(ParsedCommand &command) {
+    rendered << PROMPT;
+    if (command.action != nullptr)
+    {
+        TraceSpan span("command");
+        simulation.perform(command.label, command.action);
+        command.action = nullptr;
+    }
+    flush();
+}
+
+//Performs a command, together with the steps parsed right after it if it is a step, or by reusing
+//the output of the same planStatus if nothing changed the plans since
+void CommandPipeline::performCoalesced(ParsedCommand &command) {
+    if (command.label == "step" && canMergeSteps())
+    {
+        performSteps(command);
+        return;
+    }
+    if (command.label == "planStatus")
+    {
+        performStatus(command);
+        return;
+    }
+    if (!isRead(command.label))
+    {
+        statuses.clear();
+    }
+    perform(command);
+}
+
+//Merged steps write their prompts first and log their entries last, so they must not write or log
+//anything else. Stepping plans in memory never does, but an autosaver logs the checkpoints it
+//failed to write as the ticks pass, and a recorder reports the step it failed to write in. Merged
+//steps are also not held to the allocation budget of a single step.
+bool CommandPipeline::canMergeSteps() const {
+    return simulation.planRecords == nullptr && simulation.autosaver == nullptr && simulation.recorder == nullptr &&
+        !simulation.plans.empty() && !AllocationCounter::isEnabled();
+}
+
+//Steps once for the step and the steps queued after it, and logs each of them
+void CommandPipeline::performSteps(ParsedCommand &command) {
+    vector<SimulateStep*> steps(1, static_cast<SimulateStep*>(command.action));
+    command.action = nullptr;
+    ParsedCommand following;
+    while (tryNext(following))
+    {
+        if (following.label != "step")
+        {
+            pending = following;
+            hasPending = true;
+            break;
+        }
+        steps.push_back(static_cast<SimulateStep*>(following.action));
+    }
+    for (size_t i = 0; i < steps.size(); i++)
+    {
+        rendered << PROMPT;
+    }
+    {
+        TraceSpan span("command");
+        SimulateStep::actMerged(simulation, steps);
+    }
+    for (SimulateStep *step : steps)
+    {
+        simulation.addAction(step);
+    }
+    statuses.clear();
+    flush();
+}
+
+void CommandPipeline::performStatus(ParsedCommand &command) {
+    const int planId = static_cast<PrintPlanStatus*>(command.action)->getPlanId();
+    ActionLog &actionsLog = simulation.getActionsLog();
+    const auto found = statuses.find(planId);
+    if (found != statuses.end())
+    {
+        delete command.action;
+        command.action = nullptr;
+        rendered << PROMPT << found->second.text;
+        actionsLog.append(found->second.record);
+        flush();
+        return;
+    }
+    rendered << PROMPT;
+    const streamoff begin = rendered.tellp();
+    {
+        TraceSpan span("command");
+        simulation.perform(command.label, command.action);
+        command.action = nullptr;
+    }
+    RenderedStatus &status = statuses[planId];
+    status.text = buffer.str().substr(begin);
+    status.record = actionsLog.get(actionsLog.size() - 1);
+    flush();
+}
+
+//The parsing stage
+void CommandPipeline::parse() {
+    string line;
+    while (!input.stopped.load(memory_order_acquire) && input.readLine(line))
+    {
+        ParsedCommand command;
+        {
+            TraceSpan span("parse");
+            command.action = Simulation::parse(line, command.label);
+        }
+        input.hasRoom.waitUntil([this] {
+            return input.stopped.load(memory_order_acquire) || !input.commands.isFull();
+        });
+        if (input.stopped.load(memory_order_acquire))
+        {
+            delete command.action;
+            break;
+        }
+        input.commands.tryPush(command);
+        input.hasCommands.ring();
+    }
+    input.finished.store(true, memory_order_release);
+    input.hasCommands.ring();
+}
+
+//Commands that never change the plans, and so never change what a planStatus prints
+bool CommandPipeline::isRead(const string &label) const {
+    return label == "planStatus" || label == "digest" || label == "log" || label == "summary" ||
+        label == "top" || label == "query";
+}
+
+//Hands what the simulation wrote since the last flush to the output stage
+void CommandPipeline::flush() {
+    if (rendered.tellp() <= 0)
+    {
+        return;
+    }
+    string text = buffer.str();
+    buffer.str("");
+    handOn(text);
+}
+
+//Hands text rendered apart from the simulation's output on to the output stage, after what the
+//simulation wrote, without copying it
+void CommandPipeline::handOn(vector<string> &parts) {
+    flush();
+    for (string &part : parts)
+    {
+        if (!part.empty())
+        {
+            handOn(part);
+        }
+    }
+}
+
+void CommandPipeline::handOn(string &text) {
+    hasOutputRoom.waitUntil([this] {
+        return !outputs.isFull();
+    });
+    outputs.tryPush(text);
+    hasOutputs.ring();
+}
+
+//The file descriptor that becomes readable when a command was parsed, for waiting on it with other
+//events. Call prepareWait() before checking for commands and waiting, and endWait() after.
+int CommandPipeline::getFd() const {
+    return input.hasCommands.getFd();
+}
+
+void CommandPipeline::prepareWait() {
+    input.hasCommands.prepareWait();
+}
+
+void CommandPipeline::endWait() {
+    input.hasCommands.endWait();
+}
+
+//The output stage. Takes everything that was handed on at once, and writes it to standard output
+//with one writev.
+void CommandPipeline::write() {
+    vector<string> texts;
+    string text;
+    while (true)
+    {
+        while (texts.size() < MAX_WRITE_PARTS && outputs.tryPop(text))
+        {
+            texts.push_back(move(text));
+            hasOutputRoom.ring();
+        }
+        if (!texts.empty())
+        {
+            writeOut(texts);
+            texts.clear();
+            continue;
+        }
+        output.flush();
+        if (executed.load(memory_order_acquire) && outputs.isEmpty())
+        {
+            break;
+        }
+        hasOutputs.waitUntil([this] {
+            return !outputs.isEmpty() || executed.load(memory_order_acquire);
+        });
+    }
+}
+
+void CommandPipeline::writeOut(const vector<string> &texts) {
+    if (outputFd < 0)
+    {
+        for (const string &text : texts)
+        {
+            output.write(text.data(), text.size());
+        }
+        return;
+    }
+    parts.clear();
+    for (const string &text : texts)
+    {
+        iovec part = {const_cast<char*>(text.data()), text.size()};
+        parts.push_back(part);
+    }
+    size_t first = 0;
+    while (first < parts.size())
+    {
+        const ssize_t written = writev(outputFd, parts.data() + first, parts.size() - first);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return;
+        }
+        //Skips what was written, which may end inside a part
+        size_t left = written;
+        while (first < parts.size() && left >= parts[first].iov_len)
+        {
+            left -= parts[first].iov_len;
+            first++;
+        }
+        if (first < parts.size())
+        {
+            parts[first].iov_base = (char*)parts[first].iov_base + left;
+            parts[first].iov_len -= left;
+        }
+    }
+}
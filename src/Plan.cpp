@@ -3,28 +3,46 @@
 #include "Settlement.h"
 #include "SelectionPolicy.h"
 #include "Facility.h"
+#include "Renderer.h"
+#include "Digest.h"
+#include "Tracer.h"
 #include<iostream>
 using namespace std;
 
-Plan::Plan(const int planId, const Settlement &settlement, SelectionPolicy *selectionPolicy, const vector<FacilityType> &facilityOptions):
+void PlanObserver::onFacilitySelected(const Plan &, const Facility &) {}
+
+Plan::Plan(const int planId, const Settlement &settlement, SelectionPolicy *selectionPolicy, const FacilityCatalog &facilityOptions):
     plan_id(planId),
     settlement(const_cast<Settlement&>(settlement)),
-    selectionPolicy(selectionPolicy),
+    selectionPolicy(nullptr),
     status(PlanStatus::AVAILABLE),
     facilities(vector<Facility*>()), 
     underConstruction(vector<Facility*>()),
     facilityOptions(facilityOptions),
-    life_quality_score(0), economy_score(0), environment_score(0){}
+    life_quality_score(0), economy_score(0), environment_score(0), operationalDigest(Digest::SEED){
+        setSelectionPolicy(selectionPolicy);
+}
+
+Plan::Plan(const int planId, const Settlement &settlement, const PolicyState &policy, const FacilityCatalog &facilityOptions):
+    plan_id(planId),
+    settlement(const_cast<Settlement&>(settlement)),
+    policy(policy),
+    selectionPolicy(nullptr),
+    status(PlanStatus::AVAILABLE),
+    facilityOptions(facilityOptions),
+    life_quality_score(0), economy_score(0), environment_score(0), operationalDigest(Digest::SEED){}
 
 Plan::Plan(const Plan& other)
   : plan_id(other.getPlanId()),
     settlement(other.settlement),
-    selectionPolicy(other.selectionPolicy->clone()),
+    policy(other.policy),
+    selectionPolicy(other.selectionPolicy != nullptr ? other.selectionPolicy->clone() : nullptr),
     status(other.status),
     facilityOptions(other.facilityOptions),
     life_quality_score(other.getlifeQualityScore()),
     economy_score(other.getEconomyScore()),
-    environment_score(other.getEnvironmentScore()) {
+    environment_score(other.getEnvironmentScore()),
+    operationalDigest(other.operationalDigest) {
         for(Facility* ptr : other.facilities)
         {
             facilities.push_back(ptr->clone());
@@ -36,15 +54,18 @@ Plan::Plan(const Plan& other)
 }
 
 
-Plan::Plan(const Plan& other, Settlement* set)
+//Copies a plan into another simulation, with that simulation's copy of the settlement and its facility options
+Plan::Plan(const Plan& other, const Settlement &settlement, const FacilityCatalog &facilityOptions)
 : plan_id(other.getPlanId()),
-    settlement(*set),
-    selectionPolicy(other.selectionPolicy->clone()),
+    settlement(settlement),
+    policy(other.policy),
+    selectionPolicy(other.selectionPolicy != nullptr ? other.selectionPolicy->clone() : nullptr),
     status(other.status),
-    facilityOptions(other.facilityOptions),
+    facilityOptions(facilityOptions),
     life_quality_score(other.getlifeQualityScore()),
     economy_score(other.getEconomyScore()),
-    environment_score(other.getEnvironmentScore()) {
+    environment_score(other.getEnvironmentScore()),
+    operationalDigest(other.operationalDigest) {
         for(Facility* ptr : other.facilities)
         {
             facilities.push_back(ptr->clone());
@@ -60,8 +81,9 @@ Plan& Plan::operator=(const Plan& other) {
     {
         plan_id = other.plan_id;
         const_cast<Settlement&>(settlement) = other.settlement;
+        policy = other.policy;
         delete selectionPolicy;
-        selectionPolicy = other.selectionPolicy->clone();
+        selectionPolicy = other.selectionPolicy != nullptr ? other.selectionPolicy->clone() : nullptr;
         for (Facility* facility : facilities)
         {
             delete facility;
@@ -81,17 +103,19 @@ Plan& Plan::operator=(const Plan& other) {
         }
         
         status = other.status;
-        const_cast<vector<FacilityType>&>(facilityOptions) = other.facilityOptions;
+        const_cast<FacilityCatalog&>(facilityOptions) = other.facilityOptions;
         life_quality_score = other.life_quality_score;
         economy_score = other.economy_score;
         environment_score = other.environment_score;
+        operationalDigest = other.operationalDigest;
     }
     return *this;
 }
 
-Plan::Plan(Plan&& other)
+Plan::Plan(Plan&& other) noexcept
     : plan_id(other.plan_id),
       settlement(move(other.settlement)),
+      policy(other.policy),
       selectionPolicy(move(other.selectionPolicy)),
       status(other.status),
       facilities(move(other.facilities)),
@@ -99,7 +123,8 @@ Plan::Plan(Plan&& other)
       facilityOptions(move(other.facilityOptions)),
       life_quality_score(other.life_quality_score),
       economy_score(other.economy_score),
-      environment_score(other.environment_score) {
+      environment_score(other.environment_score),
+      operationalDigest(other.operationalDigest) {
         other.selectionPolicy = nullptr;
       }
 
@@ -108,7 +133,8 @@ Plan& Plan::operator=(Plan&& other) noexcept {
     {
         plan_id = other.plan_id;
         const_cast<Settlement&>(settlement) = other.settlement;
-        const_cast<vector<FacilityType>&>(facilityOptions) = other.facilityOptions;
+        const_cast<FacilityCatalog&>(facilityOptions) = other.facilityOptions;
+        policy = other.policy;
         delete selectionPolicy;
         selectionPolicy = other.selectionPolicy;
         other.selectionPolicy = nullptr;
@@ -126,6 +152,7 @@ Plan& Plan::operator=(Plan&& other) noexcept {
         life_quality_score = other.life_quality_score;
         economy_score = other.economy_score;
         environment_score = other.environment_score;
+        operationalDigest = other.operationalDigest;
     }
     return *this;
 }
@@ -141,22 +168,104 @@ const int Plan::getEnvironmentScore() const {
     return environment_score;
 }
 
+//Takes ownership of the policy. A built in policy is kept as an inline PolicyState and deleted.
 void Plan::setSelectionPolicy(SelectionPolicy *selectionPolicy) {
-    this->selectionPolicy=selectionPolicy;
+    if (this->selectionPolicy != selectionPolicy)
+    {
+        delete this->selectionPolicy;
+    }
+    this->selectionPolicy = selectionPolicy;
+    policy = PolicyState();
+    if (selectionPolicy != nullptr && selectionPolicy->getState(policy))
+    {
+        delete selectionPolicy;
+        this->selectionPolicy = nullptr;
+    }
+}
+
+void Plan::setSelectionPolicy(const PolicyState &policy) {
+    delete selectionPolicy;
+    selectionPolicy = nullptr;
+    this->policy = policy;
 }
   
-void Plan::step(){
-    while (status == PlanStatus::AVAILABLE)
+template <PolicyKind KIND>
+const FacilityType &Plan::selectFacility() {
+    return policy.select<KIND>(facilityOptions);
+}
+
+template <>
+const FacilityType &Plan::selectFacility<PolicyKind::CUSTOM>() {
+    return selectionPolicy->selectFacility(facilityOptions);
+}
+
+//The step loop of one construction limit and one policy kind, see step()
+template <size_t LIMIT, PolicyKind KIND>
+void Plan::step(PlanObserver *observer) {
+    if (status == PlanStatus::AVAILABLE)
     {
-        Facility* facil = new Facility(const_cast<FacilityType&>(selectionPolicy->selectFacility(facilityOptions)), settlement.Settlement::getName());
-        underConstruction.push_back(facil);
-        if ((settlement.getType() == SettlementType::VILLAGE && underConstruction.size() == 1 ) ||
-            (settlement.getType() == SettlementType::CITY && underConstruction.size() == 2) || 
-            (settlement.getType() == SettlementType::METROPOLIS && underConstruction.size() == 3))
+        TraceSpan span("select", Tracer::PLANS, plan_id);
+        while (status == PlanStatus::AVAILABLE)
         {
-            status = PlanStatus::BUSY;
+            const FacilityType &type = selectFacility<KIND>();
+            const ConstructionDelays *delays = facilityOptions.getDelays();
+            Facility* facil = delays == nullptr ? new Facility(type, settlement.Settlement::getNameSymbol())
+                : new Facility(type, settlement.Settlement::getNameSymbol(), delays->getDuration(type, plan_id, facilities.size() + underConstruction.size()));
+            underConstruction.push_back(facil);
+            if (underConstruction.size() == LIMIT)
+            {
+                status = PlanStatus::BUSY;
+            }
+            if (observer != nullptr)
+            {
+                observer->onFacilitySelected(*this, *facil);
+            }
         }
     }
+    TraceSpan span("construct", Tracer::PLANS, plan_id);
+    advanceConstruction(observer);
+}
+
+template <size_t LIMIT>
+void Plan::step(PlanObserver *observer) {
+    switch (policy.kind)
+    {
+        case PolicyKind::NAIVE:
+            step<LIMIT, PolicyKind::NAIVE>(observer);
+            break;
+        case PolicyKind::BALANCED:
+            step<LIMIT, PolicyKind::BALANCED>(observer);
+            break;
+        case PolicyKind::ECONOMY:
+            step<LIMIT, PolicyKind::ECONOMY>(observer);
+            break;
+        case PolicyKind::SUSTAINABILITY:
+            step<LIMIT, PolicyKind::SUSTAINABILITY>(observer);
+            break;
+        case PolicyKind::CUSTOM:
+            step<LIMIT, PolicyKind::CUSTOM>(observer);
+            break;
+    }
+}
+
+//Dispatches once per step on the settlement type and the policy kind, so the selection loop has
+//its construction limit as a constant and calls the policy directly
+void Plan::step(PlanObserver *observer){
+    switch (settlement.getType())
+    {
+        case SettlementType::VILLAGE:
+            step<1>(observer);
+            break;
+        case SettlementType::CITY:
+            step<2>(observer);
+            break;
+        case SettlementType::METROPOLIS:
+            step<3>(observer);
+            break;
+    }
+}
+
+void Plan::advanceConstruction(PlanObserver *observer) {
     size_t i = 0;
     while (i < underConstruction.size()) 
     {
@@ -169,6 +278,11 @@ void Plan::step(){
             life_quality_score += ptr->getLifeQualityScore();
             economy_score += ptr->getEconomyScore();
             environment_score += ptr->getEnvironmentScore();
+            operationalDigest = Digest::mix(operationalDigest, ptr->getName());
+            if (observer != nullptr)
+            {
+                observer->onFacilityOperational(*this, *ptr);
+            }
         }
         else 
         {
@@ -176,6 +290,7 @@ void Plan::step(){
         }
     }
 }
+
 void Plan::printStatus() {
     if (status == PlanStatus::AVAILABLE)
     {
@@ -198,6 +313,10 @@ const string Plan::getStatus() const {
     }
 }
 
+PlanStatus Plan::getPlanStatus() const {
+    return status;
+}
+
 const vector<Facility*>& Plan::getFacilities() const {
     return facilities;
 }
@@ -206,6 +325,10 @@ const vector<Facility*>& Plan::getUnderConstructionFacilities() const {
     return underConstruction;
 }
 
+const Settlement& Plan::getSettlement() const {
+    return settlement;
+}
+
 const string& Plan::getSettlementName() const {
     return settlement.getName();
 }
@@ -215,26 +338,77 @@ const SettlementType Plan::getSettlementType() const{
 }
 
 
-const string Plan::getSelectionPolicyName() const {
-    return selectionPolicy->toString();
+const string &Plan::getSelectionPolicyName() const {
+    if (policy.kind == PolicyKind::CUSTOM)
+    {
+        return selectionPolicy->toString();
+    }
+    return PolicyState::getName(policy.kind);
+}
+
+uint32_t Plan::getSelectionPolicySymbol() const {
+    if (policy.kind == PolicyKind::CUSTOM)
+    {
+        return selectionPolicy->getNameSymbol();
+    }
+    return PolicyState::getSymbol(policy.kind);
+}
+
+PolicyKind Plan::getPolicyKind() const {
+    return policy.kind;
+}
+
+const PolicyState &Plan::getPolicyState() const {
+    return policy;
+}
+
+//Only plans with a CUSTOM policy have a policy object, for the others this is null
+const SelectionPolicy *Plan::getSelectionPolicy() const {
+    return selectionPolicy;
 }
 
 void Plan::addFacility(Facility* facility) {
     facilities.push_back(facility);
+    operationalDigest = Digest::mix(operationalDigest, facility->getName());
+}
+
+//The digest of the plan's state: its operational facilities in the order they became operational,
+//the facilities under construction with their time left, its scores, status and policy state
+uint64_t Plan::getDigest() const {
+    uint64_t digest = Digest::mix(operationalDigest, (uint64_t)status);
+    digest = Digest::mix(digest, (uint64_t)life_quality_score);
+    digest = Digest::mix(digest, (uint64_t)economy_score);
+    digest = Digest::mix(digest, (uint64_t)environment_score);
+    for (const Facility *facility : underConstruction)
+    {
+        digest = Digest::mix(digest, facility->getName());
+        digest = Digest::mix(digest, (uint64_t)facility->getTimeLeft());
+    }
+    digest = Digest::mix(digest, (uint64_t)policy.kind);
+    if (policy.kind == PolicyKind::CUSTOM)
+    {
+        return selectionPolicy->mixDigest(digest);
+    }
+    digest = Digest::mix(digest, (uint64_t)policy.lastSelectedIndex);
+    digest = Digest::mix(digest, (uint64_t)policy.lifeQualityScore);
+    digest = Digest::mix(digest, (uint64_t)policy.economyScore);
+    return Digest::mix(digest, (uint64_t)policy.environmentScore);
 }
 
 const string Plan::toString() const {
     string str;
-    str += "this is plan number " + to_string(plan_id) + "for the settlement " + settlement.getName() + "\n";
-    str += "Current status: ";
+    ReportRenderer renderer(str);
+    renderer << "this is plan number " << plan_id << "for the settlement " << settlement.getName() << '\n';
+    renderer << "Current status: ";
     if (status == PlanStatus::AVAILABLE)
     {
-        str += "Available\n";
+        renderer << "Available\n";
     }
     else if (status == PlanStatus::BUSY) 
     {
-        str += "Busy\n";
+        renderer << "Busy\n";
     }
+    renderer.flush();
     return str;
 }
 
@@ -0,0 +1,436 @@
+#include "PlanQuery.h"
+#include "SelectionPolicy.h"
+#include "SymbolTable.h"
+#include <algorithm>
+#include <functional>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+//----------------------------------------------------------------
+//PlanColumns Class
+//----------------------------------------------------------------
+
+PlanColumns::PlanColumns() {
+    clear();
+}
+
+void PlanColumns::clear() {
+    for (vector<int32_t> &column : columns)
+    {
+        column.clear();
+    }
+    settlementNames.clear();
+    settlementIds.clear();
+    policyNames.clear();
+    policyIds.clear();
+    //The built in policies have ids from the start, so the first plan of one does not allocate
+    for (int kind = 0; kind < (int)PolicyKind::CUSTOM; kind++)
+    {
+        intern(PolicyState::getSymbol((PolicyKind)kind), policyNames, policyIds);
+    }
+}
+
+void PlanColumns::rebuild(const PlanStore &plans) {
+    clear();
+    for (vector<int32_t> &column : columns)
+    {
+        column.reserve(plans.size());
+    }
+    for (const Plan &plan : plans)
+    {
+        addPlan(plan);
+    }
+}
+
+void PlanColumns::reserve(size_t numOfPlans, size_t numOfSettlements) {
+    for (vector<int32_t> &column : columns)
+    {
+        column.reserve(numOfPlans);
+    }
+    settlementNames.reserve(numOfSettlements);
+    settlementIds.reserve(numOfSettlements);
+}
+
+void PlanColumns::addSettlement(uint32_t settlementName) {
+    intern(settlementName, settlementNames, settlementIds);
+}
+
+void PlanColumns::addPlan(const Plan &plan) {
+    const size_t row = plan.getPlanId();
+    if (row >= size())
+    {
+        for (vector<int32_t> &column : columns)
+        {
+            column.resize(row + 1, -1);
+        }
+    }
+    columns[(int)PlanField::ID][row] = plan.getPlanId();
+    columns[(int)PlanField::SETTLEMENT][row] = intern(plan.getSettlement().getNameSymbol(), settlementNames, settlementIds);
+    columns[(int)PlanField::TYPE][row] = (int32_t)plan.getSettlementType();
+    columns[(int)PlanField::POLICY][row] = intern(plan.getSelectionPolicySymbol(), policyNames, policyIds);
+    columns[(int)PlanField::STATUS][row] = (int32_t)plan.getPlanStatus();
+    columns[(int)PlanField::LIFE_QUALITY][row] = plan.getlifeQualityScore();
+    columns[(int)PlanField::ECONOMY][row] = plan.getEconomyScore();
+    columns[(int)PlanField::ENVIRONMENT][row] = plan.getEnvironmentScore();
+    columns[(int)PlanField::OPERATIONAL][row] = plan.getFacilities().size();
+    columns[(int)PlanField::CONSTRUCTION][row] = plan.getUnderConstructionFacilities().size();
+}
+
+void PlanColumns::changePolicy(const Plan &plan) {
+    columns[(int)PlanField::POLICY][plan.getPlanId()] = intern(plan.getSelectionPolicySymbol(), policyNames, policyIds);
+}
+
+void PlanColumns::onFacilitySelected(const Plan &plan, const Facility &) {
+    const size_t row = plan.getPlanId();
+    columns[(int)PlanField::CONSTRUCTION][row]++;
+    columns[(int)PlanField::STATUS][row] = (int32_t)plan.getPlanStatus();
+}
+
+void PlanColumns::onFacilityOperational(const Plan &plan, const Facility &) {
+    const size_t row = plan.getPlanId();
+    columns[(int)PlanField::STATUS][row] = (int32_t)plan.getPlanStatus();
+    columns[(int)PlanField::LIFE_QUALITY][row] = plan.getlifeQualityScore();
+    columns[(int)PlanField::ECONOMY][row] = plan.getEconomyScore();
+    columns[(int)PlanField::ENVIRONMENT][row] = plan.getEnvironmentScore();
+    columns[(int)PlanField::OPERATIONAL][row]++;
+    columns[(int)PlanField::CONSTRUCTION][row]--;
+}
+
+size_t PlanColumns::size() const {
+    return columns[0].size();
+}
+
+const int32_t *PlanColumns::getColumn(PlanField field) const {
+    return columns[(int)field].data();
+}
+
+int PlanColumns::getSettlementId(const string &settlementName) const {
+    return findId(settlementName, settlementIds);
+}
+
+int PlanColumns::getPolicyId(const string &policyName) const {
+    return findId(policyName, policyIds);
+}
+
+const string &PlanColumns::getSettlementName(int settlementId) const {
+    return SymbolTable::resolve(settlementNames[settlementId]);
+}
+
+const string &PlanColumns::getPolicyName(int policyId) const {
+    return SymbolTable::resolve(policyNames[policyId]);
+}
+
+//The rank of every settlement or policy id when the names are sorted, for ordering by name
+void PlanColumns::getNameRanks(PlanField field, vector<int32_t> &ranks) const {
+    const vector<uint32_t> &names = field == PlanField::SETTLEMENT ? settlementNames : policyNames;
+    vector<int32_t> ids(names.size());
+    for (size_t i = 0; i < ids.size(); i++)
+    {
+        ids[i] = i;
+    }
+    sort(ids.begin(), ids.end(), [&names](int32_t a, int32_t b) {
+        return SymbolTable::resolve(names[a]) < SymbolTable::resolve(names[b]);
+    });
+    ranks.resize(ids.size());
+    for (size_t rank = 0; rank < ids.size(); rank++)
+    {
+        ranks[ids[rank]] = rank;
+    }
+}
+
+int PlanColumns::findId(const string &name, const unordered_map<uint32_t, int> &ids) {
+    uint32_t symbol;
+    if (!SymbolTable::find(name, symbol))
+    {
+        return -1;
+    }
+    unordered_map<uint32_t, int>::const_iterator it = ids.find(symbol);
+    return it == ids.end() ? -1 : it->second;
+}
+
+int PlanColumns::intern(uint32_t name, vector<uint32_t> &names, unordered_map<uint32_t, int> &ids) {
+    unordered_map<uint32_t, int>::iterator it = ids.find(name);
+    if (it != ids.end())
+    {
+        return it->second;
+    }
+    ids[name] = names.size();
+    names.push_back(name);
+    return names.size() - 1;
+}
+
+//----------------------------------------------------------------
+//PlanQuery Class
+//----------------------------------------------------------------
+
+PlanQuery::PlanQuery(): conditions(), ordered(false), orderField(PlanField::ID), descending(false), limit((size_t)-1) {}
+
+bool PlanQuery::parse(const string &query, const PlanColumns &columns) {
+    istringstream iss(query);
+    vector<string> tokens;
+    string token;
+    while (iss >> token)
+    {
+        tokens.push_back(token);
+    }
+    size_t i = 0;
+    if (i >= tokens.size() || tokens[i++] != "plans")
+    {
+        return false;
+    }
+    if (i < tokens.size() && tokens[i] == "where")
+    {
+        do
+        {
+            i++;
+            Condition condition;
+            if (i + 3 > tokens.size() || !parseField(tokens[i], condition.field) || !parseOperator(tokens[i + 1], condition.op) ||
+                !parseValue(condition.field, tokens[i + 2], columns, condition.value))
+            {
+                return false;
+            }
+            //Names have no order by id
+            const bool named = condition.field == PlanField::SETTLEMENT || condition.field == PlanField::POLICY;
+            if (named && condition.op != EQUAL && condition.op != NOT_EQUAL)
+            {
+                return false;
+            }
+            conditions.push_back(condition);
+            i += 3;
+        } while (i < tokens.size() && tokens[i] == "and");
+    }
+    if (i < tokens.size() && tokens[i] == "order")
+    {
+        if (i + 3 > tokens.size() || tokens[i + 1] != "by" || !parseField(tokens[i + 2], orderField))
+        {
+            return false;
+        }
+        ordered = true;
+        i += 3;
+        if (i < tokens.size() && (tokens[i] == "asc" || tokens[i] == "desc"))
+        {
+            descending = tokens[i] == "desc";
+            i++;
+        }
+    }
+    if (i < tokens.size() && tokens[i] == "limit")
+    {
+        if (i + 2 > tokens.size())
+        {
+            return false;
+        }
+        int value;
+        istringstream number(tokens[i + 1]);
+        if (!(number >> value) || value < 0)
+        {
+            return false;
+        }
+        limit = value;
+        i += 2;
+    }
+    return i == tokens.size();
+}
+
+void PlanQuery::run(const PlanColumns &columns, vector<uint32_t> &result) const {
+    result.clear();
+    const size_t numOfRows = columns.size();
+    size_t numOfThreads = thread::hardware_concurrency();
+    if (numOfRows < PARALLEL_THRESHOLD || numOfThreads < 2)
+    {
+        scan(columns, 0, numOfRows, result);
+    }
+    else
+    {
+        vector<vector<uint32_t>> parts(numOfThreads);
+        vector<thread> workers;
+        for (size_t t = 1; t < numOfThreads; t++)
+        {
+            workers.push_back(thread(&PlanQuery::scan, this, cref(columns), numOfRows * t / numOfThreads,
+                numOfRows * (t + 1) / numOfThreads, ref(parts[t])));
+        }
+        scan(columns, 0, numOfRows / numOfThreads, parts[0]);
+        for (thread &worker : workers)
+        {
+            worker.join();
+        }
+        for (const vector<uint32_t> &part : parts)
+        {
+            result.insert(result.end(), part.begin(), part.end());
+        }
+    }
+    if (ordered)
+    {
+        const int32_t *column = columns.getColumn(orderField);
+        const int32_t *keys = column;
+        vector<int32_t> ranked;
+        if (orderField == PlanField::SETTLEMENT || orderField == PlanField::POLICY)
+        {
+            vector<int32_t> ranks;
+            columns.getNameRanks(orderField, ranks);
+            ranked.resize(columns.size());
+            for (uint32_t row : result)
+            {
+                ranked[row] = ranks[column[row]];
+            }
+            keys = ranked.data();
+        }
+        const bool desc = descending;
+        auto before = [keys, desc](uint32_t a, uint32_t b) {
+            if (keys[a] != keys[b])
+            {
+                return desc ? keys[a] > keys[b] : keys[a] < keys[b];
+            }
+            return a < b;
+        };
+        if (limit < result.size())
+        {
+            partial_sort(result.begin(), result.begin() + limit, result.end(), before);
+        }
+        else
+        {
+            sort(result.begin(), result.end(), before);
+        }
+    }
+    if (limit < result.size())
+    {
+        result.resize(limit);
+    }
+}
+
+template <typename Compare>
+static void filter(const int32_t *column, int32_t value, unsigned char *mask, size_t numOfRows, Compare compare) {
+    for (size_t i = 0; i < numOfRows; i++)
+    {
+        mask[i] &= (unsigned char)compare(column[i], value);
+    }
+}
+
+void PlanQuery::scan(const PlanColumns &columns, size_t begin, size_t end, vector<uint32_t> &rows) const {
+    const size_t numOfRows = end - begin;
+    vector<unsigned char> mask(numOfRows, 1);
+    for (const Condition &condition : conditions)
+    {
+        const int32_t *column = columns.getColumn(condition.field) + begin;
+        switch (condition.op)
+        {
+            case EQUAL:
+                filter(column, condition.value, mask.data(), numOfRows, equal_to<int32_t>());
+                break;
+            case NOT_EQUAL:
+                filter(column, condition.value, mask.data(), numOfRows, not_equal_to<int32_t>());
+                break;
+            case LESS:
+                filter(column, condition.value, mask.data(), numOfRows, less<int32_t>());
+                break;
+            case LESS_EQUAL:
+                filter(column, condition.value, mask.data(), numOfRows, less_equal<int32_t>());
+                break;
+            case GREATER:
+                filter(column, condition.value, mask.data(), numOfRows, greater<int32_t>());
+                break;
+            case GREATER_EQUAL:
+                filter(column, condition.value, mask.data(), numOfRows, greater_equal<int32_t>());
+                break;
+        }
+    }
+    const int32_t *ids = columns.getColumn(PlanField::ID) + begin;
+    for (size_t i = 0; i < numOfRows; i++)
+    {
+        if (mask[i] && ids[i] >= 0)
+        {
+            rows.push_back(begin + i);
+        }
+    }
+}
+
+void PlanQuery::print(ostream &out, const PlanColumns &columns, uint32_t row) {
+    static const char *TYPES[] = {"village", "city", "metropolis"};
+    out << "PlanID: " << columns.getColumn(PlanField::ID)[row]
+        << ", SettlementName: " << columns.getSettlementName(columns.getColumn(PlanField::SETTLEMENT)[row])
+        << ", Type: " << TYPES[columns.getColumn(PlanField::TYPE)[row]]
+        << ", Policy: " << columns.getPolicyName(columns.getColumn(PlanField::POLICY)[row])
+        << ", Status: " << (columns.getColumn(PlanField::STATUS)[row] == (int32_t)PlanStatus::AVAILABLE ? "Available" : "Busy")
+        << ", LifeQuality_Score: " << columns.getColumn(PlanField::LIFE_QUALITY)[row]
+        << ", Economy_Score: " << columns.getColumn(PlanField::ECONOMY)[row]
+        << ", Environment_Score: " << columns.getColumn(PlanField::ENVIRONMENT)[row]
+        << ", Operational: " << columns.getColumn(PlanField::OPERATIONAL)[row]
+        << ", UnderConstruction: " << columns.getColumn(PlanField::CONSTRUCTION)[row] << endl;
+}
+
+bool PlanQuery::parseField(const string &name, PlanField &field) {
+    static const char *NAMES[] = {"id", "settlement", "type", "policy", "status", "life", "eco", "env", "operational", "construction"};
+    for (int i = 0; i < PlanColumns::NUM_OF_FIELDS; i++)
+    {
+        if (name == NAMES[i])
+        {
+            field = (PlanField)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PlanQuery::parseOperator(const string &name, Operator &op) {
+    static const char *NAMES[] = {"=", "!=", "<", "<=", ">", ">="};
+    for (int i = 0; i <= GREATER_EQUAL; i++)
+    {
+        if (name == NAMES[i])
+        {
+            op = (Operator)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PlanQuery::parseValue(PlanField field, const string &text, const PlanColumns &columns, int32_t &value) {
+    if (field == PlanField::SETTLEMENT)
+    {
+        value = columns.getSettlementId(text);
+        return value >= 0;
+    }
+    if (field == PlanField::TYPE)
+    {
+        static const char *TYPES[] = {"village", "city", "metropolis"};
+        for (int i = 0; i < 3; i++)
+        {
+            if (text == TYPES[i] || text == to_string(i))
+            {
+                value = i;
+                return true;
+            }
+        }
+        return false;
+    }
+    if (field == PlanField::STATUS)
+    {
+        if (text == "available" || text == "busy")
+        {
+            value = (int32_t)(text == "available" ? PlanStatus::AVAILABLE : PlanStatus::BUSY);
+            return true;
+        }
+        return false;
+    }
+    if (field == PlanField::POLICY)
+    {
+        PolicyKind kind;
+        if (PolicyState::parse(text, kind))
+        {
+            value = columns.getPolicyId(PolicyState::getName(kind));
+            return true;
+        }
+        //Other policies (lookahead) by their full name, as long as some plan uses them
+        value = columns.getPolicyId(text);
+        return value >= 0;
+    }
+    istringstream number(text);
+    int parsed;
+    if (!(number >> parsed) || !number.eof())
+    {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
@@ -0,0 +1,347 @@
+#include "PlanRecords.h"
+#include "Plan.h"
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace std;
+
+const size_t PlanRecordFile::WINDOW_RECORDS;
+const size_t PlanRecordFile::APPEND_BUFFER_RECORDS;
+const int64_t PlanRecordFile::NO_ENTRY;
+
+PlanRecordFile::PlanRecordFile(): fd(-1), historyFd(-1), numOfRecords(0), numOfEntries(0), historyFailed(false) {
+    pending.reserve(APPEND_BUFFER_RECORDS);
+    pendingEntries.reserve(APPEND_BUFFER_RECORDS);
+}
+
+PlanRecordFile::~PlanRecordFile() {
+    if (fd >= 0)
+    {
+        flush();
+        flushHistory();
+        ::close(fd);
+        ::close(historyFd);
+    }
+}
+
+//Creates the record file at 'path' and its history at 'path'.history
+bool PlanRecordFile::create(const string &path) {
+    if (fd >= 0)
+    {
+        return false;
+    }
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        return false;
+    }
+    historyFd = ::open((path + ".history").c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (historyFd < 0)
+    {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    this->path = path;
+    return true;
+}
+
+const string &PlanRecordFile::getPath() const {
+    return path;
+}
+
+size_t PlanRecordFile::size() const {
+    return numOfRecords;
+}
+
+bool PlanRecordFile::append(const PlanRecord &record) {
+    pending.push_back(record);
+    numOfRecords++;
+    return pending.size() < APPEND_BUFFER_RECORDS || flush();
+}
+
+bool PlanRecordFile::flush() {
+    if (pending.empty())
+    {
+        return true;
+    }
+    const size_t length = pending.size() * sizeof(PlanRecord);
+    const off_t offset = (off_t)(numOfRecords - pending.size()) * sizeof(PlanRecord);
+    const bool written = pwrite(fd, pending.data(), length, offset) == (ssize_t)length;
+    pending.clear();
+    return written;
+}
+
+bool PlanRecordFile::flushHistory() {
+    if (pendingEntries.empty())
+    {
+        return true;
+    }
+    const size_t length = pendingEntries.size() * sizeof(OperationalEntry);
+    const off_t offset = (off_t)(numOfEntries - pendingEntries.size()) * sizeof(OperationalEntry);
+    const bool written = pwrite(historyFd, pendingEntries.data(), length, offset) == (ssize_t)length;
+    pendingEntries.clear();
+    historyFailed = historyFailed || !written;
+    return written;
+}
+
+//Appends the facility to the plan's operational facilities, the record is not written
+void PlanRecordFile::addOperational(PlanRecord &record, int facilityIndex) {
+    OperationalEntry entry = OperationalEntry();
+    entry.previous = record.lastOperational;
+    entry.facilityIndex = facilityIndex;
+    pendingEntries.push_back(entry);
+    record.lastOperational = numOfEntries++;
+    if (pendingEntries.size() == APPEND_BUFFER_RECORDS)
+    {
+        flushHistory();
+    }
+}
+
+//Fills 'facilityIndices' with the facility option indices of the plan's operational facilities,
+//in the order they became operational
+bool PlanRecordFile::readOperational(const PlanRecord &record, vector<int32_t> &facilityIndices) {
+    facilityIndices.clear();
+    if (record.lastOperational != NO_ENTRY && !flushHistory())
+    {
+        return false;
+    }
+    OperationalEntry entry;
+    int64_t next = record.lastOperational;
+    while (next != NO_ENTRY)
+    {
+        //Entries only link back to earlier ones, anything else is a damaged history
+        if (next < 0 || next >= numOfEntries || pread(historyFd, &entry, sizeof(OperationalEntry), (off_t)next * sizeof(OperationalEntry)) != (ssize_t)sizeof(OperationalEntry) || entry.previous >= next)
+        {
+            return false;
+        }
+        facilityIndices.push_back(entry.facilityIndex);
+        next = entry.previous;
+    }
+    reverse(facilityIndices.begin(), facilityIndices.end());
+    return true;
+}
+
+bool PlanRecordFile::read(size_t planId, PlanRecord &record) {
+    if (planId >= numOfRecords || !flush())
+    {
+        return false;
+    }
+    return pread(fd, &record, sizeof(PlanRecord), (off_t)planId * sizeof(PlanRecord)) == (ssize_t)sizeof(PlanRecord);
+}
+
+bool PlanRecordFile::write(size_t planId, const PlanRecord &record) {
+    if (planId >= numOfRecords || !flush())
+    {
+        return false;
+    }
+    return pwrite(fd, &record, sizeof(PlanRecord), (off_t)planId * sizeof(PlanRecord)) == (ssize_t)sizeof(PlanRecord);
+}
+
+bool PlanRecordFile::scan(Visitor &visitor, bool writable) {
+    if (!flush())
+    {
+        return false;
+    }
+    const int protection = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    for (size_t first = 0; first < numOfRecords; first += WINDOW_RECORDS)
+    {
+        const size_t count = min(WINDOW_RECORDS, numOfRecords - first);
+        const size_t length = count * sizeof(PlanRecord);
+        const off_t offset = (off_t)first * sizeof(PlanRecord);
+        if (first + count < numOfRecords)
+        {
+            const size_t next = min(WINDOW_RECORDS, numOfRecords - first - count);
+            posix_fadvise(fd, offset + length, next * sizeof(PlanRecord), POSIX_FADV_WILLNEED);
+        }
+        void *mapped = mmap(nullptr, length, protection, MAP_SHARED, fd, offset);
+        if (mapped == MAP_FAILED)
+        {
+            return false;
+        }
+        madvise(mapped, length, MADV_SEQUENTIAL);
+        visitor.visit((PlanRecord*)mapped, first, count);
+        munmap(mapped, length);
+        if (writable)
+        {
+            sync_file_range(fd, offset, length, SYNC_FILE_RANGE_WRITE);
+        }
+        else
+        {
+            posix_fadvise(fd, offset, length, POSIX_FADV_DONTNEED);
+        }
+    }
+    return true;
+}
+
+//The step of one record, the same as Plan::step() of the plan the record was made from
+template <size_t LIMIT, PolicyKind KIND>
+static void stepRecord(PlanRecord &record, PlanRecordFile &records, const FacilityCatalog &facilitiesOptions) {
+    if (record.status == (uint8_t)PlanStatus::AVAILABLE)
+    {
+        PolicyState policy = PlanRecordFile::getPolicy(record);
+        while (record.status == (uint8_t)PlanStatus::AVAILABLE)
+        {
+            const FacilityType &facility = policy.select<KIND>(facilitiesOptions);
+            const size_t slot = record.numOfUnderConstruction++;
+            record.underConstruction[slot] = &facility - facilitiesOptions.data();
+            record.timeLeft[slot] = facility.getCost();
+            if (record.numOfUnderConstruction == LIMIT)
+            {
+                record.status = (uint8_t)PlanStatus::BUSY;
+            }
+        }
+        PlanRecordFile::setPolicy(record, policy);
+    }
+    size_t i = 0;
+    while (i < record.numOfUnderConstruction)
+    {
+        if (record.timeLeft[i] != 1)
+        {
+            record.timeLeft[i]--;
+            i++;
+            continue;
+        }
+        const FacilityType &facility = facilitiesOptions[record.underConstruction[i]];
+        record.scores[0] += facility.getLifeQualityScore();
+        record.scores[1] += facility.getEconomyScore();
+        record.scores[2] += facility.getEnvironmentScore();
+        records.addOperational(record, record.underConstruction[i]);
+        record.status = (uint8_t)PlanStatus::AVAILABLE;
+        record.numOfUnderConstruction--;
+        for (size_t j = i; j < record.numOfUnderConstruction; j++)
+        {
+            record.underConstruction[j] = record.underConstruction[j + 1];
+            record.timeLeft[j] = record.timeLeft[j + 1];
+        }
+    }
+}
+
+template <size_t LIMIT>
+static void stepRecord(PlanRecord &record, PlanRecordFile &records, const FacilityCatalog &facilitiesOptions) {
+    switch ((PolicyKind)record.policyKind)
+    {
+        case PolicyKind::NAIVE:
+            stepRecord<LIMIT, PolicyKind::NAIVE>(record, records, facilitiesOptions);
+            break;
+        case PolicyKind::BALANCED:
+            stepRecord<LIMIT, PolicyKind::BALANCED>(record, records, facilitiesOptions);
+            break;
+        case PolicyKind::ECONOMY:
+            stepRecord<LIMIT, PolicyKind::ECONOMY>(record, records, facilitiesOptions);
+            break;
+        case PolicyKind::SUSTAINABILITY:
+            stepRecord<LIMIT, PolicyKind::SUSTAINABILITY>(record, records, facilitiesOptions);
+            break;
+        case PolicyKind::CUSTOM:
+            break;
+    }
+}
+
+class StepVisitor : public PlanRecordFile::Visitor {
+    public:
+        StepVisitor(PlanRecordFile &planRecords, const FacilityCatalog &facilitiesOptions): planRecords(planRecords), facilitiesOptions(facilitiesOptions) {}
+
+        void visit(PlanRecord *records, size_t, size_t count) override {
+            for (size_t i = 0; i < count; i++)
+            {
+                PlanRecord &record = records[i];
+                switch ((SettlementType)record.settlementType)
+                {
+                    case SettlementType::VILLAGE:
+                        stepRecord<1>(record, planRecords, facilitiesOptions);
+                        break;
+                    case SettlementType::CITY:
+                        stepRecord<2>(record, planRecords, facilitiesOptions);
+                        break;
+                    case SettlementType::METROPOLIS:
+                        stepRecord<3>(record, planRecords, facilitiesOptions);
+                        break;
+                }
+            }
+        }
+
+    private:
+        PlanRecordFile &planRecords;
+        const FacilityCatalog &facilitiesOptions;
+};
+
+//Steps every plan once, streaming through the file
+bool PlanRecordFile::step(const FacilityCatalog &facilitiesOptions) {
+    StepVisitor visitor(*this, facilitiesOptions);
+    return scan(visitor, true) && !historyFailed;
+}
+
+PlanRecord PlanRecordFile::makeRecord(int settlementIndex, SettlementType settlementType, const PolicyState &policy) {
+    PlanRecord record = PlanRecord();
+    record.settlementIndex = settlementIndex;
+    record.settlementType = (uint8_t)settlementType;
+    record.status = (uint8_t)PlanStatus::AVAILABLE;
+    record.lastOperational = NO_ENTRY;
+    setPolicy(record, policy);
+    return record;
+}
+
+//Fails for plans with a CUSTOM policy, whose state cannot be written to a record. The plan's
+//operational facilities are added to the history.
+bool PlanRecordFile::toRecord(const Plan &plan, int settlementIndex, const FacilityCatalog &facilitiesOptions, PlanRecord &record) {
+    if (plan.getPolicyKind() == PolicyKind::CUSTOM)
+    {
+        return false;
+    }
+    record = makeRecord(settlementIndex, plan.getSettlementType(), plan.getPolicyState());
+    record.status = (uint8_t)plan.getPlanStatus();
+    record.scores[0] = plan.getlifeQualityScore();
+    record.scores[1] = plan.getEconomyScore();
+    record.scores[2] = plan.getEnvironmentScore();
+    for (const Facility *facility : plan.getFacilities())
+    {
+        const int index = facilitiesOptions.find(facility->getNameSymbol());
+        if (index == FacilityCatalog::NOT_FOUND)
+        {
+            return false;
+        }
+        addOperational(record, index);
+    }
+    for (const Facility *facility : plan.getUnderConstructionFacilities())
+    {
+        const int index = facilitiesOptions.find(facility->getNameSymbol());
+        if (index == FacilityCatalog::NOT_FOUND)
+        {
+            return false;
+        }
+        record.underConstruction[record.numOfUnderConstruction] = index;
+        record.timeLeft[record.numOfUnderConstruction] = facility->getTimeLeft();
+        record.numOfUnderConstruction++;
+    }
+    return true;
+}
+
+PolicyState PlanRecordFile::getPolicy(const PlanRecord &record) {
+    if ((PolicyKind)record.policyKind == PolicyKind::BALANCED)
+    {
+        return PolicyState(PolicyKind::BALANCED, record.policy[0], record.policy[1], record.policy[2]);
+    }
+    PolicyState policy((PolicyKind)record.policyKind);
+    policy.lastSelectedIndex = record.policy[0];
+    return policy;
+}
+
+//A balanced policy only keeps its scores and the others only their last selected index, see PolicyState
+void PlanRecordFile::setPolicy(PlanRecord &record, const PolicyState &policy) {
+    record.policyKind = (uint8_t)policy.kind;
+    if (policy.kind == PolicyKind::BALANCED)
+    {
+        record.policy[0] = policy.lifeQualityScore;
+        record.policy[1] = policy.economyScore;
+        record.policy[2] = policy.environmentScore;
+    }
+    else
+    {
+        record.policy[0] = policy.lastSelectedIndex;
+        record.policy[1] = 0;
+        record.policy[2] = 0;
+    }
+}
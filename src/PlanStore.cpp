@@ -0,0 +1,110 @@
+#include "PlanStore.h"
+
+using namespace std;
+
+const size_t PlanStore::CHUNK_PLANS;
+const uint32_t PlanStore::NO_SLOT;
+
+PlanStore::PlanStore(): numOfPlans(0) {}
+
+PlanStore::PlanStore(PlanStore &&other) noexcept: chunks(move(other.chunks)), numOfPlans(other.numOfPlans), slots(move(other.slots)) {
+    other.chunks.clear();
+    other.numOfPlans = 0;
+    other.slots.clear();
+}
+
+PlanStore &PlanStore::operator=(PlanStore &&other) noexcept {
+    if (this != &other)
+    {
+        clear();
+        chunks.swap(other.chunks);
+        slots.swap(other.slots);
+        numOfPlans = other.numOfPlans;
+        other.numOfPlans = 0;
+    }
+    return *this;
+}
+
+PlanStore::~PlanStore() {
+    clear();
+}
+
+//Only the chunk table and the id table are reserved, chunks are allocated as they fill up
+void PlanStore::reserve(size_t numOfPlans) {
+    chunks.reserve((numOfPlans + CHUNK_MASK) >> CHUNK_BITS);
+    slots.reserve(numOfPlans);
+}
+
+void PlanStore::clear() {
+    for (size_t slot = 0; slot < numOfPlans; slot++)
+    {
+        slotAddress(slot)->~Plan();
+    }
+    for (Chunk *chunk : chunks)
+    {
+        delete chunk;
+    }
+    vector<Chunk*>().swap(chunks);
+    vector<uint32_t>().swap(slots);
+    numOfPlans = 0;
+}
+
+size_t PlanStore::size() const {
+    return numOfPlans;
+}
+
+bool PlanStore::empty() const {
+    return numOfPlans == 0;
+}
+
+Plan &PlanStore::operator[](size_t slot) {
+    return *slotAddress(slot);
+}
+
+const Plan &PlanStore::operator[](size_t slot) const {
+    return *slotAddress(slot);
+}
+
+Plan &PlanStore::back() {
+    return *slotAddress(numOfPlans - 1);
+}
+
+Plan *PlanStore::find(int planId) {
+    if (planId < 0 || (size_t)planId >= slots.size() || slots[planId] == NO_SLOT)
+    {
+        return nullptr;
+    }
+    return slotAddress(slots[planId]);
+}
+
+PlanStore::iterator PlanStore::begin() {
+    return iterator(chunks.data(), 0, numOfPlans);
+}
+
+PlanStore::iterator PlanStore::end() {
+    return iterator(chunks.data(), numOfPlans, numOfPlans);
+}
+
+PlanStore::const_iterator PlanStore::begin() const {
+    return const_iterator(chunks.data(), 0, numOfPlans);
+}
+
+PlanStore::const_iterator PlanStore::end() const {
+    return const_iterator(chunks.data(), numOfPlans, numOfPlans);
+}
+
+Plan *PlanStore::slotAddress(size_t slot) const {
+    return chunks[slot >> CHUNK_BITS]->at(slot & CHUNK_MASK);
+}
+
+void PlanStore::mapId(int planId, size_t slot) {
+    if (planId < 0)
+    {
+        return;
+    }
+    if ((size_t)planId >= slots.size())
+    {
+        slots.resize(planId + 1, NO_SLOT);
+    }
+    slots[planId] = slot;
+}
@@ -0,0 +1,197 @@
+#include "Realtime.h"
+#include "Autosave.h"
+#include "Pipeline.h"
+#include "Simulation.h"
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace std;
+
+static uint64_t monotonicNow() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+//----------------------------------------------------------------
+//RealtimeClock Class
+//----------------------------------------------------------------
+
+const int RealtimeClock::NUM_OF_BUCKETS;
+
+RealtimeClock::RealtimeClock():
+    timerFd(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)),
+    epollFd(epoll_create1(EPOLL_CLOEXEC)),
+    armed(false),
+    dropLateTicks(false),
+    warnedNoPlans(false),
+    period(0),
+    firstTick(0),
+    numOfTicks(0),
+    dueTicks(0),
+    numOfDropped(0),
+    lateness() {
+        if (timerFd < 0 || epollFd < 0)
+        {
+            return;
+        }
+        epoll_event event = epoll_event();
+        event.events = EPOLLIN;
+        event.data.fd = timerFd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, timerFd, &event);
+}
+
+RealtimeClock::~RealtimeClock() {
+    if (timerFd >= 0)
+    {
+        ::close(timerFd);
+    }
+    if (epollFd >= 0)
+    {
+        ::close(epollFd);
+    }
+}
+
+//Starts ticking every 'msPerTick' milliseconds from now, with new lateness statistics
+bool RealtimeClock::arm(int msPerTick, bool dropLateTicks) {
+    if (msPerTick <= 0 || timerFd < 0 || epollFd < 0)
+    {
+        return false;
+    }
+    period = (uint64_t)msPerTick * 1000000ULL;
+    firstTick = monotonicNow() + period;
+    itimerspec timer = itimerspec();
+    timer.it_value.tv_sec = firstTick / 1000000000ULL;
+    timer.it_value.tv_nsec = firstTick % 1000000000ULL;
+    timer.it_interval.tv_sec = period / 1000000000ULL;
+    timer.it_interval.tv_nsec = period % 1000000000ULL;
+    if (timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &timer, nullptr) != 0)
+    {
+        return false;
+    }
+    this->dropLateTicks = dropLateTicks;
+    warnedNoPlans = false;
+    numOfTicks = 0;
+    dueTicks = 0;
+    numOfDropped = 0;
+    for (uint64_t &count : lateness)
+    {
+        count = 0;
+    }
+    armed = true;
+    return true;
+}
+
+void RealtimeClock::disarm() {
+    const itimerspec stopped = itimerspec();
+    timerfd_settime(timerFd, 0, &stopped, nullptr);
+    dueTicks = 0;
+    armed = false;
+}
+
+bool RealtimeClock::isArmed() const {
+    return armed;
+}
+
+//The command loop while the clock exists, returns when the simulation is closed or its input ends
+void RealtimeClock::run(Simulation &simulation, CommandPipeline &pipeline) {
+    epoll_event event = epoll_event();
+    event.events = EPOLLIN;
+    event.data.fd = pipeline.getFd();
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, pipeline.getFd(), &event);
+    epoll_event events[2];
+    while (simulation.isOpen())
+    {
+        tick(simulation);
+        pipeline.flush();
+        ParsedCommand command;
+        if (pipeline.tryNext(command))
+        {
+            pipeline.perform(command);
+            continue;
+        }
+        if (pipeline.isFinished())
+        {
+            simulation.close();
+            break;
+        }
+        if (dueTicks > 0)
+        {
+            continue;
+        }
+        pipeline.prepareWait();
+        if (!pipeline.hasNext())
+        {
+            epoll_wait(epollFd, events, 2, -1);
+        }
+        pipeline.endWait();
+    }
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, pipeline.getFd(), &event);
+}
+
+//Steps one of the ticks that fell due, if any. Catching up takes one tick at a time, so commands
+//still run in between.
+void RealtimeClock::tick(Simulation &simulation) {
+    uint64_t expirations;
+    if (armed && read(timerFd, &expirations, sizeof(expirations)) == (ssize_t)sizeof(expirations))
+    {
+        dueTicks += expirations;
+    }
+    if (!armed || dueTicks == 0)
+    {
+        return;
+    }
+    if (dropLateTicks)
+    {
+        numOfTicks += dueTicks - 1;
+        numOfDropped += dueTicks - 1;
+        dueTicks = 1;
+    }
+    step(simulation, firstTick + numOfTicks * period);
+    numOfTicks++;
+    dueTicks--;
+}
+
+void RealtimeClock::step(Simulation &simulation, uint64_t scheduled) {
+    const uint64_t now = monotonicNow();
+    const uint64_t late = now > scheduled ? (now - scheduled) / 1000 : 0;
+    int bucket = 0;
+    while (bucket < NUM_OF_BUCKETS - 1 && (late >> bucket) != 0)
+    {
+        bucket++;
+    }
+    lateness[bucket]++;
+    const bool hasPlans = simulation.hasPlans();
+    if (!hasPlans && warnedNoPlans)
+    {
+        return;
+    }
+    warnedNoPlans = !hasPlans;
+    simulation.step();
+    Autosaver *autosaver = simulation.getAutosaver();
+    if (autosaver != nullptr)
+    {
+        autosaver->onTick(simulation);
+    }
+}
+
+void RealtimeClock::printLateness(ostream &out) const {
+    out << "Ticks: " << numOfTicks << ", dropped: " << numOfDropped << endl;
+    out << "Lateness (microseconds):" << endl;
+    for (int bucket = 0; bucket < NUM_OF_BUCKETS; bucket++)
+    {
+        if (lateness[bucket] == 0)
+        {
+            continue;
+        }
+        const uint64_t low = bucket == 0 ? 0 : (uint64_t)1 << (bucket - 1);
+        out << "    " << low << " - ";
+        if (bucket < NUM_OF_BUCKETS - 1)
+        {
+            out << ((uint64_t)1 << bucket);
+        }
+        out << ": " << lateness[bucket] << endl;
+    }
+}
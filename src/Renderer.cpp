@@ -0,0 +1,101 @@
+#include "Renderer.h"
+#include <cstring>
+
+using namespace std;
+
+const size_t ReportRenderer::BUFFER_SIZE;
+
+//----------------------------------------------------------------
+//ReportRenderer Class
+//----------------------------------------------------------------
+
+ReportRenderer::ReportRenderer(ostream &out): out(&out), text(nullptr), length(0) {}
+
+ReportRenderer::ReportRenderer(string &text): out(nullptr), text(&text), length(0) {}
+
+ReportRenderer::~ReportRenderer() {
+    flush();
+}
+
+ReportRenderer &ReportRenderer::operator<<(const char *text) {
+    append(text, strlen(text));
+    return *this;
+}
+
+ReportRenderer &ReportRenderer::operator<<(const string &text) {
+    append(text.data(), text.size());
+    return *this;
+}
+
+ReportRenderer &ReportRenderer::operator<<(char c) {
+    if (length == BUFFER_SIZE)
+    {
+        flush();
+    }
+    buffer[length++] = c;
+    return *this;
+}
+
+//Writes the digits from the end of a small buffer backwards
+ReportRenderer &ReportRenderer::operator<<(int64_t value) {
+    char digits[24];
+    char *first = digits + sizeof(digits);
+    uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+    do
+    {
+        *--first = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0)
+    {
+        *--first = '-';
+    }
+    append(first, digits + sizeof(digits) - first);
+    return *this;
+}
+
+ReportRenderer &ReportRenderer::operator<<(int value) {
+    return *this << (int64_t)value;
+}
+
+ReportRenderer &ReportRenderer::operator<<(size_t value) {
+    return *this << (int64_t)value;
+}
+
+void ReportRenderer::flush() {
+    if (length == 0)
+    {
+        return;
+    }
+    if (out != nullptr)
+    {
+        out->write(buffer, length);
+    }
+    else
+    {
+        text->append(buffer, length);
+    }
+    length = 0;
+}
+
+void ReportRenderer::append(const char *text, size_t length) {
+    if (this->length + length > BUFFER_SIZE)
+    {
+        flush();
+    }
+    //Text longer than the buffer goes out directly
+    if (length > BUFFER_SIZE)
+    {
+        if (out != nullptr)
+        {
+            out->write(text, length);
+        }
+        else
+        {
+            this->text->append(text, length);
+        }
+        return;
+    }
+    memcpy(buffer + this->length, text, length);
+    this->length += length;
+}
@@ -0,0 +1,352 @@
+#include "Rollups.h"
+
+using namespace std;
+
+static const ScoreAggregate EMPTY_AGGREGATE = {0, 0, 0, 0};
+
+const int Rollups::NO_PLAN;
+
+//The treap priority of a plan, the MurmurHash3 finalizer of its id
+static uint32_t getPriority(int planId) {
+    uint32_t hash = (uint32_t)planId;
+    hash = (hash ^ (hash >> 16)) * 0x85EBCA6BU;
+    hash = (hash ^ (hash >> 13)) * 0xC2B2AE35U;
+    return hash ^ (hash >> 16);
+}
+
+static bool isHigherPriority(int planId, int otherPlanId) {
+    const uint32_t priority = getPriority(planId);
+    const uint32_t otherPriority = getPriority(otherPlanId);
+    return priority > otherPriority || (priority == otherPriority && planId < otherPlanId);
+}
+
+Rollups::Rollups() {
+    clear();
+    //Room for the built in policies, so the first plan of one does not allocate
+    policyTotals.reserve((int)PolicyKind::CUSTOM);
+    policySymbols.reserve((int)PolicyKind::CUSTOM);
+}
+
+void Rollups::clear() {
+    total = EMPTY_AGGREGATE;
+    for (ScoreAggregate &typeTotal : typeTotals)
+    {
+        typeTotal = EMPTY_AGGREGATE;
+    }
+    settlementTotals.clear();
+    settlementIndex.clear();
+    policyTotals.clear();
+    policySymbols.clear();
+    planSettlement.clear();
+    planPolicy.clear();
+    for (int &root : leaderboardRoots)
+    {
+        root = NO_PLAN;
+    }
+    leaderboardNodes.clear();
+}
+
+void Rollups::rebuild(const PlanStore &plans) {
+    clear();
+    for (const Plan &plan : plans)
+    {
+        addPlan(plan);
+    }
+}
+
+void Rollups::reserve(size_t numOfPlans, size_t numOfSettlements) {
+    planSettlement.reserve(numOfPlans);
+    planPolicy.reserve(numOfPlans);
+    leaderboardNodes.reserve(numOfPlans * NUM_OF_METRICS);
+    settlementTotals.reserve(numOfSettlements);
+    settlementIndex.reserve(numOfSettlements);
+}
+
+//The index of the settlement's totals, which are added the first time the settlement is seen
+int Rollups::addSettlement(uint32_t settlementName) {
+    unordered_map<uint32_t, int>::iterator it = settlementIndex.find(settlementName);
+    if (it == settlementIndex.end())
+    {
+        it = settlementIndex.insert(make_pair(settlementName, (int)settlementTotals.size())).first;
+        settlementTotals.push_back(EMPTY_AGGREGATE);
+    }
+    return it->second;
+}
+
+void Rollups::addPlan(const Plan &plan) {
+    const int planId = plan.getPlanId();
+    if ((size_t)planId >= planSettlement.size())
+    {
+        planSettlement.resize(planId + 1, -1);
+        planPolicy.resize(planId + 1, -1);
+        leaderboardNodes.resize((planId + 1) * NUM_OF_METRICS);
+    }
+    planSettlement[planId] = addSettlement(plan.getSettlement().getNameSymbol());
+    planPolicy[planId] = getPolicyIndex(plan.getSelectionPolicySymbol());
+
+    const long long life = plan.getlifeQualityScore();
+    const long long economy = plan.getEconomyScore();
+    const long long environment = plan.getEnvironmentScore();
+    total.numOfPlans++;
+    typeTotals[(int)plan.getSettlementType()].numOfPlans++;
+    settlementTotals[planSettlement[planId]].numOfPlans++;
+    policyTotals[planPolicy[planId]].numOfPlans++;
+    add(total, life, economy, environment);
+    add(typeTotals[(int)plan.getSettlementType()], life, economy, environment);
+    add(settlementTotals[planSettlement[planId]], life, economy, environment);
+    add(policyTotals[planPolicy[planId]], life, economy, environment);
+    for (int metric = 0; metric < NUM_OF_METRICS; metric++)
+    {
+        LeaderboardNode &node = getNode(metric, planId);
+        node.score = getScore((ScoreMetric)metric, life, economy, environment);
+        node.left = NO_PLAN;
+        node.right = NO_PLAN;
+        insert(metric, planId);
+    }
+}
+
+//Moves the plan's scores from the totals of its previous policy to the totals of its current one
+void Rollups::changePolicy(const Plan &plan) {
+    const int planId = plan.getPlanId();
+    const int newPolicy = getPolicyIndex(plan.getSelectionPolicySymbol());
+    const int oldPolicy = planPolicy[planId];
+    if (oldPolicy == newPolicy)
+    {
+        return;
+    }
+    const long long life = plan.getlifeQualityScore();
+    const long long economy = plan.getEconomyScore();
+    const long long environment = plan.getEnvironmentScore();
+    policyTotals[oldPolicy].numOfPlans--;
+    add(policyTotals[oldPolicy], -life, -economy, -environment);
+    policyTotals[newPolicy].numOfPlans++;
+    add(policyTotals[newPolicy], life, economy, environment);
+    planPolicy[planId] = newPolicy;
+}
+
+void Rollups::onFacilityOperational(const Plan &plan, const Facility &facility) {
+    const int planId = plan.getPlanId();
+    const long long life = facility.getLifeQualityScore();
+    const long long economy = facility.getEconomyScore();
+    const long long environment = facility.getEnvironmentScore();
+    add(total, life, economy, environment);
+    add(typeTotals[(int)plan.getSettlementType()], life, economy, environment);
+    add(settlementTotals[planSettlement[planId]], life, economy, environment);
+    add(policyTotals[planPolicy[planId]], life, economy, environment);
+
+    const long long newLife = plan.getlifeQualityScore();
+    const long long newEconomy = plan.getEconomyScore();
+    const long long newEnvironment = plan.getEnvironmentScore();
+    for (int metric = 0; metric < NUM_OF_METRICS; metric++)
+    {
+        const long long oldScore = getScore((ScoreMetric)metric, newLife - life, newEconomy - economy, newEnvironment - environment);
+        const long long newScore = getScore((ScoreMetric)metric, newLife, newEconomy, newEnvironment);
+        if (oldScore != newScore)
+        {
+            erase(metric, planId);
+            LeaderboardNode &node = getNode(metric, planId);
+            node.score = newScore;
+            node.left = NO_PLAN;
+            node.right = NO_PLAN;
+            insert(metric, planId);
+        }
+    }
+}
+
+const ScoreAggregate &Rollups::getTotal() const {
+    return total;
+}
+
+const ScoreAggregate *Rollups::getSettlementTotal(uint32_t settlementName) const {
+    unordered_map<uint32_t, int>::const_iterator it = settlementIndex.find(settlementName);
+    if (it == settlementIndex.end())
+    {
+        return nullptr;
+    }
+    return &settlementTotals[it->second];
+}
+
+const ScoreAggregate &Rollups::getTypeTotal(SettlementType type) const {
+    return typeTotals[(int)type];
+}
+
+const vector<uint32_t> &Rollups::getPolicySymbols() const {
+    return policySymbols;
+}
+
+const ScoreAggregate &Rollups::getPolicyTotal(size_t policyIndex) const {
+    return policyTotals[policyIndex];
+}
+
+//Fills 'top' with (score, plan id) of the k best plans, best first. Ties go to the lower plan id.
+void Rollups::getTop(ScoreMetric metric, size_t k, vector<pair<long long, int>> &top) const {
+    top.clear();
+    collectTop((int)metric, leaderboardRoots[(int)metric], k, top);
+}
+
+bool Rollups::parseMetric(const string &name, ScoreMetric &metric) {
+    if (name == "life")
+    {
+        metric = ScoreMetric::LIFE_QUALITY;
+    }
+    else if (name == "eco")
+    {
+        metric = ScoreMetric::ECONOMY;
+    }
+    else if (name == "env")
+    {
+        metric = ScoreMetric::ENVIRONMENT;
+    }
+    else if (name == "sum")
+    {
+        metric = ScoreMetric::SUM;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+void Rollups::add(ScoreAggregate &aggregate, long long lifeQualityScore, long long economyScore, long long environmentScore) {
+    aggregate.lifeQualityScore += lifeQualityScore;
+    aggregate.economyScore += economyScore;
+    aggregate.environmentScore += environmentScore;
+}
+
+long long Rollups::getScore(ScoreMetric metric, long long lifeQualityScore, long long economyScore, long long environmentScore) {
+    switch (metric)
+    {
+        case ScoreMetric::LIFE_QUALITY:
+            return lifeQualityScore;
+        case ScoreMetric::ECONOMY:
+            return economyScore;
+        case ScoreMetric::ENVIRONMENT:
+            return environmentScore;
+        case ScoreMetric::SUM:
+            break;
+    }
+    return lifeQualityScore + economyScore + environmentScore;
+}
+
+int Rollups::getPolicyIndex(uint32_t policyName) {
+    for (size_t i = 0; i < policySymbols.size(); i++)
+    {
+        if (policySymbols[i] == policyName)
+        {
+            return i;
+        }
+    }
+    policySymbols.push_back(policyName);
+    policyTotals.push_back(EMPTY_AGGREGATE);
+    return policySymbols.size() - 1;
+}
+
+Rollups::LeaderboardNode &Rollups::getNode(int metric, int planId) {
+    return leaderboardNodes[planId * NUM_OF_METRICS + metric];
+}
+
+const Rollups::LeaderboardNode &Rollups::getNode(int metric, int planId) const {
+    return leaderboardNodes[planId * NUM_OF_METRICS + metric];
+}
+
+//Lower scores come first, and of equal scores the higher plan id, so the best plan is the last one
+bool Rollups::isBelow(int metric, int planId, int otherPlanId) const {
+    const long long score = getNode(metric, planId).score;
+    const long long otherScore = getNode(metric, otherPlanId).score;
+    return score < otherScore || (score == otherScore && planId > otherPlanId);
+}
+
+//Adds the plan's node, which has its score and no children. The node goes below the nodes of
+//higher priority on the way to its place, and takes the ones it ends up over as its children.
+void Rollups::insert(int metric, int planId) {
+    int *link = &leaderboardRoots[metric];
+    while (*link != NO_PLAN && isHigherPriority(*link, planId))
+    {
+        LeaderboardNode &node = getNode(metric, *link);
+        link = isBelow(metric, planId, *link) ? &node.left : &node.right;
+    }
+    LeaderboardNode &node = getNode(metric, planId);
+    split(metric, *link, planId, node.left, node.right);
+    *link = planId;
+}
+
+//Removes the plan's node, which must still have the score it was inserted with
+void Rollups::erase(int metric, int planId) {
+    int *link = &leaderboardRoots[metric];
+    while (*link != planId)
+    {
+        if (*link == NO_PLAN)
+        {
+            return;
+        }
+        LeaderboardNode &node = getNode(metric, *link);
+        link = isBelow(metric, planId, *link) ? &node.left : &node.right;
+    }
+    const LeaderboardNode &node = getNode(metric, planId);
+    *link = merge(metric, node.left, node.right);
+}
+
+//Splits the subtree at 'root' into the nodes below the plan's and the nodes above it
+void Rollups::split(int metric, int root, int planId, int &below, int &above) {
+    int *belowLink = &below;
+    int *aboveLink = &above;
+    while (root != NO_PLAN)
+    {
+        LeaderboardNode &rootNode = getNode(metric, root);
+        if (isBelow(metric, root, planId))
+        {
+            *belowLink = root;
+            belowLink = &rootNode.right;
+            root = rootNode.right;
+        }
+        else
+        {
+            *aboveLink = root;
+            aboveLink = &rootNode.left;
+            root = rootNode.left;
+        }
+    }
+    *belowLink = NO_PLAN;
+    *aboveLink = NO_PLAN;
+}
+
+//Joins two subtrees, every node of 'below' being below every node of 'above', and returns the root
+int Rollups::merge(int metric, int below, int above) {
+    int root = NO_PLAN;
+    int *link = &root;
+    while (below != NO_PLAN && above != NO_PLAN)
+    {
+        if (isHigherPriority(below, above))
+        {
+            LeaderboardNode &belowNode = getNode(metric, below);
+            *link = below;
+            link = &belowNode.right;
+            below = belowNode.right;
+        }
+        else
+        {
+            LeaderboardNode &aboveNode = getNode(metric, above);
+            *link = above;
+            link = &aboveNode.left;
+            above = aboveNode.left;
+        }
+    }
+    *link = below != NO_PLAN ? below : above;
+    return root;
+}
+
+//Walks the leaderboard from the top until it has k plans
+void Rollups::collectTop(int metric, int root, size_t k, vector<pair<long long, int>> &top) const {
+    if (root == NO_PLAN || top.size() >= k)
+    {
+        return;
+    }
+    const LeaderboardNode &rootNode = getNode(metric, root);
+    collectTop(metric, rootNode.right, k, top);
+    if (top.size() < k)
+    {
+        top.push_back(make_pair(rootNode.score, root));
+    }
+    collectTop(metric, rootNode.left, k, top);
+}
@@ -0,0 +1,251 @@
+#include "SPLand.h"
+#include "ConfigLoader.h"
+#include "PlanRecords.h"
+#include "SelectionPolicy.h"
+
+using namespace std;
+
+SPLand::SPLand(): simulation() {}
+
+SPLand::SPLand(const string &configFilePath): simulation(configFilePath) {}
+
+//Adds what a configuration file describes to the simulation
+bool SPLand::loadConfig(const string &configFilePath) {
+    return ConfigLoader::load(configFilePath, simulation);
+}
+
+void SPLand::loadImage(const ConfigImage &image) {
+    image.load(simulation);
+}
+
+//Keeps the plans in a record file at 'storePath' from now on
+bool SPLand::spill(const string &storePath) {
+    return simulation.spill(storePath);
+}
+
+//Reads commands from the console and performs them until close
+void SPLand::run() {
+    simulation.start();
+}
+
+bool SPLand::addSettlement(const string &name, SettlementType type) {
+    if (simulation.isSettlementExists(name))
+    {
+        return false;
+    }
+    return simulation.addSettlement(new Settlement(name, type));
+}
+
+bool SPLand::addFacility(const string &name, FacilityCategory category, int price, int lifeQualityScore, int economyScore, int environmentScore) {
+    return simulation.addFacility(FacilityType(name, category, price, lifeQualityScore, economyScore, environmentScore));
+}
+
+//Returns the id of the new plan, or -1 if the settlement does not exist
+int SPLand::addPlan(const string &settlementName, PolicyKind policy) {
+    const Settlement *settlement = simulation.findSettlement(settlementName);
+    if (settlement == nullptr || policy == PolicyKind::CUSTOM)
+    {
+        return -1;
+    }
+    return simulation.addPlan(*settlement, PolicyState(policy));
+}
+
+//Takes ownership of the policy, e.g. a LookaheadSelection with settings of its own. Spilled plans
+//only take the built in policies.
+int SPLand::addPlan(const string &settlementName, SelectionPolicy *policy) {
+    const Settlement *settlement = simulation.findSettlement(settlementName);
+    PolicyState state;
+    if (settlement == nullptr || policy == nullptr || (simulation.isSpilled() && !policy->getState(state)))
+    {
+        delete policy;
+        return -1;
+    }
+    return simulation.addPlan(*settlement, policy);
+}
+
+//Reads and writes the record of a spilled plan, with a balanced policy also starting from its scores
+static bool changeRecordPolicy(PlanRecordFile &planRecords, int planId, PolicyKind policy) {
+    PlanRecord record;
+    if (planId < 0 || !planRecords.read(planId, record))
+    {
+        return false;
+    }
+    if (policy == PolicyKind::BALANCED)
+    {
+        PlanRecordFile::setPolicy(record, PolicyState(policy, record.scores[0], record.scores[1], record.scores[2]));
+    }
+    else
+    {
+        PlanRecordFile::setPolicy(record, PolicyState(policy));
+    }
+    return planRecords.write(planId, record);
+}
+
+bool SPLand::changePolicy(int planId, PolicyKind policy) {
+    if (simulation.isSpilled())
+    {
+        return policy != PolicyKind::CUSTOM && changeRecordPolicy(*simulation.getPlanRecords(), planId, policy);
+    }
+    Plan *plan = simulation.findPlan(planId);
+    if (plan == nullptr || policy == PolicyKind::CUSTOM)
+    {
+        return false;
+    }
+    //A balanced policy starts from the plan's current scores, as the changePolicy command does
+    if (policy == PolicyKind::BALANCED)
+    {
+        simulation.setPlanPolicy(*plan, PolicyState(policy, plan->getlifeQualityScore(), plan->getEconomyScore(), plan->getEnvironmentScore()));
+    }
+    else
+    {
+        simulation.setPlanPolicy(*plan, PolicyState(policy));
+    }
+    return true;
+}
+
+//Does nothing without plans, rather than warning about it on the console
+void SPLand::step(int numOfSteps) {
+    if (getNumOfPlans() == 0)
+    {
+        return;
+    }
+    for (int i = 0; i < numOfSteps; i++)
+    {
+        simulation.step();
+    }
+}
+
+int SPLand::getNumOfPlans() {
+    if (simulation.isSpilled())
+    {
+        return simulation.getPlanRecords()->size();
+    }
+    return simulation.getPlans().size();
+}
+
+bool SPLand::getPlanScores(int planId, PlanScores &scores) {
+    if (simulation.isSpilled())
+    {
+        PlanRecord record;
+        if (planId < 0 || !simulation.getPlanRecords()->read(planId, record))
+        {
+            return false;
+        }
+        scores.planId = planId;
+        scores.lifeQualityScore = record.scores[0];
+        scores.economyScore = record.scores[1];
+        scores.environmentScore = record.scores[2];
+        scores.status = (PlanStatus)record.status;
+        return true;
+    }
+    const Plan *plan = simulation.findPlan(planId);
+    if (plan == nullptr)
+    {
+        return false;
+    }
+    scores.planId = planId;
+    scores.lifeQualityScore = plan->getlifeQualityScore();
+    scores.economyScore = plan->getEconomyScore();
+    scores.environmentScore = plan->getEnvironmentScore();
+    scores.status = plan->getPlanStatus();
+    return true;
+}
+
+//Fills 'facilities' with the operational facilities of the plan followed by the ones under construction
+bool SPLand::getPlanFacilities(int planId, vector<FacilityInfo> &facilities) {
+    facilities.clear();
+    if (simulation.isSpilled())
+    {
+        return getRecordFacilities(planId, facilities);
+    }
+    const Plan *plan = simulation.findPlan(planId);
+    if (plan == nullptr)
+    {
+        return false;
+    }
+    for (const Facility *facility : plan->getFacilities())
+    {
+        FacilityInfo info = {facility, facility->getStatus(), facility->getTimeLeft()};
+        facilities.push_back(info);
+    }
+    for (const Facility *facility : plan->getUnderConstructionFacilities())
+    {
+        FacilityInfo info = {facility, facility->getStatus(), facility->getTimeLeft()};
+        facilities.push_back(info);
+    }
+    return true;
+}
+
+//The facilities of a spilled plan point into the facility options
+bool SPLand::getRecordFacilities(int planId, vector<FacilityInfo> &facilities) {
+    PlanRecordFile *planRecords = simulation.getPlanRecords();
+    const FacilityCatalog &facilitiesOptions = simulation.getFacilityOptions();
+    PlanRecord record;
+    vector<int32_t> operational;
+    if (planId < 0 || !planRecords->read(planId, record) || !planRecords->readOperational(record, operational))
+    {
+        return false;
+    }
+    for (int32_t index : operational)
+    {
+        FacilityInfo info = {&facilitiesOptions[index], FacilityStatus::OPERATIONAL, 0};
+        facilities.push_back(info);
+    }
+    for (size_t i = 0; i < record.numOfUnderConstruction; i++)
+    {
+        FacilityInfo info = {&facilitiesOptions[record.underConstruction[i]], FacilityStatus::UNDER_CONSTRUCTIONS, record.timeLeft[i]};
+        facilities.push_back(info);
+    }
+    return true;
+}
+
+//Spilled plans are not copied into a backup, so there is nothing to snapshot or restore them from,
+//as with the backup command
+bool SPLand::snapshot() {
+    if (simulation.isSpilled())
+    {
+        return false;
+    }
+    simulation.setBackup(new Simulation(simulation));
+    return true;
+}
+
+bool SPLand::restore() {
+    Simulation *backup = simulation.getBackup();
+    if (backup == nullptr || simulation.isSpilled())
+    {
+        return false;
+    }
+    simulation = *backup;
+    return true;
+}
+
+bool SPLand::startRecording(const string &path) {
+    return simulation.startRecording(path);
+}
+
+//Returns false if some of the series could not be written
+bool SPLand::stopRecording() {
+    return simulation.stopRecording();
+}
+
+Simulation &SPLand::getSimulation() {
+    return simulation;
+}
+
+SelectionPolicy *SPLand::createPolicy(PolicyKind policy) {
+    switch (policy)
+    {
+        case PolicyKind::NAIVE:
+            return new NaiveSelection();
+        case PolicyKind::BALANCED:
+            return new BalancedSelection(0, 0, 0);
+        case PolicyKind::ECONOMY:
+            return new EconomySelection();
+        case PolicyKind::SUSTAINABILITY:
+            return new SustainabilitySelection();
+        case PolicyKind::CUSTOM:
+            break;
+    }
+    return nullptr;
+}
@@ -3,114 +3,179 @@
 #include "Settlement.h"
 #include "SelectionPolicy.h"
 #include "Facility.h"
+#include "Digest.h"
+#include "SymbolTable.h"
 #include <iostream>
 
 using namespace std;
 
+//----------------------------------------------------------------
+//PolicyState Struct
+//----------------------------------------------------------------
+PolicyState::PolicyState(): PolicyState(PolicyKind::CUSTOM) {}
+
+PolicyState::PolicyState(PolicyKind kind, int lifeQualityScore, int economyScore, int environmentScore)
+: kind(kind), lastSelectedIndex(-1), lifeQualityScore(lifeQualityScore), economyScore(economyScore), environmentScore(environmentScore) {}
+
+//Parses the name a policy is given in commands and configuration files (nve, bal, eco or env)
+bool PolicyState::parse(const string &name, PolicyKind &kind) {
+    if (name == "nve")
+    {
+        kind = PolicyKind::NAIVE;
+    }
+    else if (name == "bal")
+    {
+        kind = PolicyKind::BALANCED;
+    }
+    else if (name == "eco")
+    {
+        kind = PolicyKind::ECONOMY;
+    }
+    else if (name == "env")
+    {
+        kind = PolicyKind::SUSTAINABILITY;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+const string &PolicyState::getName(PolicyKind kind) {
+    static const string names[] = {"naive selection", "Balanced selection", "Economy selection", "SustainabilitySelection", "custom selection"};
+    return names[(int)kind];
+}
+
+uint32_t PolicyState::getSymbol(PolicyKind kind) {
+    static const uint32_t symbols[] = {
+        SymbolTable::intern(getName(PolicyKind::NAIVE)),
+        SymbolTable::intern(getName(PolicyKind::BALANCED)),
+        SymbolTable::intern(getName(PolicyKind::ECONOMY)),
+        SymbolTable::intern(getName(PolicyKind::SUSTAINABILITY)),
+        SymbolTable::intern(getName(PolicyKind::CUSTOM)),
+    };
+    return symbols[(int)kind];
+}
+
+//----------------------------------------------------------------
+//SelectionPolicy class
+//----------------------------------------------------------------
+bool SelectionPolicy::getState(PolicyState &) const {
+    return false;
+}
+
+//Mixes the policy's name and whatever it selects by into 'digest'. Policies whose state getState()
+//does not return should override this and mix their state in themselves.
+uint64_t SelectionPolicy::mixDigest(uint64_t digest) const {
+    digest = Digest::mix(digest, toString());
+    PolicyState state;
+    if (getState(state))
+    {
+        digest = Digest::mix(digest, (uint64_t)state.lastSelectedIndex);
+        digest = Digest::mix(digest, (uint64_t)state.lifeQualityScore);
+        digest = Digest::mix(digest, (uint64_t)state.economyScore);
+        digest = Digest::mix(digest, (uint64_t)state.environmentScore);
+    }
+    return digest;
+}
+
+//The symbol of toString(). Policies that keep their name should intern it once and override this.
+uint32_t SelectionPolicy::getNameSymbol() const {
+    return SymbolTable::intern(toString());
+}
+
 //----------------------------------------------------------------
 //NaiveSelection class
 //----------------------------------------------------------------
-NaiveSelection::NaiveSelection(): lastSelectedIndex(-1) {}
+NaiveSelection::NaiveSelection(): state(PolicyKind::NAIVE) {}
 
-const FacilityType& NaiveSelection::selectFacility(const vector<FacilityType>& facilitiesOptions) {
-    lastSelectedIndex = (lastSelectedIndex+1)%facilitiesOptions.size();
-    return facilitiesOptions[lastSelectedIndex];
+const FacilityType& NaiveSelection::selectFacility(const FacilityCatalog& facilitiesOptions) {
+    return state.select<PolicyKind::NAIVE>(facilitiesOptions);
 }
 
-const string NaiveSelection::toString() const {
-    return "naive selection";
+const string &NaiveSelection::toString() const {
+    return PolicyState::getName(PolicyKind::NAIVE);
 }
 
 NaiveSelection* NaiveSelection::clone() const {
     NaiveSelection* clone = new NaiveSelection();
-    clone->lastSelectedIndex = this->lastSelectedIndex;
+    clone->state = this->state;
     return clone;
 }
 
+bool NaiveSelection::getState(PolicyState &state) const {
+    state = this->state;
+    return true;
+}
+
 //----------------------------------------------------------------
 //BalancedSelction Class
 //----------------------------------------------------------------
 BalancedSelection::BalancedSelection(int LifeQualityScore, int EconomyScore, int EnvironmentScore)
-: LifeQualityScore(LifeQualityScore), EconomyScore (EconomyScore), EnvironmentScore(EnvironmentScore){}
-
-const FacilityType& BalancedSelection::selectFacility(const vector<FacilityType>& facilitiesOptions) {
-    const FacilityType*  ptr = &facilitiesOptions[0];
-    int a = ptr->getEconomyScore()+EconomyScore;
-    int b = ptr->getLifeQualityScore()+LifeQualityScore;
-    int c = ptr->getEnvironmentScore()+EnvironmentScore;
-    int diff = max(max(a,b),c) - min(min(a,b),c);
-    for (const FacilityType& v:facilitiesOptions)
-    {
-        int a = LifeQualityScore + v.getLifeQualityScore();
-        int b = v.getEconomyScore()+EconomyScore;
-        int c = v.getEnvironmentScore()+EnvironmentScore;
-        int newDiff = max(max(a,b),c) - min(min(a,b),c);
-        if (newDiff < diff)
-        {
-            diff = newDiff;
-            ptr = &v;
-        }
-    }
-    LifeQualityScore += ptr->getLifeQualityScore();
-    EconomyScore += ptr->getEconomyScore();
-    EnvironmentScore += ptr->getEnvironmentScore();
-    return *ptr;
+: state(PolicyKind::BALANCED, LifeQualityScore, EconomyScore, EnvironmentScore) {}
+
+const FacilityType& BalancedSelection::selectFacility(const FacilityCatalog& facilitiesOptions) {
+    return state.select<PolicyKind::BALANCED>(facilitiesOptions);
 }
 
-const string BalancedSelection::toString() const {
-    return "Balanced selection";
+const string &BalancedSelection::toString() const {
+    return PolicyState::getName(PolicyKind::BALANCED);
 }
 
 BalancedSelection* BalancedSelection::clone() const {
-    return new BalancedSelection(LifeQualityScore, EconomyScore, EnvironmentScore);
+    return new BalancedSelection(state.lifeQualityScore, state.economyScore, state.environmentScore);
 }
 
+bool BalancedSelection::getState(PolicyState &state) const {
+    state = this->state;
+    return true;
+}
 
 //----------------------------------------------------------------
 //EconomySelection Class
 //----------------------------------------------------------------
-EconomySelection::EconomySelection() :lastSelectedIndex(-1){}
+EconomySelection::EconomySelection(): state(PolicyKind::ECONOMY) {}
 
-const FacilityType& EconomySelection::selectFacility(const vector<FacilityType>& facilitiesOptions) {
-    lastSelectedIndex = (lastSelectedIndex+1)%facilitiesOptions.size();
-    while (facilitiesOptions[lastSelectedIndex].getCategory() != FacilityCategory::ECONOMY)
-    {
-        lastSelectedIndex = (lastSelectedIndex+1)%facilitiesOptions.size();  
-    }
-    return facilitiesOptions[lastSelectedIndex];
+const FacilityType& EconomySelection::selectFacility(const FacilityCatalog& facilitiesOptions) {
+    return state.select<PolicyKind::ECONOMY>(facilitiesOptions);
 }
 
-const string EconomySelection::toString() const {
-    return "Economy selection";
+const string &EconomySelection::toString() const {
+    return PolicyState::getName(PolicyKind::ECONOMY);
 }
 
-
 EconomySelection* EconomySelection::clone() const {
     EconomySelection* clone = new EconomySelection();
-    clone->lastSelectedIndex = this->lastSelectedIndex;
+    clone->state = this->state;
     return clone;
 }
 
+bool EconomySelection::getState(PolicyState &state) const {
+    state = this->state;
+    return true;
+}
+
 //----------------------------------------------------------------
 //SustainabilitySelection Class
 //----------------------------------------------------------------
-SustainabilitySelection::SustainabilitySelection(): lastSelectedIndex(-1){}
+SustainabilitySelection::SustainabilitySelection(): state(PolicyKind::SUSTAINABILITY) {}
 
-const FacilityType& SustainabilitySelection::selectFacility(const vector<FacilityType>& facilitiesOptions) {
-    lastSelectedIndex = (lastSelectedIndex+1)%facilitiesOptions.size();
-    while (facilitiesOptions[lastSelectedIndex].getCategory() != FacilityCategory::ENVIRONMENT)
-    {
-        lastSelectedIndex = (lastSelectedIndex+1)%facilitiesOptions.size();  
-    }
-    return facilitiesOptions[lastSelectedIndex];
+const FacilityType& SustainabilitySelection::selectFacility(const FacilityCatalog& facilitiesOptions) {
+    return state.select<PolicyKind::SUSTAINABILITY>(facilitiesOptions);
 }
 
-const string SustainabilitySelection::toString() const {
-    return "SustainabilitySelection";
+const string &SustainabilitySelection::toString() const {
+    return PolicyState::getName(PolicyKind::SUSTAINABILITY);
 }
 
 SustainabilitySelection* SustainabilitySelection::clone() const {
     SustainabilitySelection* clone = new SustainabilitySelection();
-    clone->lastSelectedIndex = this->lastSelectedIndex;
+    clone->state = this->state;
     return clone;
-}
\ No newline at end of file
+}
+
+bool SustainabilitySelection::getState(PolicyState &state) const {
+    state = this->state;
+    return true;
+}
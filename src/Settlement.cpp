@@ -3,21 +3,26 @@
 #include "Settlement.h"
 #include "SelectionPolicy.h"
 #include "Facility.h"
+#include "SymbolTable.h"
 
-Settlement::Settlement(const string &name, SettlementType type): name(name), type(type) {}
+Settlement::Settlement(const string &name, SettlementType type): name(SymbolTable::intern(name)), type(type) {}
 
 Settlement::Settlement(const Settlement &other): name(other.name), type(other.type) {}
 
 Settlement &Settlement::operator=(const Settlement &other) {
     if (this != &other) 
     {
-        const_cast<string&>(name) = other.name; 
+        const_cast<uint32_t&>(name) = other.name; 
         type = other.type;
     }
     return *this;
 }
 
 const string &Settlement::getName() const {
+    return SymbolTable::resolve(name);
+}
+
+uint32_t Settlement::getNameSymbol() const {
     return name;
 }
 
@@ -26,7 +31,7 @@ SettlementType Settlement::getType() const {
 }
 
 const string Settlement::toString() const {
-    string ret = name;
+    string ret = getName();
     if (type == SettlementType::VILLAGE)
     {
         ret += "is a village";
@@ -5,133 +5,124 @@
 #include "SelectionPolicy.h"
 #include "Facility.h"
 #include "Simulation.h"
+#include "AllocationCounter.h"
+#include "Autosave.h"
+#include "ChangeFeed.h"
+#include "ConfigLoader.h"
+#include "Digest.h"
+#include "TimeSeries.h"
+#include "Pipeline.h"
+#include "PlanRecords.h"
+#include "Realtime.h"
+#include "SymbolTable.h"
+#include "Tracer.h"
 #include <iostream>
+#include <memory>
 #include <fstream>
 #include <sstream>
+#include <unordered_map>
 #include <vector>
+#include <unistd.h>
 
 using namespace std; 
 
-Simulation::Simulation(const string &configFilePath) : isRunning(true), planCounter(0) {
-    std::ifstream configFile(configFilePath);
-    if (!configFile.is_open())
-    {
-        cerr << "Error: could not open file " << configFilePath << endl;
-        return;
-    }
+//Forwards the events of Plan::step() to everything the simulation derives from its plans, and to
+//the change feed if there is one
+class StepObserver : public PlanObserver {
+    public:
+        StepObserver(Rollups &rollups, PlanColumns &planColumns, ChangeFeed *feed, const FacilityCatalog &facilities, int tick)
+        : rollups(rollups), planColumns(planColumns), feed(feed), facilities(facilities), tick(tick), availablePlan(-1) {}
 
-    string line;
-    while (getline(configFile, line))
-    {
-        vector<string> arguments = Auxiliary::parseArguments(line);
-        if(arguments.empty())
-        {
-            cout << "Error: invalid configuration line" << endl;
-            continue;
-        }
-        if (arguments[0]=="settlement")
-        {
-            if (arguments.size() != 3)
+        void onFacilitySelected(const Plan &plan, const Facility &facility) override {
+            planColumns.onFacilitySelected(plan, facility);
+            if (feed != nullptr && plan.getPlanStatus() == PlanStatus::BUSY)
             {
-                cerr << "Error: invalid Settlement configuration" << endl;
-                continue;
-            }
-            else
-            {
-                Settlement* settlement = new Settlement(arguments[1], (SettlementType)stoi(arguments[2]));
-                addSettlement(settlement);
+                feed->emit(ChangeEventType::BUSY, tick, plan, facilities.find(facility.getNameSymbol()));
             }
         }
-        else if (arguments[0]=="facility")
-        {
-            if (arguments.size()!=7)
-            {
-                cerr << "Error: invalid Facility configuration" << endl;
-                continue;
-            }
-            else
-            {
-                FacilityType facility(arguments[1], (FacilityCategory)stoi(arguments[2]), stoi(arguments[3]), stoi(arguments[4]), stoi(arguments[5]), stoi(arguments[6]));
-                addFacility(facility);
-            }
-        }
-        else if (arguments[0]=="plan")
-        {
-            if (arguments.size()!=3)
-            {
-                cerr << "Error: invalid Plan configuration" << endl;
-                continue;
-            }
-            else 
+
+        //A plan is always busy when its construction advances, so its first facility to become
+        //operational in a step makes it available
+        void onFacilityOperational(const Plan &plan, const Facility &facility) override {
+            rollups.onFacilityOperational(plan, facility);
+            planColumns.onFacilityOperational(plan, facility);
+            if (feed != nullptr)
             {
-                if (!Simulation::isSettlementExists(arguments[1]))
-                {
-                    cerr << "Error: Settlement does not exist" << endl;
-                    continue;
-                }
-                if (arguments[2]=="nve")
+                const int index = facilities.find(facility.getNameSymbol());
+                feed->emit(ChangeEventType::OPERATIONAL, tick, plan, index);
+                if (plan.getPlanId() != availablePlan)
                 {
-                    NaiveSelection* naiveSelection = new NaiveSelection();
-                    addPlan(Simulation::getSettlement(arguments[1]), naiveSelection);
-                }
-                else if (arguments[2]=="bal")
-                {
-                    BalancedSelection* balancedSelection = new BalancedSelection(0,0,0);
-                    addPlan(Simulation::getSettlement(arguments[1]), balancedSelection);
-                }
-                else if (arguments[2]=="eco")
-                {
-                    EconomySelection* economySelection = new EconomySelection();
-                    addPlan(Simulation::getSettlement(arguments[1]), economySelection);
-                }
-                else if (arguments[2]=="env")
-                {
-                    SustainabilitySelection* sustainabilitySelection = new SustainabilitySelection();
-                    addPlan(Simulation::getSettlement(arguments[1]), sustainabilitySelection);
-                }
-                else
-                {
-                    cerr << "Error: Invalid selection policy" << endl;
-                    continue;
+                    availablePlan = plan.getPlanId();
+                    feed->emit(ChangeEventType::AVAILABLE, tick, plan, index);
                 }
             }
         }
+
+    private:
+        Rollups &rollups;
+        PlanColumns &planColumns;
+        ChangeFeed *feed;
+        const FacilityCatalog &facilities;
+        const int tick;
+        int availablePlan; //The last plan made available in this step
+};
+
+Simulation::Simulation() : isRunning(true), backup(nullptr), output(&cout), recorder(nullptr), planRecords(nullptr), autosaver(nullptr), realtime(nullptr), feed(nullptr), pipeline(nullptr), planCounter(0), currentTick(0) {}
+
+Simulation::Simulation(const string &configFilePath) : isRunning(true), backup(nullptr), output(&cout), recorder(nullptr), planRecords(nullptr), autosaver(nullptr), realtime(nullptr), feed(nullptr), pipeline(nullptr), planCounter(0), currentTick(0) {
+    if (!ConfigLoader::load(configFilePath, *this))
+    {
+        cerr << "Error: could not open file " << configFilePath << endl;
     }
 }
 
 Simulation::Simulation(Simulation&& other)
 :   isRunning(other.isRunning),
+    backup(other.backup),
+    output(other.output),
+    recorder(other.recorder),
+    planRecords(other.planRecords),
+    autosaver(other.autosaver),
+    realtime(other.realtime),
+    feed(other.feed),
+    pipeline(nullptr),
     planCounter(other.planCounter),
+    currentTick(other.currentTick),
     actionsLog(move(other.actionsLog)),
     plans(move(other.plans)),
     settlements(move(other.settlements)),
-    facilitiesOptions(move(other.facilitiesOptions)) {}
+    facilitiesOptions(move(other.facilitiesOptions)),
+    rollups(move(other.rollups)),
+    planColumns(move(other.planColumns)) {
+        other.backup = nullptr;
+        other.recorder = nullptr;
+        other.planRecords = nullptr;
+        other.autosaver = nullptr;
+        other.realtime = nullptr;
+        other.feed = nullptr;
+}
 
 Simulation::Simulation(Simulation& other)
 :   isRunning(other.isRunning),
+    backup(nullptr),
+    output(other.output),
+    recorder(nullptr),
+    planRecords(nullptr),
+    autosaver(nullptr),
+    realtime(nullptr),
+    feed(nullptr),
+    pipeline(nullptr),
     planCounter(other.planCounter),
+    currentTick(other.currentTick),
+    actionsLog(other.actionsLog),
     facilitiesOptions(other.facilitiesOptions) {    
-        for (BaseAction* ptr : other.actionsLog)
-        {
-            this->actionsLog.push_back(ptr->clone());
-        }
-        for(Settlement* q: other.settlements)
-        {
-            this->settlements.push_back(new Settlement(*q));
-        }
-        for(Plan p: other.plans)
-        {
-            plans.push_back(Plan(p, findSettlement(p.getSettlementName())));
-        }
+        TraceSpan span("copy simulation");
+        copyPlans(other);
 }
 
 Simulation& Simulation::operator=(Simulation&& other) {
     if (this != &other)
     {
-        for (BaseAction* ptr : actionsLog)
-        {
-            delete ptr;
-        }
         for (Settlement* ptr : settlements)
         {
             delete ptr;
@@ -140,8 +131,29 @@ Simulation& Simulation::operator=(Simulation&& other) {
         plans = std::move(other.plans);
         settlements = std::move(other.settlements);
         facilitiesOptions = std::move(other.facilitiesOptions);
+        rollups = std::move(other.rollups);
+        planColumns = std::move(other.planColumns);
+        delete backup;
+        backup = other.backup;
+        other.backup = nullptr;
+        delete recorder;
+        recorder = other.recorder;
+        other.recorder = nullptr;
+        delete planRecords;
+        planRecords = other.planRecords;
+        other.planRecords = nullptr;
+        delete autosaver;
+        autosaver = other.autosaver;
+        other.autosaver = nullptr;
+        delete realtime;
+        realtime = other.realtime;
+        other.realtime = nullptr;
+        delete feed;
+        feed = other.feed;
+        other.feed = nullptr;
         isRunning = other.isRunning;
         planCounter = other.planCounter;
+        currentTick = other.currentTick;
     }
     return *this;
 }
@@ -149,182 +161,451 @@ Simulation& Simulation::operator=(Simulation&& other) {
    Simulation& Simulation::operator=(Simulation& other){
     if (this != &other) 
     {
-        for (BaseAction* ptr : actionsLog)
-        {
-            delete ptr;
-        }
+        TraceSpan span("copy simulation");
         for (Settlement* ptr : settlements)
         {
             delete ptr;
         }
-        actionsLog.clear();
         plans.clear();
         settlements.clear();
-        facilitiesOptions.clear();
-        for (BaseAction* ptr : other.actionsLog)
-        {
-            actionsLog.push_back(ptr->clone());
-        }
-        for(Settlement* q: other.settlements)
-        {
-            settlements.push_back(new Settlement(*q));
-        }
-        for (Plan p : other.plans)
-        {
-            plans.push_back(Plan(p,findSettlement(p.getSettlementName())));
-        }
+        delete planRecords;
+        planRecords = nullptr;
+        actionsLog = other.actionsLog;
         facilitiesOptions = other.facilitiesOptions;
+        copyPlans(other);
         isRunning = other.isRunning;
         planCounter = other.planCounter;
+        currentTick = other.currentTick;
     }
     return *this;
 }
 
 Simulation::~Simulation(){
-    for (BaseAction* ptr : actionsLog)
-    {
-        delete ptr;
-    }
+    delete feed;
+    delete realtime;
+    delete autosaver;
+    delete planRecords;
+    delete recorder;
+    delete backup;
     for (Settlement* ptr : settlements)
     {
         delete ptr;
     }
 }
 
+//Runs the command loop on a CommandPipeline, until the simulation is closed or its input ends
 void Simulation::start() {
-    cout << "The simulation has started" << std::endl;
+    out() << "The simulation has started" << std::endl;
     open();
+    CommandPipeline pipeline(*this, STDIN_FILENO);
     while (isRunning) 
     {
-        cout << "Enter an action you'd like to perform: ";
-        string command;
-        getline(cin, command);
-        istringstream iss(command);
-        string action;
-        iss >> action;
-        if (action == "step")
-        {
-            int numOfSteps;
-            iss >> numOfSteps;
-            const int steps = numOfSteps;
-            SimulateStep *simulateStep = new SimulateStep(steps);
-            simulateStep->act(*this);
-            addAction(simulateStep);
-        }
-        if (action == "plan")
-        {
-            string settlementName, selectionPolicy;
-            iss >> settlementName >> selectionPolicy;
-            AddPlan* addPlan = new AddPlan(settlementName, selectionPolicy);
-            addPlan->act(*this);
-            addAction(addPlan);
-        }
-        if (action == "settlement")
-        {
-            string setname;
-            int settype;
-            iss >> setname >> settype;
-            SettlementType a;
-            if (settype == 0)
-            {
-                a = SettlementType::VILLAGE; 
-            }
-            else if (settype==1)
-            {
-                a = SettlementType::CITY;
-            }
-            else 
-            {
-                a = SettlementType::METROPOLIS; 
-            }
-            AddSettlement* addSettlement = new AddSettlement(setname, a);
-            addSettlement->act(*this);
-            addAction(addSettlement); 
-        }
-        if (action == "facility")
+        if (realtime != nullptr)
         {
-            string name;
-            int category;
-            int price;
-            int lifeq;
-            int eco;
-            int env;
-            iss >> name >> category >> price >> lifeq >> eco >> env;
-            FacilityCategory a;
-            if (category == 0)
-            {
-                a = FacilityCategory::LIFE_QUALITY;
-            }
-            if (category == 1)
-            {
-                a = FacilityCategory::ECONOMY;
-            }
-            else 
-            {
-                a = FacilityCategory::ENVIRONMENT;
-            }
-            AddFacility* current = new AddFacility(name, a, price, lifeq, eco, env);
-            current->act(*this);
-            addAction(current);
+            realtime->run(*this, pipeline);
+            continue;
         }
-        if (action == "planStatus")
+        ParsedCommand command;
+        if (!pipeline.next(command))
         {
-            int id;
-            iss >> id;
-            PrintPlanStatus* pps = new PrintPlanStatus(id);
-            pps->act(*this);
-            addAction(pps);
+            break;
         }
-        if (action == "changePolicy")
+        pipeline.performCoalesced(command);
+    }
+}
+
+//Parsers of the commands, each reads the arguments of its command. The label starts out as the
+//command's name.
+
+static BaseAction *parseStep(istringstream &iss, string &) {
+    int numOfSteps;
+    iss >> numOfSteps;
+    const int steps = numOfSteps;
+    return new SimulateStep(steps);
+}
+
+static BaseAction *parsePlan(istringstream &iss, string &label) {
+    string settlementName, selectionPolicy;
+    iss >> settlementName >> selectionPolicy;
+    if (AddPlans::isSelector(settlementName))
+    {
+        label += " " + settlementName;
+        return new AddPlans(settlementName, selectionPolicy);
+    }
+    return new AddPlan(settlementName, selectionPolicy);
+}
+
+static BaseAction *parseSettlement(istringstream &iss, string &) {
+    string setname;
+    int settype;
+    iss >> setname >> settype;
+    SettlementType a;
+    if (settype == 0)
+    {
+        a = SettlementType::VILLAGE; 
+    }
+    else if (settype==1)
+    {
+        a = SettlementType::CITY;
+    }
+    else 
+    {
+        a = SettlementType::METROPOLIS; 
+    }
+    return new AddSettlement(setname, a);
+}
+
+static BaseAction *parseFacility(istringstream &iss, string &) {
+    string name;
+    int category;
+    int price;
+    int lifeq;
+    int eco;
+    int env;
+    iss >> name >> category >> price >> lifeq >> eco >> env;
+    FacilityCategory a;
+    if (category == 0)
+    {
+        a = FacilityCategory::LIFE_QUALITY;
+    }
+    if (category == 1)
+    {
+        a = FacilityCategory::ECONOMY;
+    }
+    else 
+    {
+        a = FacilityCategory::ENVIRONMENT;
+    }
+    return new AddFacility(name, a, price, lifeq, eco, env);
+}
+
+static BaseAction *parsePlanStatus(istringstream &iss, string &) {
+    int id;
+    iss >> id;
+    return new PrintPlanStatus(id);
+}
+
+static BaseAction *parseChangePolicy(istringstream &iss, string &label) {
+    string first;
+    string policy;
+    iss >> first;
+    if (first == "range")
+    {
+        int from = -1, to = -1;
+        iss >> from >> to >> policy;
+        label += " range";
+        return new ChangePlanPolicies(from, to, policy);
+    }
+    int id = 0;
+    istringstream(first) >> id;
+    iss >> policy;
+    return new ChangePlanPolicy(id, policy);
+}
+
+static BaseAction *parseLog(istringstream &iss, string &) {
+    int from, count;
+    return (iss >> from >> count) ? new PrintActionsLog(from, count) : new PrintActionsLog();
+}
+
+static BaseAction *parseClose(istringstream &, string &) {
+    return new Close();
+}
+
+static BaseAction *parseBackup(istringstream &, string &) {
+    return new BackupSimulation();
+}
+
+static BaseAction *parseRestore(istringstream &, string &) {
+    return new RestoreSimulation();
+}
+
+static BaseAction *parseSummary(istringstream &iss, string &) {
+    string settlementName;
+    iss >> settlementName;
+    return new PrintSummary(settlementName);
+}
+
+static BaseAction *parseTop(istringstream &iss, string &) {
+    int count = -1;
+    string metric;
+    iss >> count >> metric;
+    return new PrintLeaderboard(count, metric);
+}
+
+static BaseAction *parseQuery(istringstream &iss, string &) {
+    string query;
+    getline(iss >> ws, query);
+    return new QueryPlans(query);
+}
+
+static BaseAction *parseRecord(istringstream &iss, string &) {
+    string path;
+    iss >> path;
+    return new RecordTimeSeries(path);
+}
+
+static BaseAction *parseSpill(istringstream &iss, string &) {
+    string path;
+    iss >> path;
+    return new SpillPlans(path);
+}
+
+static BaseAction *parseAutosave(istringstream &iss, string &) {
+    string interval;
+    string directory;
+    iss >> interval >> directory;
+    int everyNumOfTicks = 0;
+    istringstream(interval) >> everyNumOfTicks;
+    return new Autosave(everyNumOfTicks, interval == "off" ? interval : directory);
+}
+
+static BaseAction *parseDigest(istringstream &iss, string &) {
+    int id = -1;
+    iss >> id;
+    return new PrintDigest(id);
+}
+
+static BaseAction *parseRealtime(istringstream &iss, string &) {
+    string interval;
+    string policy;
+    iss >> interval >> policy;
+    int msPerTick = 0;
+    istringstream(interval) >> msPerTick;
+    return new RunRealtime(msPerTick, interval == "off" ? interval : policy);
+}
+
+static BaseAction *parseTrace(istringstream &iss, string &) {
+    string path;
+    string detail;
+    iss >> path >> detail;
+    return new RecordTrace(path, detail);
+}
+
+static BaseAction *parseFeed(istringstream &iss, string &) {
+    string output;
+    string path;
+    string policy;
+    iss >> output >> path >> policy;
+    return new FeedChanges(output, path, policy);
+}
+
+//delays seed <n> | delays <category> fixed | delays <category> uniform <low> <high> |
+//delays <category> triangular <low> <mode> <high> | delays off
+static BaseAction *parseDelays(istringstream &iss, string &) {
+    string target;
+    string distribution;
+    int low = 0;
+    int mode = -1;
+    int high = 0;
+    iss >> target;
+    if (target == "seed")
+    {
+        iss >> low;
+    }
+    else if (target != "off")
+    {
+        iss >> distribution;
+        if (distribution == "uniform")
         {
-            int id;
-            string policy;
-            iss >> id >> policy;
-            ChangePlanPolicy* cpp = new ChangePlanPolicy(id, policy);
-            cpp->act(*this);
-            addAction(cpp);
+            iss >> low >> high;
         }
-        if (action == "log")
+        else if (distribution == "triangular")
         {
-            PrintActionsLog* pal = new PrintActionsLog();
-            pal->act(*this);
-            addAction(pal);
+            iss >> low >> mode >> high;
         }
-        if (action == "close")
+    }
+    return new SetDelays(target, distribution, low, mode, high);
+}
+
+static BaseAction *parseMonteCarlo(istringstream &iss, string &) {
+    int numOfRuns = 0;
+    int numOfSteps = -1;
+    iss >> numOfRuns >> numOfSteps;
+    return new RunMonteCarlo(numOfRuns, numOfSteps);
+}
+
+typedef BaseAction *(*CommandParser)(istringstream &iss, string &label);
+
+static const unordered_map<string, CommandParser> commandParsers = {
+    {"step", parseStep},
+    {"plan", parsePlan},
+    {"settlement", parseSettlement},
+    {"facility", parseFacility},
+    {"planStatus", parsePlanStatus},
+    {"changePolicy", parseChangePolicy},
+    {"log", parseLog},
+    {"close", parseClose},
+    {"backup", parseBackup},
+    {"restore", parseRestore},
+    {"summary", parseSummary},
+    {"top", parseTop},
+    {"query", parseQuery},
+    {"record", parseRecord},
+    {"spill", parseSpill},
+    {"autosave", parseAutosave},
+    {"digest", parseDigest},
+    {"realtime", parseRealtime},
+    {"trace", parseTrace},
+    {"feed", parseFeed},
+    {"delays", parseDelays},
+    {"montecarlo", parseMonteCarlo},
+};
+
+//Parses a command line into its action, and the label it is performed under. Returns null for
+//unknown commands.
+BaseAction *Simulation::parse(const string &command, string &label) {
+    istringstream iss(command);
+    string action;
+    iss >> action;
+    const auto parser = commandParsers.find(action);
+    if (parser == commandParsers.end())
+    {
+        return nullptr;
+    }
+    label = action;
+    return parser->second(iss, label);
+}
+
+void Simulation::execute(const string &command) {
+    string label;
+    BaseAction *action = parse(command, label);
+    if (action != nullptr)
+    {
+        perform(label, action);
+    }
+}
+
+//Runs a command's action and logs it. When allocations are counted, the action is held to the
+//allocation budget of its command.
+void Simulation::perform(const string &command, BaseAction *action) {
+    const size_t allocations = AllocationCounter::getCount();
+    {
+        TraceSpan span(Tracer::isEnabled(Tracer::COMMANDS) ? Tracer::intern("act " + command) : "");
+        action->act(*this);
+    }
+    if (AllocationCounter::isEnabled() && action->getStatus() == ActionStatus::COMPLETED)
+    {
+        AllocationCounter::check(command, AllocationCounter::getCount() - allocations);
+    }
+    addAction(action);
+}
+
+//Returns the id of the new plan, or -1 if it could not be created
+int Simulation::addPlan(const Settlement &settlement, SelectionPolicy *selectionPolicy) {
+    if(!(isSettlementExists(settlement.getName()))) 
+    {
+        out() << "Cannot create plan" << endl;
+        return -1;
+    }
+    if (planRecords != nullptr)
+    {
+        //Spilled plans only have room for the state of a built in policy
+        PolicyState policy;
+        const bool builtIn = selectionPolicy != nullptr && selectionPolicy->getState(policy);
+        delete selectionPolicy;
+        if (!builtIn)
         {
-            Close* close = new Close();
-            close->act(*this);
-            addAction(close);
+            out() << "Cannot create plan" << endl;
+            return -1;
         }
-        if (action == "backup")
+        return addPlan(settlement, policy);
+    }
+    const int currentPlanId = planCounter;
+    planCounter++;
+    plans.emplace_back(currentPlanId, settlement, selectionPolicy, facilitiesOptions);
+    registerPlan(plans.back());
+    return currentPlanId;
+}
+
+int Simulation::addPlan(const Settlement &settlement, const PolicyState &policy) {
+    if(!(isSettlementExists(settlement.getName()))) 
+    {
+        out() << "Cannot create plan" << endl;
+        return -1;
+    }
+    if (planRecords != nullptr)
+    {
+        for (size_t i = 0; i < settlements.size(); i++)
         {
-            BackupSimulation* bs = new BackupSimulation();           
-            bs->act(*this);
-            addAction(bs);
+            if (settlements[i]->getNameSymbol() == settlement.getNameSymbol())
+            {
+                return addPlanRecord(i, policy);
+            }
         }
-        if (action == "restore")
+    }
+    const int currentPlanId = planCounter;
+    planCounter++;
+    plans.emplace_back(currentPlanId, settlement, policy, facilitiesOptions);
+    registerPlan(plans.back());
+    return currentPlanId;
+}
+
+//Adds a plan with the policy to every settlement of a type, or to every settlement for type -1,
+//in one pass with the storage for all of them reserved up front. Returns the number of plans added.
+size_t Simulation::addPlans(int settlementType, const PolicyState &policy) {
+    vector<size_t> indices;
+    findSettlements(settlementType, indices);
+    if (planRecords != nullptr)
+    {
+        for (size_t index : indices)
         {
-            RestoreSimulation* rs = new RestoreSimulation();
-            rs->act(*this);
-            addAction(rs);
+            addPlanRecord(index, policy);
         }
+        return indices.size();
+    }
+    plans.reserve(plans.size() + indices.size());
+    rollups.reserve(plans.size() + indices.size(), settlements.size());
+    planColumns.reserve(plans.size() + indices.size(), settlements.size());
+    for (size_t index : indices)
+    {
+        registerPlan(plans.emplace_back(planCounter++, *settlements[index], policy, facilitiesOptions));
     }
+    return indices.size();
 }
 
-void Simulation::addPlan(const Settlement &settlement, SelectionPolicy *selectionPolicy) {
-    if(!(isSettlementExists(settlement.getName()))) 
+//As above, every plan gets a clone of the prototype
+size_t Simulation::addPlans(int settlementType, const SelectionPolicy &prototype) {
+    PolicyState policy;
+    if (prototype.getState(policy))
     {
-        cout << "Cannot create plan" << endl;
-        return;
+        return addPlans(settlementType, policy);
     }
-    const int currentPlanId = planCounter;
-    planCounter++;
-    Plan toAdd(currentPlanId,settlement, selectionPolicy,facilitiesOptions);
-    plans.push_back(toAdd);
+    if (planRecords != nullptr)
+    {
+        return 0;
+    }
+    vector<size_t> indices;
+    findSettlements(settlementType, indices);
+    plans.reserve(plans.size() + indices.size());
+    rollups.reserve(plans.size() + indices.size(), settlements.size());
+    planColumns.reserve(plans.size() + indices.size(), settlements.size());
+    for (size_t index : indices)
+    {
+        registerPlan(plans.emplace_back(planCounter++, *settlements[index], prototype.clone(), facilitiesOptions));
+    }
+    return indices.size();
 }
 
+void Simulation::findSettlements(int settlementType, vector<size_t> &indices) const {
+    for (size_t i = 0; i < settlements.size(); i++)
+    {
+        if (settlementType < 0 || (int)settlements[i]->getType() == settlementType)
+        {
+            indices.push_back(i);
+        }
+    }
+}
+
+//Returns the id of the plan, which is its index in the record file
+int Simulation::addPlanRecord(int settlementIndex, const PolicyState &policy) {
+    planRecords->append(PlanRecordFile::makeRecord(settlementIndex, settlements[settlementIndex]->getType(), policy));
+    return planCounter++;
+}
+
+//Logs the action and deletes it, the log keeps a compact record of it
 void Simulation::addAction(BaseAction *action) {
-    actionsLog.push_back(action);
+    actionsLog.append(action->toRecord(actionsLog));
+    delete action;
 }
 
 bool Simulation::addSettlement(Settlement *settlement) {
@@ -333,92 +614,184 @@ bool Simulation::addSettlement(Settlement *settlement) {
         return false;
     }
     settlements.push_back(settlement);
+    registerSettlement(*settlement);
     return true;
 }
 
 bool Simulation::addFacility(FacilityType facility) {
-    for(FacilityType facil: facilitiesOptions)
+    if (facilitiesOptions.find(facility.getNameSymbol()) != FacilityCatalog::NOT_FOUND)
     {
-        if (facil.getName()==facility.getName())
-        {
-            return false;
-        }
+        return false;
     }
-    facilitiesOptions.push_back(facility);
+    facilitiesOptions = facilitiesOptions.add(facility);
     return true;
 }
 
 bool Simulation::isSettlementExists(const string &settlementName) {
-    for (const Settlement *settlement : settlements)
-    {
-        if (settlement->getName() == settlementName)
-        {
-            return true;
-        }
-    }
-    return false;
+    return findSettlement(settlementName) != nullptr;
 }
 
 
 bool Simulation::isPlanExists(const int planID) {
-    for (Plan plan : plans)
-    {
-        if (plan.getPlanId() == planID)
-        {
-            return true;
-        }
-    }
-    return false;
+    return findPlan(planID) != nullptr;
 }
 Settlement &Simulation::getSettlement(const string &settlementName) {
-    if (isSettlementExists(settlementName))
+    Settlement *settlement = findSettlement(settlementName);
+    if (settlement != nullptr)
     {
-        for (Settlement *settlement : settlements)
-        {
-            if (settlement->getName() == settlementName)
-            {
-                return *settlement;
-            }
-        }
+        return *settlement;
     }
     throw std::logic_error("Settlement not found");
 }
 
 Plan &Simulation::getPlan(const int planID) {
-    for (Plan& plan : plans)
+    Plan* plan = findPlan(planID);
+    if (plan == nullptr)
     {
-        if (plan.getPlanId() == planID)
-        {
-            return plan;
-        }
+        throw std::logic_error("Plan not found");
     }
-    throw std::logic_error("Plan not found");
+    return *plan;
 }
 
-vector<BaseAction*>& Simulation::getActionsLog() {
+ActionLog& Simulation::getActionsLog() {
     return actionsLog;
 }
 
-vector<Plan>& Simulation::getPlans() {
+//In memory or spilled
+bool Simulation::hasPlans() const {
+    return planRecords != nullptr ? planRecords->size() > 0 : !plans.empty();
+}
+
+PlanStore& Simulation::getPlans() {
     return plans;
 }
 
+const vector<Settlement*>& Simulation::getSettlements() const {
+    return settlements;
+}
+
+const FacilityCatalog& Simulation::getFacilityOptions() const {
+    return facilitiesOptions;
+}
+
+//Takes over a catalog with the same facilities as this simulation's, so simulations loaded from the
+//same configuration keep one copy of it. Plans and facilities copy what they use of a catalog.
+bool Simulation::shareFacilityOptions(const FacilityCatalog &catalog) {
+    if (!facilitiesOptions.isSameAs(catalog))
+    {
+        return false;
+    }
+    facilitiesOptions = catalog;
+    return true;
+}
+
+Rollups& Simulation::getRollups() {
+    return rollups;
+}
+
+PlanColumns& Simulation::getPlanColumns() {
+    return planColumns;
+}
+
+void Simulation::setPlanPolicy(Plan &plan, SelectionPolicy *selectionPolicy) {
+    plan.setSelectionPolicy(selectionPolicy);
+    rollups.changePolicy(plan);
+    planColumns.changePolicy(plan);
+}
+
+void Simulation::setPlanPolicy(Plan &plan, const PolicyState &policy) {
+    plan.setSelectionPolicy(policy);
+    rollups.changePolicy(plan);
+    planColumns.changePolicy(plan);
+}
+
+//Copies the settlements and plans of another simulation. Every plan is constructed in place, with
+//the copy of its settlement and this simulation's facility options.
+void Simulation::copyPlans(const Simulation &other) {
+    unordered_map<const Settlement*, Settlement*> copies;
+    settlements.reserve(other.settlements.size());
+    for (const Settlement *settlement : other.settlements)
+    {
+        settlements.push_back(new Settlement(*settlement));
+        copies[settlement] = settlements.back();
+    }
+    plans.reserve(other.plans.size());
+    for (const Plan &plan : other.plans)
+    {
+        plans.emplace_back(plan, *copies[&plan.getSettlement()], facilitiesOptions);
+    }
+    rebuildDerivedState();
+}
+
+//A settlement gets its totals and its query id when it is added, so its first plan does not allocate them
+void Simulation::registerSettlement(const Settlement &settlement) {
+    rollups.addSettlement(settlement.getNameSymbol());
+    planColumns.addSettlement(settlement.getNameSymbol());
+}
+
+void Simulation::registerPlan(const Plan &plan) {
+    rollups.addPlan(plan);
+    planColumns.addPlan(plan);
+}
+
+void Simulation::rebuildDerivedState() {
+    rollups.rebuild(plans);
+    planColumns.rebuild(plans);
+    for (const Settlement *settlement : settlements)
+    {
+        registerSettlement(*settlement);
+    }
+}
+
  void Simulation::step() {
+    TraceSpan span("step", Tracer::COMMANDS, currentTick + 1);
+    if (planRecords != nullptr)
+    {
+        if (planRecords->size() == 0)
+        {
+            out() << "Warning: No plans to simulate." << endl;
+            return;
+        }
+        if (!planRecords->step(facilitiesOptions))
+        {
+            out() << "Warning: Could not step the plans in " << planRecords->getPath() << endl;
+            return;
+        }
+        currentTick++;
+        return;
+    }
     if (plans.empty()) 
     {
-        cout << "Warning: No plans to simulate." << endl;
+        out() << "Warning: No plans to simulate." << endl;
         return;
     }
+    StepObserver observer(rollups, planColumns, feed, facilitiesOptions, currentTick + 1);
     for(Plan& plan : plans)
     {
-        plan.step();
+        plan.step(&observer);
     }
+    currentTick++;
+    if (feed != nullptr)
+    {
+        feed->publish();
+    }
+    if (recorder != nullptr && !recorder->record(currentTick, plans))
+    {
+        out() << "Error: Cannot write the time series, recording stopped" << endl;
+        stopRecording();
+    }
+}
+
+//A name that was never interned cannot be a settlement's
+Settlement* Simulation::findSettlement(const string &st){
+    uint32_t symbol;
+    return SymbolTable::find(st, symbol) ? findSettlement(symbol) : nullptr;
 }
 
-Settlement* Simulation::findSettlement(const string st){
+Settlement* Simulation::findSettlement(uint32_t symbol) {
     for (Settlement* b : settlements) 
     {
-        if (b->getName() == st)
+        if (b->getNameSymbol() == symbol)
         {
             return b;
         }
@@ -426,6 +799,10 @@ Settlement* Simulation::findSettlement(const string st){
     return nullptr;
 }
 
+Plan* Simulation::findPlan(const int planID) {
+    return plans.find(planID);
+}
+
 void Simulation::close() {
     isRunning = false;
 }
@@ -434,5 +811,201 @@ void Simulation::open() {
     isRunning = true;
 }
 
+bool Simulation::isOpen() const {
+    return isRunning;
+}
+
+Simulation* Simulation::getBackup() {
+    return backup;
+}
+
+void Simulation::setBackup(Simulation* snapshot) {
+    if (backup != snapshot)
+    {
+        delete backup;
+        backup = snapshot;
+    }
+}
 
+ostream &Simulation::out() {
+    return *output;
+}
+
+void Simulation::setOutput(ostream &output) {
+    this->output = &output;
+}
+
+//Writes text rendered apart from the output after what was written so far. The pipeline of start()
+//hands the parts on as they are, to be written out with one writev.
+void Simulation::writeParts(vector<string> &parts) {
+    if (pipeline != nullptr)
+    {
+        pipeline->handOn(parts);
+        return;
+    }
+    for (const string &part : parts)
+    {
+        output->write(part.data(), part.size());
+    }
+}
+
+int Simulation::getTick() const {
+    return currentTick;
+}
+
+//The digests of all plans combined in plan id order, plans are stored in the order of their ids
+uint64_t Simulation::getDigest() const {
+    uint64_t digest = Digest::SEED;
+    for (const Plan &plan : plans)
+    {
+        digest = Digest::mix(digest, plan.getDigest());
+    }
+    return digest;
+}
+
+bool Simulation::startRecording(const string &path) {
+    stopRecording();
+    recorder = new TimeSeriesRecorder(path);
+    if (!recorder->isOpen())
+    {
+        stopRecording();
+        return false;
+    }
+    return true;
+}
+
+//Returns false if some of the series could not be written
+bool Simulation::stopRecording() {
+    const bool written = recorder == nullptr || recorder->close();
+    delete recorder;
+    recorder = nullptr;
+    return written;
+}
+
+//Writes a checkpoint to 'directory' every 'everyNumOfTicks' ticks of step, see Autosaver.
+//Fails if the plans are spilled, since the record file is not part of the forked image.
+bool Simulation::startAutosave(int everyNumOfTicks, const string &directory) {
+    stopAutosave();
+    if (planRecords != nullptr || everyNumOfTicks <= 0 || access(directory.c_str(), W_OK | X_OK) != 0)
+    {
+        return false;
+    }
+    autosaver = new Autosaver(everyNumOfTicks, directory);
+    return true;
+}
+
+void Simulation::stopAutosave() {
+    if (autosaver != nullptr)
+    {
+        autosaver->finish(*this);
+        delete autosaver;
+        autosaver = nullptr;
+    }
+}
+
+Autosaver *Simulation::getAutosaver() {
+    return autosaver;
+}
 
+//Steps the simulation every 'msPerTick' milliseconds of wall clock time from now on, see
+//RealtimeClock. The clock takes over the command loop of start() and keeps it after it is stopped.
+bool Simulation::startRealtime(int msPerTick, bool dropLateTicks) {
+    if (realtime == nullptr)
+    {
+        realtime = new RealtimeClock();
+    }
+    return realtime->arm(msPerTick, dropLateTicks);
+}
+
+//Stops the clock and prints how late its ticks were
+void Simulation::stopRealtime() {
+    if (realtime != nullptr && realtime->isArmed())
+    {
+        realtime->disarm();
+        realtime->printLateness(out());
+    }
+}
+
+//Builds the facilities selected from now on in random times, see ConstructionDelays. Backups keep
+//the delays they were taken with, along with the catalog.
+void Simulation::setDelays(const ConstructionDelays &delays) {
+    facilitiesOptions = facilitiesOptions.withDelays(make_shared<const ConstructionDelays>(delays));
+}
+
+void Simulation::clearDelays() {
+    facilitiesOptions = facilitiesOptions.withDelays(nullptr);
+}
+
+//Feeds the changes of every step to 'output' at 'path' from now on, see ChangeFeed. Fails if the
+//plans are spilled, since spilled plans are stepped without observers.
+bool Simulation::startFeed(const string &output, const string &path, bool dropWhenFull) {
+    stopFeed();
+    if (planRecords != nullptr)
+    {
+        return false;
+    }
+    feed = new ChangeFeed(output, path, dropWhenFull);
+    if (!feed->isOpen())
+    {
+        delete feed;
+        feed = nullptr;
+        return false;
+    }
+    return true;
+}
+
+//Stops the feed once its queued events are written, and prints how many events there were
+void Simulation::stopFeed() {
+    if (feed != nullptr)
+    {
+        feed->close();
+        out() << "Events: " << feed->getNumOfEvents() << ", written: " << feed->getNumOfWritten()
+            << ", dropped: " << feed->getNumOfDropped() << endl;
+        delete feed;
+        feed = nullptr;
+    }
+}
+
+//Moves every plan to a record file at 'path', see PlanRecordFile. From then on plans are added to
+//and stepped in the file, and what is derived from the plans in memory (rollups, columns, the time
+//series) is no longer kept. Fails if the plans are already spilled, one has a custom policy,
+//checkpoints are being written, changes fed or construction times are random.
+bool Simulation::spill(const string &path) {
+    if (planRecords != nullptr || autosaver != nullptr || feed != nullptr || facilitiesOptions.getDelays() != nullptr)
+    {
+        return false;
+    }
+    PlanRecordFile *records = new PlanRecordFile();
+    if (!records->create(path))
+    {
+        delete records;
+        return false;
+    }
+    unordered_map<string, int> settlementIndices;
+    for (size_t i = 0; i < settlements.size(); i++)
+    {
+        settlementIndices[settlements[i]->getName()] = i;
+    }
+    for (const Plan &plan : plans)
+    {
+        PlanRecord record;
+        if (!records->toRecord(plan, settlementIndices[plan.getSettlementName()], facilitiesOptions, record) || !records->append(record))
+        {
+            delete records;
+            return false;
+        }
+    }
+    plans.clear();
+    rebuildDerivedState();
+    stopRecording();
+    planRecords = records;
+    return true;
+}
+
+bool Simulation::isSpilled() const {
+    return planRecords != nullptr;
+}
+
+PlanRecordFile *Simulation::getPlanRecords() {
+    return planRecords;
+}
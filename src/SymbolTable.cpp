@@ -0,0 +1,120 @@
+#include "SymbolTable.h"
+#include <functional>
+
+using namespace std;
+
+const size_t SymbolTable::CHUNK_BITS;
+const size_t SymbolTable::CHUNK_SYMBOLS;
+const size_t SymbolTable::MAX_CHUNKS;
+
+//----------------------------------------------------------------
+//SymbolTable Class
+//----------------------------------------------------------------
+
+SymbolTable::Index::Index(size_t size): mask(size - 1), slots(new atomic<uint32_t>[size]) {
+    for (size_t i = 0; i < size; i++)
+    {
+        slots[i].store(0, memory_order_relaxed);
+    }
+}
+
+SymbolTable::SymbolTable(): mutex(), numOfSymbols(0), index(nullptr) {
+    for (size_t i = 0; i < MAX_CHUNKS; i++)
+    {
+        chunks[i].store(nullptr, memory_order_relaxed);
+    }
+    indices.push_back(unique_ptr<Index>(new Index(CHUNK_SYMBOLS)));
+    index.store(indices.back().get(), memory_order_release);
+    add("", findSlot(*indices.back(), ""));
+}
+
+//Constructed on first use, so names can be interned during static initialization. Never destroyed,
+//names may be resolved until the very end of the process.
+SymbolTable &SymbolTable::instance() {
+    static SymbolTable *table = new SymbolTable();
+    return *table;
+}
+
+uint32_t SymbolTable::intern(const string &name) {
+    uint32_t symbol;
+    if (find(name, symbol))
+    {
+        return symbol;
+    }
+    SymbolTable &table = instance();
+    lock_guard<std::mutex> lock(table.mutex);
+    //Another thread may have added the name since, or grown the index
+    const size_t slot = findSlot(*table.indices.back(), name);
+    const uint32_t entry = table.indices.back()->slots[slot].load(memory_order_relaxed);
+    if (entry != 0)
+    {
+        return entry - 1;
+    }
+    return table.add(name, slot);
+}
+
+//Adds a name that is not in the table yet, 'slot' is its empty slot in the current index
+uint32_t SymbolTable::add(const string &name, size_t slot) {
+    const uint32_t symbol = numOfSymbols;
+    string *chunk = chunks[symbol >> CHUNK_BITS].load(memory_order_relaxed);
+    if (chunk == nullptr)
+    {
+        chunk = new string[CHUNK_SYMBOLS];
+    }
+    chunk[symbol & (CHUNK_SYMBOLS - 1)] = name;
+    //Publishes the string along with the chunk, for resolve() on other threads
+    chunks[symbol >> CHUNK_BITS].store(chunk, memory_order_release);
+    //Publishes the symbol for find(), after the string it resolves to
+    indices.back()->slots[slot].store(symbol + 1, memory_order_release);
+    numOfSymbols++;
+    if (2 * numOfSymbols > indices.back()->mask + 1)
+    {
+        grow();
+    }
+    return symbol;
+}
+
+//Takes no lock. A name being added on another thread at the same time may not be found yet.
+bool SymbolTable::find(const string &name, uint32_t &symbol) {
+    const Index &index = *instance().index.load(memory_order_acquire);
+    const uint32_t entry = index.slots[findSlot(index, name)].load(memory_order_acquire);
+    if (entry == 0)
+    {
+        return false;
+    }
+    symbol = entry - 1;
+    return true;
+}
+
+//The slot of the name, or the empty slot it would go in
+size_t SymbolTable::findSlot(const Index &index, const string &name) {
+    size_t slot = hash<string>()(name) & index.mask;
+    uint32_t entry;
+    while ((entry = index.slots[slot].load(memory_order_acquire)) != 0 && resolve(entry - 1) != name)
+    {
+        slot = (slot + 1) & index.mask;
+    }
+    return slot;
+}
+
+//Fills a twice as large index and publishes it, the previous one stays for readers still probing it
+void SymbolTable::grow() {
+    const Index &previous = *indices.back();
+    unique_ptr<Index> larger(new Index(2 * (previous.mask + 1)));
+    for (size_t i = 0; i <= previous.mask; i++)
+    {
+        const uint32_t entry = previous.slots[i].load(memory_order_relaxed);
+        if (entry != 0)
+        {
+            //Names are distinct, so the first empty slot is the name's
+            size_t slot = hash<string>()(resolve(entry - 1)) & larger->mask;
+            while (larger->slots[slot].load(memory_order_relaxed) != 0)
+            {
+                slot = (slot + 1) & larger->mask;
+            }
+            larger->slots[slot].store(entry, memory_order_relaxed);
+        }
+    }
+    indices.push_back(move(larger));
+    index.store(indices.back().get(), memory_order_release);
+}
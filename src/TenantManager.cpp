@@ -0,0 +1,201 @@
+#include "TenantManager.h"
+#include "ConfigLoader.h"
+#include <iostream>
+
+using namespace std;
+
+//----------------------------------------------------------------
+//Tenant Class
+//----------------------------------------------------------------
+
+//An error loading the configuration goes to the tenant's output, like the errors of its commands
+Tenant::Tenant(const string &name, const string &configFilePath):
+    name(name),
+    simulation(),
+    output(),
+    commands(),
+    scheduled(false) {
+        simulation.setOutput(output);
+        if (!ConfigLoader::load(configFilePath, simulation))
+        {
+            output << "Error: could not open file " << configFilePath << endl;
+        }
+}
+
+const string &Tenant::getName() const {
+    return name;
+}
+
+Simulation &Tenant::getSimulation() {
+    return simulation;
+}
+
+//----------------------------------------------------------------
+//TenantManager Class
+//----------------------------------------------------------------
+
+TenantManager::TenantManager(ostream &sink, int numOfWorkers, int quantum):
+    sink(sink),
+    quantum(quantum < 1 ? 1 : quantum),
+    stopping(false),
+    pending(0) {
+        if (numOfWorkers < 1)
+        {
+            numOfWorkers = 1;
+        }
+        for (int i = 0; i < numOfWorkers; i++)
+        {
+            workers.push_back(thread(&TenantManager::work, this));
+        }
+}
+
+TenantManager::~TenantManager() {
+    shutdown();
+}
+
+bool TenantManager::addTenant(const string &name, const string &configFilePath) {
+    {
+        lock_guard<mutex> guard(lock);
+        if (tenants.count(name) != 0)
+        {
+            return false;
+        }
+    }
+    //Loading the configuration may take a while, so it is done without holding the lock
+    unique_ptr<Tenant> tenant(new Tenant(name, configFilePath));
+    lock_guard<mutex> guard(lock);
+    if (tenants.count(name) != 0)
+    {
+        return false;
+    }
+    map<string, FacilityCatalog>::iterator catalog = catalogs.find(configFilePath);
+    if (catalog == catalogs.end() || !tenant->simulation.shareFacilityOptions(catalog->second))
+    {
+        catalogs[configFilePath] = tenant->simulation.getFacilityOptions();
+    }
+    //No worker can take the tenant before it is added, so its output is published here
+    publish(*tenant);
+    tenants[name] = move(tenant);
+    return true;
+}
+
+bool TenantManager::isTenantExists(const string &name) {
+    lock_guard<mutex> guard(lock);
+    return tenants.count(name) != 0;
+}
+
+bool TenantManager::submit(const string &name, const string &command) {
+    lock_guard<mutex> guard(lock);
+    map<string, unique_ptr<Tenant>>::iterator it = tenants.find(name);
+    if (it == tenants.end() || stopping)
+    {
+        return false;
+    }
+    Tenant &tenant = *it->second;
+    tenant.commands.push_back(command);
+    pending++;
+    if (!tenant.scheduled)
+    {
+        tenant.scheduled = true;
+        runQueue.push_back(&tenant);
+        hasWork.notify_one();
+    }
+    return true;
+}
+
+void TenantManager::drain() {
+    unique_lock<mutex> guard(lock);
+    idle.wait(guard, [this] { return pending == 0; });
+}
+
+void TenantManager::shutdown() {
+    drain();
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    hasWork.notify_all();
+    for (thread &worker : workers)
+    {
+        if (worker.joinable())
+        {
+            worker.join();
+        }
+    }
+    workers.clear();
+}
+
+void TenantManager::work() {
+    unique_lock<mutex> guard(lock);
+    while (true)
+    {
+        hasWork.wait(guard, [this] { return stopping || !runQueue.empty(); });
+        if (runQueue.empty())
+        {
+            return;
+        }
+        Tenant &tenant = *runQueue.front();
+        runQueue.pop_front();
+        int executed = 0;
+        while (executed < quantum && !tenant.commands.empty())
+        {
+            string command = move(tenant.commands.front());
+            tenant.commands.pop_front();
+            guard.unlock();
+            if (tenant.simulation.isOpen())
+            {
+                tenant.simulation.execute(command);
+            }
+            else
+            {
+                tenant.output << "Error: Simulation is closed" << endl;
+            }
+            publish(tenant);
+            guard.lock();
+            executed++;
+        }
+        pending -= executed;
+        if (tenant.commands.empty())
+        {
+            tenant.scheduled = false;
+        }
+        else
+        {
+            runQueue.push_back(&tenant);
+            hasWork.notify_one();
+        }
+        if (pending == 0)
+        {
+            idle.notify_all();
+        }
+    }
+}
+
+//Copies the tenant's pending output to the shared sink, prefixing every line with the tenant name
+void TenantManager::publish(Tenant &tenant) {
+    const string rendered = tenant.output.str();
+    tenant.output.str("");
+    if (rendered.empty())
+    {
+        return;
+    }
+    string prefixed;
+    size_t begin = 0;
+    while (begin < rendered.size())
+    {
+        size_t end = rendered.find('\n', begin);
+        if (end == string::npos)
+        {
+            end = rendered.size() - 1;
+        }
+        prefixed += tenant.name + ": ";
+        prefixed.append(rendered, begin, end - begin + 1);
+        begin = end + 1;
+    }
+    if (prefixed[prefixed.size() - 1] != '\n')
+    {
+        prefixed += '\n';
+    }
+    lock_guard<mutex> guard(sinkLock);
+    sink << prefixed << flush;
+}
@@ -0,0 +1,310 @@
+#include "TimeSeries.h"
+#include "PlanStore.h"
+#include <cstring>
+
+using namespace std;
+
+static const char MAGIC[4] = {'S', 'P', 'T', 'S'};
+static const uint32_t VERSION = 2;
+
+static void putUint32(vector<unsigned char> &out, uint32_t value) {
+    for (int i = 0; i < 4; i++)
+    {
+        out.push_back((unsigned char)(value >> (8 * i)));
+    }
+}
+
+static uint32_t getUint32(const unsigned char *in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static void putVarint(vector<unsigned char> &out, int64_t value) {
+    uint64_t zigzag = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+    while (zigzag >= 0x80)
+    {
+        out.push_back((unsigned char)(zigzag | 0x80));
+        zigzag >>= 7;
+    }
+    out.push_back((unsigned char)zigzag);
+}
+
+static bool getVarint(const vector<unsigned char> &in, size_t &position, int64_t &value) {
+    uint64_t zigzag = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        if (position >= in.size())
+        {
+            return false;
+        }
+        unsigned char byte = in[position++];
+        zigzag |= (uint64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            value = (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+//----------------------------------------------------------------
+//TimeSeriesBlock Class
+//----------------------------------------------------------------
+
+TimeSeriesBlock::TimeSeriesBlock() {}
+
+void TimeSeriesBlock::append(const TimeSeriesRow &row) {
+    columns[0].push_back(row.tick);
+    columns[1].push_back(row.planId);
+    columns[2].push_back(row.lifeQualityScore);
+    columns[3].push_back(row.economyScore);
+    columns[4].push_back(row.environmentScore);
+    columns[5].push_back(row.activeConstructions);
+    columns[6].push_back(row.digest);
+}
+
+size_t TimeSeriesBlock::size() const {
+    return columns[0].size();
+}
+
+void TimeSeriesBlock::clear() {
+    for (vector<int64_t> &column : columns)
+    {
+        column.clear();
+    }
+}
+
+void TimeSeriesBlock::encode(vector<unsigned char> &payload) const {
+    payload.clear();
+    for (const vector<int64_t> &column : columns)
+    {
+        int64_t previous = 0;
+        for (int64_t value : column)
+        {
+            //Unsigned, so the difference of two digests wraps around rather than overflows
+            putVarint(payload, (int64_t)((uint64_t)value - (uint64_t)previous));
+            previous = value;
+        }
+    }
+}
+
+bool TimeSeriesBlock::decode(const vector<unsigned char> &payload, size_t numOfRows) {
+    clear();
+    size_t position = 0;
+    for (vector<int64_t> &column : columns)
+    {
+        int64_t previous = 0;
+        for (size_t i = 0; i < numOfRows; i++)
+        {
+            int64_t delta;
+            if (!getVarint(payload, position, delta))
+            {
+                return false;
+            }
+            previous = (int64_t)((uint64_t)previous + (uint64_t)delta);
+            column.push_back(previous);
+        }
+    }
+    return position == payload.size();
+}
+
+TimeSeriesRow TimeSeriesBlock::getRow(size_t index) const {
+    TimeSeriesRow row = {columns[0][index], columns[1][index], columns[2][index], columns[3][index], columns[4][index], columns[5][index], columns[6][index]};
+    return row;
+}
+
+//----------------------------------------------------------------
+//TimeSeriesRecorder Class
+//----------------------------------------------------------------
+
+TimeSeriesRecorder::TimeSeriesRecorder(const string &path):
+    file(path, ios::binary | ios::trunc),
+    current(),
+    pending(),
+    spare(),
+    closing(false),
+    failed(false) {
+        if (!file.is_open())
+        {
+            return;
+        }
+        vector<unsigned char> header(MAGIC, MAGIC + 4);
+        putUint32(header, VERSION);
+        if (!file.write((const char*)header.data(), header.size()))
+        {
+            file.close();
+            return;
+        }
+        writer = thread(&TimeSeriesRecorder::write, this);
+}
+
+TimeSeriesRecorder::~TimeSeriesRecorder() {
+    close();
+}
+
+bool TimeSeriesRecorder::isOpen() const {
+    return file.is_open();
+}
+
+//Returns false once the writer failed to write a block
+bool TimeSeriesRecorder::record(int tick, const PlanStore &plans) {
+    if (!writer.joinable() || failed.load(memory_order_relaxed))
+    {
+        return false;
+    }
+    for (const Plan &plan : plans)
+    {
+        TimeSeriesRow row = {
+            tick,
+            plan.getPlanId(),
+            plan.getlifeQualityScore(),
+            plan.getEconomyScore(),
+            plan.getEnvironmentScore(),
+            (int64_t)plan.getUnderConstructionFacilities().size(),
+            (int64_t)plan.getDigest()};
+        current.append(row);
+        if (current.size() >= BLOCK_ROWS)
+        {
+            submit();
+        }
+    }
+    return !failed.load(memory_order_relaxed);
+}
+
+//Hands the current block to the writer, waiting while too many blocks are already pending
+void TimeSeriesRecorder::submit() {
+    unique_lock<mutex> guard(lock);
+    hasRoom.wait(guard, [this] { return pending.size() < MAX_PENDING_BLOCKS; });
+    pending.push_back(move(current));
+    if (spare.empty())
+    {
+        current = TimeSeriesBlock();
+    }
+    else
+    {
+        current = move(spare.back());
+        spare.pop_back();
+    }
+    current.clear();
+    hasBlocks.notify_one();
+}
+
+//Writes the rows left and closes the file, returns false if any of the series could not be written
+bool TimeSeriesRecorder::close() {
+    if (!writer.joinable())
+    {
+        return !failed.load(memory_order_relaxed);
+    }
+    if (current.size() > 0)
+    {
+        submit();
+    }
+    {
+        lock_guard<mutex> guard(lock);
+        closing = true;
+    }
+    hasBlocks.notify_one();
+    writer.join();
+    file.close();
+    if (file.fail())
+    {
+        failed.store(true, memory_order_relaxed);
+    }
+    return !failed.load(memory_order_relaxed);
+}
+
+void TimeSeriesRecorder::write() {
+    vector<unsigned char> payload;
+    vector<unsigned char> blockHeader;
+    unique_lock<mutex> guard(lock);
+    while (true)
+    {
+        hasBlocks.wait(guard, [this] { return closing || !pending.empty(); });
+        if (pending.empty())
+        {
+            break;
+        }
+        TimeSeriesBlock block = move(pending.front());
+        pending.pop_front();
+        guard.unlock();
+        //After a failed write the remaining blocks are dropped, so the simulation never waits on a broken file
+        if (!failed.load(memory_order_relaxed))
+        {
+            block.encode(payload);
+            blockHeader.clear();
+            putUint32(blockHeader, block.size());
+            putUint32(blockHeader, payload.size());
+            file.write((const char*)blockHeader.data(), blockHeader.size());
+            file.write((const char*)payload.data(), payload.size());
+            if (!file)
+            {
+                failed.store(true, memory_order_relaxed);
+            }
+        }
+        guard.lock();
+        if (spare.size() < MAX_PENDING_BLOCKS)
+        {
+            spare.push_back(move(block));
+        }
+        hasRoom.notify_one();
+    }
+    if (!file.flush())
+    {
+        failed.store(true, memory_order_relaxed);
+    }
+}
+
+//----------------------------------------------------------------
+//TimeSeriesReader Class
+//----------------------------------------------------------------
+
+TimeSeriesReader::TimeSeriesReader(const string &path): file(path, ios::binary), valid(false), block(), position(0) {
+    unsigned char header[8];
+    if (file.read((char*)header, sizeof(header)) && memcmp(header, MAGIC, 4) == 0 && getUint32(header + 4) == VERSION)
+    {
+        valid = true;
+    }
+}
+
+bool TimeSeriesReader::isOpen() const {
+    return valid;
+}
+
+bool TimeSeriesReader::next(TimeSeriesRow &row) {
+    while (valid && position >= block.size())
+    {
+        if (!readBlock())
+        {
+            valid = false;
+        }
+    }
+    if (!valid)
+    {
+        return false;
+    }
+    row = block.getRow(position++);
+    return true;
+}
+
+bool TimeSeriesReader::readBlock() {
+    unsigned char blockHeader[8];
+    if (!file.read((char*)blockHeader, sizeof(blockHeader)))
+    {
+        return false;
+    }
+    //The recorder writes at most BLOCK_ROWS rows a block and no value takes more than MAX_VALUE_BYTES,
+    //a larger block is corrupt and is not allocated
+    const size_t numOfRows = getUint32(blockHeader);
+    const size_t payloadSize = getUint32(blockHeader + 4);
+    if (numOfRows > TimeSeriesRecorder::BLOCK_ROWS || payloadSize > numOfRows * TimeSeriesBlock::NUM_OF_COLUMNS * TimeSeriesBlock::MAX_VALUE_BYTES)
+    {
+        return false;
+    }
+    vector<unsigned char> payload(payloadSize);
+    if (!file.read((char*)payload.data(), payload.size()))
+    {
+        return false;
+    }
+    position = 0;
+    return block.decode(payload, numOfRows);
+}
@@ -0,0 +1,212 @@
+#include "Tracer.h"
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+
+struct TraceEvent {
+    const char *name;
+    uint64_t begin;
+    uint64_t end;
+    int64_t value;
+};
+
+//The events of one thread, in chunks that are never freed or moved. Only the owning thread
+//appends, and it publishes every event by storing the new size, so the writer of the trace reads
+//the first 'size' events without locking. When the owner starts over for a new trace it clears
+//the size before it publishes the new epoch, so a writer that sees the epoch never reads the
+//events being overwritten.
+//A thread that exits hands its buffer on to the next thread that records, keeping its events.
+struct TraceBuffer {
+    static const size_t CHUNK_EVENTS = 4096;
+    struct Chunk {
+        Chunk(): next(nullptr) {}
+        TraceEvent events[CHUNK_EVENTS];
+        atomic<Chunk*> next;
+    };
+
+    TraceBuffer(int threadId): head(new Chunk), tail(head), size(0), epoch(0), threadId(threadId) {}
+
+    Chunk *const head;
+    Chunk *tail;
+    atomic<size_t> size;
+    atomic<unsigned> epoch; //The trace the events belong to, older events are dropped when the next one starts
+    const int threadId;
+};
+
+atomic<int> Tracer::enabledLevel(Tracer::OFF);
+
+static mutex traceMutex; //Guards everything below but the events themselves
+static vector<TraceBuffer*> buffers;
+static vector<TraceBuffer*> freeBuffers; //Of threads that have exited
+static unordered_set<string> names;
+static atomic<unsigned> currentEpoch(0);
+static ofstream traceFile;
+static uint64_t traceStart = 0;
+
+//Returns the thread's buffer for reuse when the thread exits
+struct ThreadBuffer {
+    ~ThreadBuffer() {
+        if (buffer != nullptr)
+        {
+            lock_guard<mutex> lock(traceMutex);
+            freeBuffers.push_back(buffer);
+            buffer = nullptr;
+        }
+    }
+    TraceBuffer *buffer;
+};
+static thread_local ThreadBuffer threadBuffer = {nullptr};
+
+//Writes the trace if the process ends while tracing
+static struct TraceFinisher {
+    ~TraceFinisher() {
+        Tracer::stop();
+    }
+} finisher;
+
+static void writeString(ostream &out, const char *text) {
+    out << '"';
+    for (const char *c = text; *c != '\0'; c++)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            out << '\\';
+        }
+        out << *c;
+    }
+    out << '"';
+}
+
+static void writeTrace(ostream &out, unsigned epoch) {
+    out << fixed << setprecision(3);
+    out << "{\"traceEvents\":[\n";
+    bool first = true;
+    for (TraceBuffer *buffer : buffers)
+    {
+        out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId
+            << ",\"args\":{\"name\":\"thread " << buffer->threadId << "\"}}";
+        first = false;
+        if (buffer->epoch.load(memory_order_acquire) != epoch)
+        {
+            continue;
+        }
+        const size_t size = buffer->size.load(memory_order_acquire);
+        const TraceBuffer::Chunk *chunk = buffer->head;
+        for (size_t i = 0; i < size; i++)
+        {
+            if (i > 0 && i % TraceBuffer::CHUNK_EVENTS == 0)
+            {
+                chunk = chunk->next.load(memory_order_acquire);
+            }
+            const TraceEvent &event = chunk->events[i % TraceBuffer::CHUNK_EVENTS];
+            if (event.begin < traceStart)
+            {
+                continue;
+            }
+            out << ",\n{\"name\":";
+            writeString(out, event.name);
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId
+                << ",\"ts\":" << (event.begin - traceStart) / 1000.0 << ",\"dur\":" << (event.end - event.begin) / 1000.0;
+            if (event.value >= 0)
+            {
+                out << ",\"args\":{\"value\":" << event.value << '}';
+            }
+            out << '}';
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+}
+
+//Starts a new trace to be written to 'path', writing the current one first
+bool Tracer::start(const string &path, Level level) {
+    if (level == OFF)
+    {
+        return false;
+    }
+    stop();
+    lock_guard<mutex> lock(traceMutex);
+    traceFile.open(path);
+    if (!traceFile.is_open())
+    {
+        return false;
+    }
+    currentEpoch.fetch_add(1, memory_order_release);
+    traceStart = now();
+    enabledLevel.store(level, memory_order_relaxed);
+    return true;
+}
+
+//Stops tracing and writes the trace, returns false if there was no trace or it could not be written
+bool Tracer::stop() {
+    lock_guard<mutex> lock(traceMutex);
+    if (enabledLevel.load(memory_order_relaxed) == OFF)
+    {
+        return false;
+    }
+    enabledLevel.store(OFF, memory_order_relaxed);
+    writeTrace(traceFile, currentEpoch.load(memory_order_relaxed));
+    traceFile.close();
+    const bool written = !traceFile.fail();
+    traceFile.clear();
+    return written;
+}
+
+uint64_t Tracer::now() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Tracer::record(const char *name, uint64_t begin, uint64_t end, int64_t value) {
+    TraceBuffer *buffer = threadBuffer.buffer;
+    if (buffer == nullptr)
+    {
+        lock_guard<mutex> lock(traceMutex);
+        if (!freeBuffers.empty())
+        {
+            buffer = freeBuffers.back();
+            freeBuffers.pop_back();
+        }
+        else
+        {
+            buffer = new TraceBuffer(buffers.size() + 1);
+            buffers.push_back(buffer);
+        }
+        threadBuffer.buffer = buffer;
+    }
+    size_t index = buffer->size.load(memory_order_relaxed);
+    const unsigned epoch = currentEpoch.load(memory_order_acquire);
+    if (buffer->epoch.load(memory_order_relaxed) != epoch)
+    {
+        buffer->size.store(0, memory_order_relaxed);
+        buffer->epoch.store(epoch, memory_order_release);
+        buffer->tail = buffer->head;
+        index = 0;
+    }
+    const size_t offset = index % TraceBuffer::CHUNK_EVENTS;
+    if (offset == 0 && index > 0)
+    {
+        TraceBuffer::Chunk *next = buffer->tail->next.load(memory_order_relaxed);
+        if (next == nullptr)
+        {
+            next = new TraceBuffer::Chunk();
+            buffer->tail->next.store(next, memory_order_release);
+        }
+        buffer->tail = next;
+    }
+    TraceEvent &event = buffer->tail->events[offset];
+    event.name = name;
+    event.begin = begin;
+    event.end = end;
+    event.value = value;
+    buffer->size.store(index + 1, memory_order_release);
+}
+
+//Returns a copy of 'name' that lives as long as the process, for span names built at run time
+const char *Tracer::intern(const string &name) {
+    lock_guard<mutex> lock(traceMutex);
+    return names.insert(name).first->c_str();
+}
@@ -1,22 +1,155 @@
-#include "Simulation.h"
+#include "SPLand.h"
+#include "AllocationCounter.h"
+#include "ConfigImage.h"
+#include "TenantManager.h"
+#include "TimeSeries.h"
+#include "Auxiliary.h"
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <thread>
 
 using namespace std;
 
-Simulation* backup = nullptr;
+static void printUsage() {
+    cout << "usage: simulation <config_path>" << endl;
+    cout << "       simulation --tenants [workers]" << endl;
+    cout << "       simulation --dump-series <series_path>" << endl;
+    cout << "       simulation compile-config <config_path> <image_path>" << endl;
+    cout << "       simulation --plan-store <store_path> <config_path>" << endl;
+}
+
+//A number of worker threads, a positive number and nothing else
+static bool parseWorkers(const string &text, int &numOfWorkers) {
+    istringstream iss(text);
+    int value;
+    char extra;
+    if(!(iss >> value) || iss >> extra || value < 1){
+        return false;
+    }
+    numOfWorkers = value;
+    return true;
+}
+
+//Fails the run when a command went over its allocation budget, which only a counting build checks
+static int exitStatus() {
+    return AllocationCounter::wasExceeded() ? 1 : 0;
+}
+
+/*
+Serves many simulations from one process. Every input line is either
+    tenant <name> <config_path>
+which creates a new tenant, or
+    <name> <action ...>
+which queues the action for that tenant. Output lines are prefixed with the tenant name.
+*/
+static int runTenants(int numOfWorkers) {
+    TenantManager manager(cout, numOfWorkers, 16);
+    string line;
+    while (getline(cin, line))
+    {
+        vector<string> arguments = Auxiliary::parseArguments(line);
+        if (arguments.empty())
+        {
+            continue;
+        }
+        if (arguments[0] == "tenant")
+        {
+            if (arguments.size() != 3 || !manager.addTenant(arguments[1], arguments[2]))
+            {
+                cerr << "Error: cannot create tenant" << endl;
+            }
+            continue;
+        }
+        size_t actionStart = line.find(arguments[0]) + arguments[0].size();
+        if (!manager.submit(arguments[0], line.substr(actionStart)))
+        {
+            cerr << "Error: tenant " << arguments[0] << " does not exist" << endl;
+        }
+    }
+    manager.shutdown();
+    return exitStatus();
+}
+
+//Prints a recorded time series as CSV
+static int dumpSeries(const string &path) {
+    TimeSeriesReader reader(path);
+    if (!reader.isOpen())
+    {
+        cerr << "Error: could not read time series " << path << endl;
+        return 1;
+    }
+    cout << "tick,plan_id,life_quality_score,economy_score,environment_score,active_constructions,digest\n";
+    TimeSeriesRow row;
+    while (reader.next(row))
+    {
+        cout << row.tick << ',' << row.planId << ',' << row.lifeQualityScore << ',' << row.economyScore << ','
+             << row.environmentScore << ',' << row.activeConstructions << ','
+             << hex << setw(16) << setfill('0') << (uint64_t)row.digest << dec << setfill(' ') << '\n';
+    }
+    return 0;
+}
+
+//Runs a simulation whose plans are kept in a record file from the start, so the configuration may
+//hold more plans than fit in memory
+static int runWithPlanStore(const string &storePath, const string &configurationFile) {
+    SPLand spland;
+    if(!spland.spill(storePath)){
+        cerr << "Error: could not create plan store " << storePath << endl;
+        return 1;
+    }
+    if(!spland.loadConfig(configurationFile)){
+        cerr << "Error: could not open file " << configurationFile << endl;
+        return 1;
+    }
+    spland.run();
+    return exitStatus();
+}
 
 int main(int argc, char** argv){
+    if(argc == 3 && string(argv[1]) == "--dump-series"){
+        return dumpSeries(argv[2]);
+    }
+    if((argc == 2 || argc == 3) && string(argv[1]) == "--tenants"){
+        int numOfWorkers = (int)thread::hardware_concurrency();
+        if(argc == 3 && !parseWorkers(argv[2], numOfWorkers)){
+            printUsage();
+            return 1;
+        }
+        return runTenants(numOfWorkers);
+    }
+    if(argc == 4 && string(argv[1]) == "compile-config"){
+        return ConfigImage::compile(argv[2], argv[3]) ? 0 : 1;
+    }
+    if(argc == 4 && string(argv[1]) == "--plan-store"){
+        return runWithPlanStore(argv[2], argv[3]);
+    }
     if(argc!=2){
-        cout << "usage: simulation <config_path>" << endl;
+        printUsage();
         return 0;
     }
     string configurationFile = argv[1];
-    Simulation simulation(configurationFile);
-    simulation.start();
-    if(backup!=nullptr){
-    	delete backup;
-    	backup = nullptr;
+    SPLand spland;
+    if(ConfigImage::isImage(configurationFile)){
+        ConfigImage image;
+        if(!image.open(configurationFile)){
+            cerr << "Error: could not read image " << configurationFile << endl;
+            return 1;
+        }
+        if(image.isStale()){
+            cerr << "Warning: image is out of date, reading " << image.getSourcePath() << " instead" << endl;
+            configurationFile = image.getSourcePath();
+        }
+        else{
+            spland.loadImage(image);
+            spland.run();
+            return exitStatus();
+        }
     }
-    return 0;
-}
\ No newline at end of file
+    if(!spland.loadConfig(configurationFile)){
+        cerr << "Error: could not open file " << configurationFile << endl;
+    }
+    spland.run();
+    return exitStatus();
+}